@@ -0,0 +1,117 @@
+#ifndef WLED_NATIVE_ARDUINO_H
+#define WLED_NATIVE_ARDUINO_H
+
+/*
+ * Minimal Arduino core for the native test env (see platformio.ini [env:native])
+ * Only what FX.cpp, FX_fcn.cpp, colors.cpp and snapshot.cpp need. millis() is a fake clock advanced by the tests,
+ * micros() is the real monotonic clock so benchmarks can time service().
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <chrono>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+#define FPSTR(p) (p)
+#define IRAM_ATTR
+#define pgm_read_byte(addr)  (*(const uint8_t*)(addr))
+#define pgm_read_word(addr)  (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(addr)) //also used for pointer tables, which are 64 bit on the host
+#define pgm_read_ptr(addr)   (*(void* const*)(addr))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define __FlashStringHelper char
+
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = (len < size) ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define LOW  0
+#define HIGH 1
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+
+using std::min;
+using std::max;
+using std::abs;
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define sq(x) ((x)*(x))
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  if (in_max == in_min) return out_min; //the ESP cores return early instead of dividing by 0
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+//fake clock, advanced by the tests so frames are reproducible
+inline uint32_t nativeMillis = 0;
+inline uint32_t millis() { return nativeMillis; }
+inline uint32_t micros() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+inline void delay(uint32_t ms) { nativeMillis += ms; }
+inline void yield() {}
+
+//the ESPs use the hardware RNG, this one repeats after randomSeed()
+inline uint32_t nativeRandomState = 1;
+inline void randomSeed(unsigned long seed) { if (seed) nativeRandomState = seed; }
+inline long random(long howbig) {
+  if (howbig <= 0) return 0;
+  nativeRandomState = nativeRandomState * 1103515245 + 12345;
+  return (nativeRandomState >> 1) % howbig;
+}
+inline long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+struct NativeEsp {
+  uint32_t heapSize = 0x40000000;
+  //free heap from the host allocator, only differences between two calls are meaningful
+  uint32_t getFreeHeap() {
+    #ifdef __GLIBC__
+    struct mallinfo2 mi = mallinfo2();
+    return (mi.uordblks < heapSize) ? heapSize - mi.uordblks : 0;
+    #else
+    return heapSize;
+    #endif
+  }
+  uint32_t getCycleCount() { return micros() * 240; }
+};
+inline NativeEsp ESP;
+
+#endif
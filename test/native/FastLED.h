@@ -0,0 +1,744 @@
+#ifndef WLED_NATIVE_FASTLED_H
+#define WLED_NATIVE_FASTLED_H
+
+/*
+ * FastLED subset for the native test env
+ * The math follows the portable C paths of FastLED 3.5.0 (FASTLED_SCALE8_FIXED, FASTLED_BLEND_FIXED
+ * and FASTLED_NOISE_FIXED all 1, as on the ESPs), so effects compute the same values as on the device.
+ * Only what FX.cpp, FX_fcn.cpp and colors.cpp use is here, there is no LED output.
+ */
+
+#include "Arduino.h"
+
+typedef uint8_t  fract8;
+typedef uint16_t fract16;
+typedef uint16_t accum88;
+typedef int16_t  saccum87;
+
+#ifdef USE_GET_MILLISECOND_TIMER
+inline uint32_t get_millisecond_timer(); //defined with the globals in wled_native.h
+#define GET_MILLIS get_millisecond_timer
+#else
+#define GET_MILLIS millis
+#endif
+
+// lib8tion: 8 and 16 bit math
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) { unsigned t = i + j; return t > 255 ? 255 : t; }
+inline uint8_t qsub8(uint8_t i, uint8_t j) { int t = i - j; return t < 0 ? 0 : t; }
+inline int8_t  qadd7(int8_t i, int8_t j) { int t = i + j; return t > 127 ? 127 : t; }
+inline int8_t  avg7(int8_t i, int8_t j) { return (i >> 1) + (j >> 1) + (i & 0x1); }
+inline int16_t avg15(int16_t i, int16_t j) { return (i >> 1) + (j >> 1) + (i & 0x1); }
+
+inline uint8_t scale8(uint8_t i, fract8 scale) { return (((uint16_t)i) * (1 + (uint16_t)scale)) >> 8; }
+inline uint8_t scale8_video(uint8_t i, fract8 scale) { return (((int)i * (int)scale) >> 8) + ((i && scale) ? 1 : 0); }
+inline uint16_t scale16(uint16_t i, fract16 scale) { return ((uint32_t)i * (1 + (uint32_t)scale)) / 65536; }
+inline uint16_t scale16by8(uint16_t i, fract8 scale) { return (i * (1 + ((uint16_t)scale))) >> 8; }
+
+inline void nscale8x3(uint8_t& r, uint8_t& g, uint8_t& b, fract8 scale) {
+  uint16_t scale_fixed = scale + 1;
+  r = (((uint16_t)r) * scale_fixed) >> 8;
+  g = (((uint16_t)g) * scale_fixed) >> 8;
+  b = (((uint16_t)b) * scale_fixed) >> 8;
+}
+inline void nscale8x3_video(uint8_t& r, uint8_t& g, uint8_t& b, fract8 scale) {
+  uint8_t nonzeroscale = (scale != 0) ? 1 : 0;
+  r = (r == 0) ? 0 : (((int)r * (int)scale) >> 8) + nonzeroscale;
+  g = (g == 0) ? 0 : (((int)g * (int)scale) >> 8) + nonzeroscale;
+  b = (b == 0) ? 0 : (((int)b * (int)scale) >> 8) + nonzeroscale;
+}
+
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+  uint16_t partial = (a << 8) | b;
+  partial += (b * amountOfB);
+  partial -= (a * amountOfB);
+  return partial >> 8;
+}
+
+inline int16_t lerp15by16(int16_t a, int16_t b, fract16 frac) {
+  if (b > a) return a + scale16(b - a, frac);
+  return a - scale16(a - b, frac);
+}
+inline int8_t lerp7by8(int8_t a, int8_t b, fract8 frac) {
+  if (b > a) return a + scale8(b - a, frac);
+  return a - scale8(a - b, frac);
+}
+
+inline uint8_t ease8InOutQuad(uint8_t i) {
+  uint8_t j = i;
+  if (j & 0x80) j = 255 - j;
+  uint8_t jj2 = scale8(j, j) << 1;
+  if (i & 0x80) jj2 = 255 - jj2;
+  return jj2;
+}
+inline uint8_t ease8InOutCubic(fract8 i) {
+  uint8_t ii = scale8(i, i);
+  uint8_t iii = scale8(ii, i);
+  uint16_t r1 = (3 * (uint16_t)ii) - (2 * (uint16_t)iii);
+  return (r1 & 0x100) ? 255 : r1;
+}
+inline uint16_t ease16InOutQuad(uint16_t i) {
+  uint16_t j = i;
+  if (j & 0x8000) j = 65535 - j;
+  uint16_t jj2 = scale16(j, j) << 1;
+  if (i & 0x8000) jj2 = 65535 - jj2;
+  return jj2;
+}
+
+inline uint8_t triwave8(uint8_t in) {
+  if (in & 0x80) in = 255 - in;
+  return in << 1;
+}
+inline uint8_t quadwave8(uint8_t in) { return ease8InOutQuad(triwave8(in)); }
+inline uint8_t cubicwave8(uint8_t in) { return ease8InOutCubic(triwave8(in)); }
+
+inline int16_t sin16(uint16_t theta) {
+  static const uint16_t base[] = { 0, 6393, 12539, 18204, 23170, 27245, 30273, 32137 };
+  static const uint8_t slope[] = { 49, 48, 44, 38, 31, 23, 14, 4 };
+  uint16_t offset = (theta & 0x3FFF) >> 3; // 0..2047
+  if (theta & 0x4000) offset = 2047 - offset;
+  uint8_t section = offset / 256; // 0..7
+  uint8_t secoffset8 = (uint8_t)(offset) / 2;
+  uint16_t mx = slope[section] * secoffset8;
+  int16_t y = mx + base[section];
+  if (theta & 0x8000) y = -y;
+  return y;
+}
+inline int16_t cos16(uint16_t theta) { return sin16(theta + 16384); }
+
+inline uint8_t sin8(uint8_t theta) {
+  static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
+  uint8_t offset = theta;
+  if (theta & 0x40) offset = (uint8_t)255 - offset;
+  offset &= 0x3F; // 0..63
+  uint8_t secoffset = offset & 0x0F; // 0..15
+  if (theta & 0x40) ++secoffset;
+  uint8_t s2 = (offset >> 4) * 2;
+  uint8_t b   = b_m16_interleave[s2];
+  uint8_t m16 = b_m16_interleave[s2 + 1];
+  uint8_t mx = (m16 * secoffset) >> 4;
+  int8_t y = mx + b;
+  if (theta & 0x80) y = -y;
+  y += 128;
+  return y;
+}
+inline uint8_t cos8(uint8_t theta) { return sin8(theta + 64); }
+
+// random numbers, 16 bit LCG shared by random8() and random16()
+
+inline uint16_t rand16seed = 1337;
+inline uint8_t random8() {
+  rand16seed = (rand16seed * 2053) + 13849;
+  return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) + ((uint8_t)(rand16seed >> 8)));
+}
+inline uint16_t random16() {
+  rand16seed = (rand16seed * 2053) + 13849;
+  return rand16seed;
+}
+inline uint8_t random8(uint8_t lim) { return (random8() * lim) >> 8; }
+inline uint8_t random8(uint8_t min, uint8_t lim) { return random8(lim - min) + min; }
+inline uint16_t random16(uint16_t lim) { return ((uint32_t)lim * (uint32_t)random16()) >> 16; }
+inline uint16_t random16(uint16_t min, uint16_t lim) { return random16(lim - min) + min; }
+inline void random16_set_seed(uint16_t seed) { rand16seed = seed; }
+inline uint16_t random16_get_seed() { return rand16seed; }
+inline void random16_add_entropy(uint16_t entropy) { rand16seed += entropy; }
+
+// beat generators, timed by GET_MILLIS()
+
+inline uint16_t beat88(accum88 beats_per_minute_88, uint32_t timebase = 0) {
+  return ((GET_MILLIS() - timebase) * beats_per_minute_88 * 280) >> 16;
+}
+inline uint16_t beat16(accum88 beats_per_minute, uint32_t timebase = 0) {
+  if (beats_per_minute < 256) beats_per_minute <<= 8;
+  return beat88(beats_per_minute, timebase);
+}
+inline uint8_t beat8(accum88 beats_per_minute, uint32_t timebase = 0) {
+  return beat16(beats_per_minute, timebase) >> 8;
+}
+inline uint16_t beatsin88(accum88 beats_per_minute_88, uint16_t lowest = 0, uint16_t highest = 65535, uint32_t timebase = 0, uint16_t phase_offset = 0) {
+  uint16_t beatsin = sin16(beat88(beats_per_minute_88, timebase) + phase_offset) + 32768;
+  return lowest + scale16(beatsin, highest - lowest);
+}
+inline uint16_t beatsin16(accum88 beats_per_minute, uint16_t lowest = 0, uint16_t highest = 65535, uint32_t timebase = 0, uint16_t phase_offset = 0) {
+  uint16_t beatsin = sin16(beat16(beats_per_minute, timebase) + phase_offset) + 32768;
+  return lowest + scale16(beatsin, highest - lowest);
+}
+inline uint8_t beatsin8(accum88 beats_per_minute, uint8_t lowest = 0, uint8_t highest = 255, uint32_t timebase = 0, uint8_t phase_offset = 0) {
+  uint8_t beatsin = sin8(beat8(beats_per_minute, timebase) + phase_offset);
+  return lowest + scale8(beatsin, highest - lowest);
+}
+
+// colors
+
+struct CRGB;
+inline void hsv2rgb_rainbow(const struct CHSV& hsv, CRGB& rgb);
+
+struct CHSV {
+  union {
+    struct {
+      union { uint8_t hue; uint8_t h; };
+      union { uint8_t saturation; uint8_t sat; uint8_t s; };
+      union { uint8_t value; uint8_t val; uint8_t v; };
+    };
+    uint8_t raw[3];
+  };
+  CHSV() {}
+  CHSV(uint8_t ih, uint8_t is, uint8_t iv) : h(ih), s(is), v(iv) {}
+};
+
+struct CRGB {
+  union {
+    struct {
+      union { uint8_t r; uint8_t red; };
+      union { uint8_t g; uint8_t green; };
+      union { uint8_t b; uint8_t blue; };
+    };
+    uint8_t raw[3];
+  };
+
+  CRGB() {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+  CRGB(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); }
+
+  inline uint8_t& operator[](uint8_t x) { return raw[x]; }
+  inline const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+
+  inline CRGB& operator=(uint32_t colorcode) { r = (colorcode >> 16) & 0xFF; g = (colorcode >> 8) & 0xFF; b = colorcode & 0xFF; return *this; }
+  inline CRGB& operator=(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); return *this; }
+  inline CRGB& setRGB(uint8_t nr, uint8_t ng, uint8_t nb) { r = nr; g = ng; b = nb; return *this; }
+  inline CRGB& setHSV(uint8_t hue, uint8_t sat, uint8_t val) { hsv2rgb_rainbow(CHSV(hue, sat, val), *this); return *this; }
+  inline CRGB& setHue(uint8_t hue) { hsv2rgb_rainbow(CHSV(hue, 255, 255), *this); return *this; }
+
+  inline CRGB& operator+=(const CRGB& rhs) { r = qadd8(r, rhs.r); g = qadd8(g, rhs.g); b = qadd8(b, rhs.b); return *this; }
+  inline CRGB& operator-=(const CRGB& rhs) { r = qsub8(r, rhs.r); g = qsub8(g, rhs.g); b = qsub8(b, rhs.b); return *this; }
+  inline CRGB& operator|=(const CRGB& rhs) { if (rhs.r > r) r = rhs.r; if (rhs.g > g) g = rhs.g; if (rhs.b > b) b = rhs.b; return *this; }
+  inline CRGB& operator%=(uint8_t scaledown) { nscale8x3_video(r, g, b, scaledown); return *this; }
+  inline CRGB& nscale8_video(uint8_t scaledown) { nscale8x3_video(r, g, b, scaledown); return *this; }
+  inline CRGB& nscale8(uint8_t scaledown) { nscale8x3(r, g, b, scaledown); return *this; }
+  inline CRGB& fadeToBlackBy(uint8_t fadefactor) { nscale8x3(r, g, b, 255 - fadefactor); return *this; }
+  inline CRGB& fadeLightBy(uint8_t fadefactor) { nscale8x3_video(r, g, b, 255 - fadefactor); return *this; }
+  inline uint8_t getAverageLight() const { return scale8(r, 85) + scale8(g, 85) + scale8(b, 85); }
+  inline explicit operator bool() const { return r || g || b; }
+
+  typedef enum {
+    AliceBlue=0xF0F8FF, Amethyst=0x9966CC, AntiqueWhite=0xFAEBD7, Aqua=0x00FFFF, Aquamarine=0x7FFFD4, Azure=0xF0FFFF,
+    Beige=0xF5F5DC, Bisque=0xFFE4C4, Black=0x000000, BlanchedAlmond=0xFFEBCD, Blue=0x0000FF, BlueViolet=0x8A2BE2,
+    Brown=0xA52A2A, BurlyWood=0xDEB887, CadetBlue=0x5F9EA0, Chartreuse=0x7FFF00, Chocolate=0xD2691E, Coral=0xFF7F50,
+    CornflowerBlue=0x6495ED, Cornsilk=0xFFF8DC, Crimson=0xDC143C, Cyan=0x00FFFF, DarkBlue=0x00008B, DarkCyan=0x008B8B,
+    DarkGoldenrod=0xB8860B, DarkGray=0xA9A9A9, DarkGreen=0x006400, DarkKhaki=0xBDB76B, DarkMagenta=0x8B008B,
+    DarkOliveGreen=0x556B2F, DarkOrange=0xFF8C00, DarkOrchid=0x9932CC, DarkRed=0x8B0000, DarkSalmon=0xE9967A,
+    DarkSeaGreen=0x8FBC8F, DarkSlateBlue=0x483D8B, DarkSlateGray=0x2F4F4F, DarkTurquoise=0x00CED1, DarkViolet=0x9400D3,
+    DeepPink=0xFF1493, DeepSkyBlue=0x00BFFF, DimGray=0x696969, DodgerBlue=0x1E90FF, FireBrick=0xB22222,
+    FloralWhite=0xFFFAF0, ForestGreen=0x228B22, Fuchsia=0xFF00FF, Gainsboro=0xDCDCDC, GhostWhite=0xF8F8FF,
+    Gold=0xFFD700, Goldenrod=0xDAA520, Gray=0x808080, Green=0x008000, GreenYellow=0xADFF2F, Honeydew=0xF0FFF0,
+    HotPink=0xFF69B4, IndianRed=0xCD5C5C, Indigo=0x4B0082, Ivory=0xFFFFF0, Khaki=0xF0E68C, Lavender=0xE6E6FA,
+    LavenderBlush=0xFFF0F5, LawnGreen=0x7CFC00, LemonChiffon=0xFFFACD, LightBlue=0xADD8E6, LightCoral=0xF08080,
+    LightCyan=0xE0FFFF, LightGoldenrodYellow=0xFAFAD2, LightGreen=0x90EE90, LightGrey=0xD3D3D3, LightPink=0xFFB6C1,
+    LightSalmon=0xFFA07A, LightSeaGreen=0x20B2AA, LightSkyBlue=0x87CEFA, LightSlateGray=0x778899,
+    LightSteelBlue=0xB0C4DE, LightYellow=0xFFFFE0, Lime=0x00FF00, LimeGreen=0x32CD32, Linen=0xFAF0E6,
+    Magenta=0xFF00FF, Maroon=0x800000, MediumAquamarine=0x66CDAA, MediumBlue=0x0000CD, MediumOrchid=0xBA55D3,
+    MediumPurple=0x9370DB, MediumSeaGreen=0x3CB371, MediumSlateBlue=0x7B68EE, MediumSpringGreen=0x00FA9A,
+    MediumTurquoise=0x48D1CC, MediumVioletRed=0xC71585, MidnightBlue=0x191970, MintCream=0xF5FFFA,
+    MistyRose=0xFFE4E1, Moccasin=0xFFE4B5, NavajoWhite=0xFFDEAD, Navy=0x000080, OldLace=0xFDF5E6, Olive=0x808000,
+    OliveDrab=0x6B8E23, Orange=0xFFA500, OrangeRed=0xFF4500, Orchid=0xDA70D6, PaleGoldenrod=0xEEE8AA,
+    PaleGreen=0x98FB98, PaleTurquoise=0xAFEEEE, PaleVioletRed=0xDB7093, PapayaWhip=0xFFEFD5, PeachPuff=0xFFDAB9,
+    Peru=0xCD853F, Pink=0xFFC0CB, Plaid=0xCC5533, Plum=0xDDA0DD, PowderBlue=0xB0E0E6, Purple=0x800080,
+    Red=0xFF0000, RosyBrown=0xBC8F8F, RoyalBlue=0x4169E1, SaddleBrown=0x8B4513, Salmon=0xFA8072,
+    SandyBrown=0xF4A460, SeaGreen=0x2E8B57, Seashell=0xFFF5EE, Sienna=0xA0522D, Silver=0xC0C0C0, SkyBlue=0x87CEEB,
+    SlateBlue=0x6A5ACD, SlateGray=0x708090, Snow=0xFFFAFA, SpringGreen=0x00FF7F, SteelBlue=0x4682B4, Tan=0xD2B48C,
+    Teal=0x008080, Thistle=0xD8BFD8, Tomato=0xFF6347, Turquoise=0x40E0D0, Violet=0xEE82EE, Wheat=0xF5DEB3,
+    White=0xFFFFFF, WhiteSmoke=0xF5F5F5, Yellow=0xFFFF00, YellowGreen=0x9ACD32
+  } HTMLColorCode;
+};
+
+inline bool operator==(const CRGB& lhs, const CRGB& rhs) { return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b; }
+inline bool operator!=(const CRGB& lhs, const CRGB& rhs) { return !(lhs == rhs); }
+inline CRGB operator+(const CRGB& p1, const CRGB& p2) { return CRGB(qadd8(p1.r, p2.r), qadd8(p1.g, p2.g), qadd8(p1.b, p2.b)); }
+inline CRGB operator-(const CRGB& p1, const CRGB& p2) { return CRGB(qsub8(p1.r, p2.r), qsub8(p1.g, p2.g), qsub8(p1.b, p2.b)); }
+inline CRGB operator%(const CRGB& p1, uint8_t d) { CRGB retval(p1); retval.nscale8_video(d); return retval; }
+
+inline void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb) {
+  uint8_t hue = hsv.hue;
+  uint8_t sat = hsv.sat;
+  uint8_t val = hsv.val;
+  uint8_t offset8 = (hue & 0x1F) << 3; // 0..248
+  uint8_t third = scale8(offset8, (256 / 3)); // max = 85
+  uint8_t r, g, b;
+
+  if (!(hue & 0x80)) {
+    if (!(hue & 0x40)) {
+      if (!(hue & 0x20)) { // R -> O
+        r = 255 - third; g = third; b = 0;
+      } else { // O -> Y
+        r = 171; g = 85 + third; b = 0;
+      }
+    } else {
+      if (!(hue & 0x20)) { // Y -> G
+        uint8_t twothirds = scale8(offset8, ((256 * 2) / 3)); // max = 170
+        r = 171 - twothirds; g = 170 + third; b = 0;
+      } else { // G -> A
+        r = 0; g = 255 - third; b = third;
+      }
+    }
+  } else {
+    if (!(hue & 0x40)) {
+      if (!(hue & 0x20)) { // A -> B
+        uint8_t twothirds = scale8(offset8, ((256 * 2) / 3)); // max = 170
+        r = 0; g = 171 - twothirds; b = 85 + twothirds;
+      } else { // B -> P
+        r = third; g = 0; b = 255 - third;
+      }
+    } else {
+      if (!(hue & 0x20)) { // P -> K
+        r = 85 + third; g = 0; b = 171 - third;
+      } else { // K -> R
+        r = 170 + third; g = 0; b = 85 - third;
+      }
+    }
+  }
+
+  if (sat != 255) {
+    if (sat == 0) {
+      r = 255; b = 255; g = 255;
+    } else {
+      uint8_t desat = 255 - sat;
+      desat = scale8_video(desat, desat);
+      uint8_t satscale = 255 - desat;
+      r = scale8(r, satscale) + desat;
+      g = scale8(g, satscale) + desat;
+      b = scale8(b, satscale) + desat;
+    }
+  }
+
+  if (val != 255) {
+    val = scale8_video(val, val);
+    if (val == 0) {
+      r = 0; g = 0; b = 0;
+    } else {
+      r = scale8(r, val);
+      g = scale8(g, val);
+      b = scale8(b, val);
+    }
+  }
+
+  rgb.r = r; rgb.g = g; rgb.b = b;
+}
+
+inline CRGB HeatColor(uint8_t temperature) {
+  CRGB heatcolor;
+  uint8_t t192 = scale8_video(temperature, 191);
+  uint8_t heatramp = (t192 & 0x3F) << 2; // 0..252
+  if (t192 & 0x80) heatcolor.setRGB(255, 255, heatramp);
+  else if (t192 & 0x40) heatcolor.setRGB(255, heatramp, 0);
+  else heatcolor.setRGB(heatramp, 0, 0);
+  return heatcolor;
+}
+
+inline CRGB& nblend(CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay) {
+  if (amountOfOverlay == 0) return existing;
+  if (amountOfOverlay == 255) { existing = overlay; return existing; }
+  existing.red   = blend8(existing.red,   overlay.red,   amountOfOverlay);
+  existing.green = blend8(existing.green, overlay.green, amountOfOverlay);
+  existing.blue  = blend8(existing.blue,  overlay.blue,  amountOfOverlay);
+  return existing;
+}
+inline CRGB blend(const CRGB& p1, const CRGB& p2, fract8 amountOfP2) {
+  CRGB nu(p1);
+  nblend(nu, p2, amountOfP2);
+  return nu;
+}
+
+inline void fill_solid(CRGB* leds, int numToFill, const CRGB& color) {
+  for (int i = 0; i < numToFill; ++i) leds[i] = color;
+}
+
+inline void fill_gradient_RGB(CRGB* leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor) {
+  if (endpos < startpos) {
+    std::swap(startpos, endpos);
+    std::swap(startcolor, endcolor);
+  }
+  saccum87 rdistance87 = (endcolor.r - startcolor.r) << 7;
+  saccum87 gdistance87 = (endcolor.g - startcolor.g) << 7;
+  saccum87 bdistance87 = (endcolor.b - startcolor.b) << 7;
+  uint16_t pixeldistance = endpos - startpos;
+  int16_t divisor = pixeldistance ? pixeldistance : 1;
+  saccum87 rdelta87 = (rdistance87 / divisor) * 2;
+  saccum87 gdelta87 = (gdistance87 / divisor) * 2;
+  saccum87 bdelta87 = (bdistance87 / divisor) * 2;
+  accum88 r88 = startcolor.r << 8;
+  accum88 g88 = startcolor.g << 8;
+  accum88 b88 = startcolor.b << 8;
+  for (uint16_t i = startpos; i <= endpos; ++i) {
+    leds[i] = CRGB(r88 >> 8, g88 >> 8, b88 >> 8);
+    r88 += rdelta87;
+    g88 += gdelta87;
+    b88 += bdelta87;
+  }
+}
+inline void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2) {
+  fill_gradient_RGB(leds, 0, c1, numLeds - 1, c2);
+}
+inline void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3) {
+  uint16_t half = (numLeds / 2);
+  uint16_t last = numLeds - 1;
+  fill_gradient_RGB(leds,    0, c1, half, c2);
+  fill_gradient_RGB(leds, half, c2, last, c3);
+}
+inline void fill_gradient_RGB(CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4) {
+  uint16_t onethird = (numLeds / 3);
+  uint16_t twothirds = ((numLeds * 2) / 3);
+  uint16_t last = numLeds - 1;
+  fill_gradient_RGB(leds,         0, c1,  onethird, c2);
+  fill_gradient_RGB(leds,  onethird, c2, twothirds, c3);
+  fill_gradient_RGB(leds, twothirds, c3,      last, c4);
+}
+
+//HSV gradient, shortest way around the hue circle
+inline void fill_gradient(CRGB* leds, uint16_t startpos, CHSV startcolor, uint16_t endpos, CHSV endcolor) {
+  if (endpos < startpos) {
+    std::swap(startpos, endpos);
+    std::swap(startcolor, endcolor);
+  }
+  if (endcolor.value == 0 || endcolor.saturation == 0) endcolor.hue = startcolor.hue;
+  if (startcolor.value == 0 || startcolor.saturation == 0) startcolor.hue = endcolor.hue;
+
+  saccum87 satdistance87 = (endcolor.sat - startcolor.sat) << 7;
+  saccum87 valdistance87 = (endcolor.val - startcolor.val) << 7;
+  uint8_t huedelta8 = endcolor.hue - startcolor.hue;
+  saccum87 huedistance87;
+  if (huedelta8 > 127) huedistance87 = -((saccum87)((uint8_t)(256 - huedelta8) << 7));
+  else huedistance87 = huedelta8 << 7;
+
+  uint16_t pixeldistance = endpos - startpos;
+  int16_t divisor = pixeldistance ? pixeldistance : 1;
+  saccum87 huedelta87 = (huedistance87 / divisor) * 2;
+  saccum87 satdelta87 = (satdistance87 / divisor) * 2;
+  saccum87 valdelta87 = (valdistance87 / divisor) * 2;
+  accum88 hue88 = startcolor.hue << 8;
+  accum88 sat88 = startcolor.sat << 8;
+  accum88 val88 = startcolor.val << 8;
+  for (uint16_t i = startpos; i <= endpos; ++i) {
+    leds[i] = CHSV(hue88 >> 8, sat88 >> 8, val88 >> 8);
+    hue88 += huedelta87;
+    sat88 += satdelta87;
+    val88 += valdelta87;
+  }
+}
+inline void fill_gradient(CRGB* leds, uint16_t numLeds, const CHSV& c1, const CHSV& c2, const CHSV& c3, const CHSV& c4) {
+  uint16_t onethird = (numLeds / 3);
+  uint16_t twothirds = ((numLeds * 2) / 3);
+  uint16_t last = numLeds - 1;
+  fill_gradient(leds,         0, c1,  onethird, c2);
+  fill_gradient(leds,  onethird, c2, twothirds, c3);
+  fill_gradient(leds, twothirds, c3,      last, c4);
+}
+
+// palettes
+
+typedef uint32_t TProgmemRGBPalette16[16];
+typedef const uint8_t* TDynamicRGBGradientPalette_bytes;
+typedef enum { NOBLEND = 0, LINEARBLEND = 1 } TBlendType;
+
+class CRGBPalette16 {
+  public:
+  CRGB entries[16];
+
+  CRGBPalette16() {}
+  CRGBPalette16(const CRGB& c1) { fill_solid(entries, 16, c1); }
+  CRGBPalette16(const CRGB& c1, const CRGB& c2) { fill_gradient_RGB(entries, 16, c1, c2); }
+  CRGBPalette16(const CRGB& c1, const CRGB& c2, const CRGB& c3) { fill_gradient_RGB(entries, 16, c1, c2, c3); }
+  CRGBPalette16(const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4) { fill_gradient_RGB(entries, 16, c1, c2, c3, c4); }
+  CRGBPalette16(const CHSV& c1, const CHSV& c2, const CHSV& c3, const CHSV& c4) { fill_gradient(entries, 16, c1, c2, c3, c4); }
+  CRGBPalette16(const CRGB& c00, const CRGB& c01, const CRGB& c02, const CRGB& c03,
+                const CRGB& c04, const CRGB& c05, const CRGB& c06, const CRGB& c07,
+                const CRGB& c08, const CRGB& c09, const CRGB& c10, const CRGB& c11,
+                const CRGB& c12, const CRGB& c13, const CRGB& c14, const CRGB& c15) {
+    entries[0] = c00; entries[1] = c01; entries[2]  = c02; entries[3]  = c03;
+    entries[4] = c04; entries[5] = c05; entries[6]  = c06; entries[7]  = c07;
+    entries[8] = c08; entries[9] = c09; entries[10] = c10; entries[11] = c11;
+    entries[12] = c12; entries[13] = c13; entries[14] = c14; entries[15] = c15;
+  }
+  CRGBPalette16(const TProgmemRGBPalette16& rhs) { *this = rhs; }
+
+  CRGBPalette16& operator=(const TProgmemRGBPalette16& rhs) {
+    for (uint8_t i = 0; i < 16; ++i) entries[i] = pgm_read_dword(rhs + i);
+    return *this;
+  }
+
+  inline CRGB& operator[](uint8_t x) { return entries[x]; }
+  inline const CRGB& operator[](uint8_t x) const { return entries[x]; }
+
+  //index/r/g/b entries ending with index 255
+  CRGBPalette16& loadDynamicGradientPalette(TDynamicRGBGradientPalette_bytes gpal) {
+    const uint8_t* ent = gpal;
+    uint16_t count = 0;
+    do { ++count; } while (ent[(count - 1) * 4] != 255);
+
+    int8_t lastSlotUsed = -1;
+    CRGB rgbstart(ent[1], ent[2], ent[3]);
+    int indexstart = 0;
+    while (indexstart < 255) {
+      ent += 4;
+      int indexend = ent[0];
+      CRGB rgbend(ent[1], ent[2], ent[3]);
+      uint8_t istart8 = indexstart / 16;
+      uint8_t iend8   = indexend / 16;
+      if (count < 16) {
+        if ((istart8 <= lastSlotUsed) && (lastSlotUsed < 15)) {
+          istart8 = lastSlotUsed + 1;
+          if (iend8 < istart8) iend8 = istart8;
+        }
+        lastSlotUsed = iend8;
+      }
+      fill_gradient_RGB(entries, istart8, rgbstart, iend8, rgbend);
+      indexstart = indexend;
+      rgbstart = rgbend;
+    }
+    return *this;
+  }
+};
+
+inline CRGB ColorFromPalette(const CRGBPalette16& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND) {
+  uint8_t hi4 = index >> 4;
+  uint8_t lo4 = index & 0x0F;
+  const CRGB* entry = &(pal[0]) + hi4;
+  uint8_t red1   = entry->red;
+  uint8_t green1 = entry->green;
+  uint8_t blue1  = entry->blue;
+
+  if (lo4 && (blendType != NOBLEND)) {
+    entry = (hi4 == 15) ? &(pal[0]) : entry + 1;
+    uint8_t f2 = lo4 << 4;
+    uint8_t f1 = 255 - f2;
+    red1   = scale8(red1,   f1) + scale8(entry->red,   f2);
+    green1 = scale8(green1, f1) + scale8(entry->green, f2);
+    blue1  = scale8(blue1,  f1) + scale8(entry->blue,  f2);
+  }
+
+  if (brightness != 255) {
+    if (brightness) {
+      ++brightness; // adjust for rounding
+      if (red1)   red1   = scale8(red1,   brightness);
+      if (green1) green1 = scale8(green1, brightness);
+      if (blue1)  blue1  = scale8(blue1,  brightness);
+    } else {
+      red1 = 0; green1 = 0; blue1 = 0;
+    }
+  }
+  return CRGB(red1, green1, blue1);
+}
+
+inline void nblendPaletteTowardPalette(CRGBPalette16& current, CRGBPalette16& target, uint8_t maxChanges) {
+  uint8_t* p1 = (uint8_t*)current.entries;
+  uint8_t* p2 = (uint8_t*)target.entries;
+  uint8_t changes = 0;
+  for (uint8_t i = 0; i < sizeof(CRGBPalette16); ++i) {
+    if (p1[i] == p2[i]) continue;
+    if (p1[i] < p2[i]) { ++p1[i]; ++changes; }
+    if (p1[i] > p2[i]) {
+      --p1[i]; ++changes;
+      if (p1[i] > p2[i]) --p1[i];
+    }
+    if (changes >= maxChanges) break;
+  }
+}
+
+inline const TProgmemRGBPalette16 CloudColors_p = {
+  CRGB::Blue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue,
+  CRGB::Blue, CRGB::DarkBlue, CRGB::SkyBlue, CRGB::SkyBlue, CRGB::LightBlue, CRGB::White, CRGB::LightBlue, CRGB::SkyBlue
+};
+inline const TProgmemRGBPalette16 LavaColors_p = {
+  CRGB::Black, CRGB::Maroon, CRGB::Black, CRGB::Maroon, CRGB::DarkRed, CRGB::DarkRed, CRGB::Maroon, CRGB::DarkRed,
+  CRGB::DarkRed, CRGB::DarkRed, CRGB::Red, CRGB::Orange, CRGB::White, CRGB::Orange, CRGB::Red, CRGB::DarkRed
+};
+inline const TProgmemRGBPalette16 OceanColors_p = {
+  CRGB::MidnightBlue, CRGB::DarkBlue, CRGB::MidnightBlue, CRGB::Navy, CRGB::DarkBlue, CRGB::MediumBlue, CRGB::SeaGreen, CRGB::Teal,
+  CRGB::CadetBlue, CRGB::Blue, CRGB::DarkCyan, CRGB::CornflowerBlue, CRGB::Aquamarine, CRGB::SeaGreen, CRGB::Aqua, CRGB::LightSkyBlue
+};
+inline const TProgmemRGBPalette16 ForestColors_p = {
+  CRGB::DarkGreen, CRGB::DarkGreen, CRGB::DarkOliveGreen, CRGB::DarkGreen, CRGB::Green, CRGB::ForestGreen, CRGB::OliveDrab, CRGB::Green,
+  CRGB::SeaGreen, CRGB::MediumAquamarine, CRGB::LimeGreen, CRGB::YellowGreen, CRGB::LightGreen, CRGB::LawnGreen, CRGB::MediumAquamarine, CRGB::ForestGreen
+};
+inline const TProgmemRGBPalette16 RainbowColors_p = {
+  0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00, 0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+  0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5, 0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B
+};
+inline const TProgmemRGBPalette16 RainbowStripeColors_p = {
+  0xFF0000, 0x000000, 0xAB5500, 0x000000, 0xABAB00, 0x000000, 0x00FF00, 0x000000,
+  0x00AB55, 0x000000, 0x0000FF, 0x000000, 0x5500AB, 0x000000, 0xAB0055, 0x000000
+};
+inline const TProgmemRGBPalette16 PartyColors_p = {
+  0x5500AB, 0x84007C, 0xB5004B, 0xE5001B, 0xE81700, 0xB84700, 0xAB7700, 0xABAB00,
+  0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E, 0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9
+};
+inline const TProgmemRGBPalette16 HeatColors_p = {
+  0x000000, 0x330000, 0x660000, 0x990000, 0xCC0000, 0xFF0000, 0xFF3300, 0xFF6600,
+  0xFF9900, 0xFFCC00, 0xFFFF00, 0xFFFF33, 0xFFFF66, 0xFFFF99, 0xFFFFCC, 0xFFFFFF
+};
+
+// Perlin noise
+
+inline const uint8_t noisePerm[257] = {
+  151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+  190,6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,88,237,149,56,87,174,20,
+  125,136,171,168,68,175,74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,
+  105,92,41,55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,200,196,
+  135,130,116,188,159,86,164,100,109,198,173,186,3,64,52,217,226,250,124,123,5,202,38,147,118,126,255,
+  82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,119,248,152,2,44,154,163,70,221,
+  153,101,155,167,43,172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,218,246,97,228,
+  251,34,242,193,238,210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,49,192,214,31,181,199,
+  106,157,184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,222,114,67,29,24,72,243,141,128,
+  195,78,66,215,61,156,180,151
+};
+#define NOISE_P(x) noisePerm[(x)]
+
+inline int16_t grad16(uint8_t hash, int16_t x, int16_t y, int16_t z) {
+  hash = hash & 15;
+  int16_t u = hash < 8 ? x : y;
+  int16_t v = hash < 4 ? y : hash == 12 || hash == 14 ? x : z;
+  if (hash & 1) u = -u;
+  if (hash & 2) v = -v;
+  return avg15(u, v);
+}
+inline int16_t grad16(uint8_t hash, int16_t x, int16_t y) {
+  hash = hash & 7;
+  int16_t u, v;
+  if (hash < 4) { u = x; v = y; } else { u = y; v = x; }
+  if (hash & 1) u = -u;
+  if (hash & 2) v = -v;
+  return avg15(u, v);
+}
+inline int16_t grad16(uint8_t hash, int16_t x) {
+  hash = hash & 15;
+  int16_t u, v;
+  if (hash > 8) { u = x; v = x; }
+  else if (hash < 4) { u = x; v = 1; }
+  else { u = 1; v = x; }
+  if (hash & 1) u = -u;
+  if (hash & 2) v = -v;
+  return avg15(u, v);
+}
+inline int8_t grad8(uint8_t hash, int8_t x, int8_t y, int8_t z) {
+  hash &= 0xF;
+  int8_t u = (hash & 8) ? y : x;
+  int8_t v = hash < 4 ? y : hash == 12 || hash == 14 ? x : z;
+  if (hash & 1) u = -u;
+  if (hash & 2) v = -v;
+  return avg7(u, v);
+}
+inline int8_t grad8(uint8_t hash, int8_t x, int8_t y) {
+  int8_t u, v;
+  if (hash & 4) { u = y; v = x; } else { u = x; v = y; }
+  if (hash & 1) u = -u;
+  if (hash & 2) v = -v;
+  return avg7(u, v);
+}
+inline int8_t grad8(uint8_t hash, int8_t x) {
+  int8_t u, v;
+  if (hash & 8) { u = x; v = x; }
+  else if (hash & 4) { u = 1; v = x; }
+  else { u = x; v = 1; }
+  if (hash & 1) u = -u;
+  if (hash & 2) v = -v;
+  return avg7(u, v);
+}
+
+inline int16_t inoise16_raw(uint32_t x, uint32_t y, uint32_t z) {
+  uint8_t X = (x >> 16) & 0xFF, Y = (y >> 16) & 0xFF, Z = (z >> 16) & 0xFF;
+  uint8_t A = NOISE_P(X) + Y, AA = NOISE_P(A) + Z, AB = NOISE_P(A + 1) + Z;
+  uint8_t B = NOISE_P(X + 1) + Y, BA = NOISE_P(B) + Z, BB = NOISE_P(B + 1) + Z;
+  uint16_t u = x & 0xFFFF, v = y & 0xFFFF, w = z & 0xFFFF;
+  int16_t xx = (u >> 1) & 0x7FFF, yy = (v >> 1) & 0x7FFF, zz = (w >> 1) & 0x7FFF;
+  uint16_t N = 0x8000L;
+  u = ease16InOutQuad(u); v = ease16InOutQuad(v); w = ease16InOutQuad(w);
+  int16_t X1 = lerp15by16(grad16(NOISE_P(AA), xx, yy, zz), grad16(NOISE_P(BA), xx - N, yy, zz), u);
+  int16_t X2 = lerp15by16(grad16(NOISE_P(AB), xx, yy - N, zz), grad16(NOISE_P(BB), xx - N, yy - N, zz), u);
+  int16_t X3 = lerp15by16(grad16(NOISE_P(AA + 1), xx, yy, zz - N), grad16(NOISE_P(BA + 1), xx - N, yy, zz - N), u);
+  int16_t X4 = lerp15by16(grad16(NOISE_P(AB + 1), xx, yy - N, zz - N), grad16(NOISE_P(BB + 1), xx - N, yy - N, zz - N), u);
+  int16_t Y1 = lerp15by16(X1, X2, v);
+  int16_t Y2 = lerp15by16(X3, X4, v);
+  return lerp15by16(Y1, Y2, w);
+}
+inline uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z) {
+  int32_t ans = inoise16_raw(x, y, z);
+  uint32_t pan = ans + 19052L;
+  pan *= 440L;
+  return (pan >> 8);
+}
+inline int16_t inoise16_raw(uint32_t x, uint32_t y) {
+  uint8_t X = x >> 16, Y = y >> 16;
+  uint8_t A = NOISE_P(X) + Y, AA = NOISE_P(A), AB = NOISE_P(A + 1);
+  uint8_t B = NOISE_P(X + 1) + Y, BA = NOISE_P(B), BB = NOISE_P(B + 1);
+  uint16_t u = x & 0xFFFF, v = y & 0xFFFF;
+  int16_t xx = (u >> 1) & 0x7FFF, yy = (v >> 1) & 0x7FFF;
+  uint16_t N = 0x8000L;
+  u = ease16InOutQuad(u); v = ease16InOutQuad(v);
+  int16_t X1 = lerp15by16(grad16(NOISE_P(AA), xx, yy), grad16(NOISE_P(BA), xx - N, yy), u);
+  int16_t X2 = lerp15by16(grad16(NOISE_P(AB), xx, yy - N), grad16(NOISE_P(BB), xx - N, yy - N), u);
+  return lerp15by16(X1, X2, v);
+}
+inline uint16_t inoise16(uint32_t x, uint32_t y) {
+  int32_t ans = inoise16_raw(x, y);
+  uint32_t pan = ans + 17308L;
+  pan *= 484L;
+  return (pan >> 8);
+}
+inline int16_t inoise16_raw(uint32_t x) {
+  uint8_t X = x >> 16;
+  uint8_t A = NOISE_P(X), AA = NOISE_P(A);
+  uint8_t B = NOISE_P(X + 1), BA = NOISE_P(B);
+  uint16_t u = x & 0xFFFF;
+  int16_t xx = (u >> 1) & 0x7FFF;
+  uint16_t N = 0x8000L;
+  u = ease16InOutQuad(u);
+  return lerp15by16(grad16(NOISE_P(AA), xx), grad16(NOISE_P(BA), xx - N), u);
+}
+inline uint16_t inoise16(uint32_t x) {
+  return ((uint32_t)((int32_t)inoise16_raw(x) + 17308L)) << 1;
+}
+
+inline int8_t inoise8_raw(uint16_t x, uint16_t y, uint16_t z) {
+  uint8_t X = x >> 8, Y = y >> 8, Z = z >> 8;
+  uint8_t A = NOISE_P(X) + Y, AA = NOISE_P(A) + Z, AB = NOISE_P(A + 1) + Z;
+  uint8_t B = NOISE_P(X + 1) + Y, BA = NOISE_P(B) + Z, BB = NOISE_P(B + 1) + Z;
+  uint8_t u = x, v = y, w = z;
+  int8_t xx = ((uint8_t)(x) >> 1) & 0x7F, yy = ((uint8_t)(y) >> 1) & 0x7F, zz = ((uint8_t)(z) >> 1) & 0x7F;
+  uint8_t N = 0x80;
+  u = ease8InOutQuad(u); v = ease8InOutQuad(v); w = ease8InOutQuad(w);
+  int8_t X1 = lerp7by8(grad8(NOISE_P(AA), xx, yy, zz), grad8(NOISE_P(BA), xx - N, yy, zz), u);
+  int8_t X2 = lerp7by8(grad8(NOISE_P(AB), xx, yy - N, zz), grad8(NOISE_P(BB), xx - N, yy - N, zz), u);
+  int8_t X3 = lerp7by8(grad8(NOISE_P(AA + 1), xx, yy, zz - N), grad8(NOISE_P(BA + 1), xx - N, yy, zz - N), u);
+  int8_t X4 = lerp7by8(grad8(NOISE_P(AB + 1), xx, yy - N, zz - N), grad8(NOISE_P(BB + 1), xx - N, yy - N, zz - N), u);
+  int8_t Y1 = lerp7by8(X1, X2, v);
+  int8_t Y2 = lerp7by8(X3, X4, v);
+  return lerp7by8(Y1, Y2, w);
+}
+inline int8_t inoise8_raw(uint16_t x, uint16_t y) {
+  uint8_t X = x >> 8, Y = y >> 8;
+  uint8_t A = NOISE_P(X) + Y, AA = NOISE_P(A), AB = NOISE_P(A + 1);
+  uint8_t B = NOISE_P(X + 1) + Y, BA = NOISE_P(B), BB = NOISE_P(B + 1);
+  uint8_t u = x, v = y;
+  int8_t xx = ((uint8_t)(x) >> 1) & 0x7F, yy = ((uint8_t)(y) >> 1) & 0x7F;
+  uint8_t N = 0x80;
+  u = ease8InOutQuad(u); v = ease8InOutQuad(v);
+  int8_t X1 = lerp7by8(grad8(NOISE_P(AA), xx, yy), grad8(NOISE_P(BA), xx - N, yy), u);
+  int8_t X2 = lerp7by8(grad8(NOISE_P(AB), xx, yy - N), grad8(NOISE_P(BB), xx - N, yy - N), u);
+  return lerp7by8(X1, X2, v);
+}
+inline int8_t inoise8_raw(uint16_t x) {
+  uint8_t X = x >> 8;
+  uint8_t A = NOISE_P(X), AA = NOISE_P(A);
+  uint8_t B = NOISE_P(X + 1), BA = NOISE_P(B);
+  uint8_t u = x;
+  int8_t xx = ((uint8_t)(x) >> 1) & 0x7F;
+  uint8_t N = 0x80;
+  u = ease8InOutQuad(u);
+  return lerp7by8(grad8(NOISE_P(AA), xx), grad8(NOISE_P(BA), xx - N), u);
+}
+//-64..+64 mapped to 0..255
+inline uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z) { int8_t n = inoise8_raw(x, y, z) + 64; return qadd8(n, n); }
+inline uint8_t inoise8(uint16_t x, uint16_t y) { int8_t n = inoise8_raw(x, y) + 64; return qadd8(n, n); }
+inline uint8_t inoise8(uint16_t x) { int8_t n = inoise8_raw(x) + 64; return qadd8(n, n); }
+
+#endif
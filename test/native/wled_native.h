@@ -0,0 +1,101 @@
+#ifndef WLED_NATIVE_H
+#define WLED_NATIVE_H
+
+/*
+ * Stands in for wled.h in the native test env, force-included before every source file.
+ * FX.cpp, FX_fcn.cpp, colors.cpp and snapshot.cpp are compiled unchanged against it. bus_manager.h is the real one,
+ * built with WLED_BUS_MEMORY_ONLY: the only bus type is BusMemory, which keeps the pixels in RAM
+ * so tests can read back what service() rendered.
+ */
+
+#define WLED_H
+#define WLED_BUS_MEMORY_ONLY
+
+#include "Arduino.h"
+#include "const.h"
+#include "src/dependencies/json/ArduinoJson-v6.h"
+
+#include "bus_manager.h" //BusManager and BusMemory, the busses with outputs are left out
+
+#include "FX.h"
+
+//colors.cpp
+void colorFromRGB(uint8_t r, uint8_t g, uint8_t b, uint16_t* hsb);
+inline uint32_t colorFromRgbw(byte* rgbw) { return uint32_t((byte(rgbw[3]) << 24) | (byte(rgbw[0]) << 16) | (byte(rgbw[1]) << 8) | (byte(rgbw[2]))); }
+void colorHStoRGB(uint16_t hue, byte sat, byte* rgb); //hue, sat to rgb
+void colorKtoRGB(uint16_t kelvin, byte* rgb);
+void colorCTtoRGB(uint16_t mired, byte* rgb); //white spectrum to rgb
+
+void colorXYtoRGB(float x, float y, byte* rgb); // only defined if huesync disabled TODO
+void colorRGBtoXY(byte* rgb, float* xy); // only defined if huesync disabled TODO
+
+void colorFromDecOrHexString(byte* rgb, char* in);
+bool colorFromHexString(byte* rgb, const char* in);
+
+uint32_t colorBalanceFromKelvin(uint16_t kelvin, uint32_t rgb);
+uint16_t approximateKelvinFromRGB(uint32_t rgb);
+uint32_t colorFade(uint32_t c, uint8_t amount);
+void colorFadeSpan(const uint32_t* src, uint32_t* dest, uint16_t len, uint8_t amount);
+
+void setRandomColor(byte* rgb);
+
+//snapshot.cpp
+size_t writeStateSnapshot(uint8_t* buf, size_t len, bool includeBri = true, bool segmentBounds = true);
+size_t jsonToSnapshot(JsonObject root, uint8_t* buf, size_t len);
+bool snapshotToJson(const uint8_t* buf, size_t len, JsonObject root);
+bool applyStateSnapshot(const uint8_t* buf, size_t len, byte callMode, byte presetId = 0);
+bool saveStateSnapshotFile(const char* file);
+bool applyStateSnapshotFile(const char* file, byte callMode, byte presetId = 0);
+
+//globals of wled.h used by the effects and the color functions
+inline BusManager busses;
+inline WS2812FX strip;
+inline byte col[]    {255, 160, 0, 0};
+inline byte colSec[] {0, 0, 0, 0};
+inline byte lastRandomIndex = 0;
+inline bool gammaCorrectCol = true;
+inline bool gammaCorrectBri = false;
+inline bool autoSegments = false;
+inline bool correctWB = false;
+inline bool cctFromRgb = false;
+inline byte errorFlag = 0;
+inline uint16_t ledMaps = 0;
+inline DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+
+//globals of wled.h used by snapshot.cpp
+inline byte bri = 128;
+inline byte briLast = 128;
+inline uint16_t transitionDelay = 700;
+inline uint16_t transitionDelayTemp = 700;
+inline int16_t currentPlaylist = -1;
+inline bool stateChanged = false;
+inline byte interfaceUpdateCallMode = 0;
+inline bool doCloseFile = false;
+
+//state and playlist handling are not part of the native env, applying a snapshot only changes the segments
+inline void toggleOnOff() { if (bri) { briLast = bri; bri = 0; } else bri = briLast; }
+inline void stateUpdated(byte callMode) {}
+inline void unloadPlaylist() { currentPlaylist = -1; }
+inline int16_t loadPlaylist(const byte* presets, const uint16_t* durations, const uint16_t* transitions, byte len, int rep, byte endPreset, bool shuffle, byte presetId) { return 0; }
+
+inline uint32_t get_millisecond_timer() { return strip.now; }
+
+//no file system, so there are no ledmaps and snapshot files
+inline bool requestJSONBufferLock(uint8_t module = 255) { return true; }
+inline void releaseJSONBufferLock() {}
+inline bool readObjectFromFile(const char* file, const char* key, JsonDocument* dest) { return false; }
+inline void closeFile() {}
+struct File {
+  operator bool() const { return false; }
+  size_t size() { return 0; }
+  size_t read(uint8_t* buf, size_t len) { return 0; }
+  size_t write(const uint8_t* buf, size_t len) { return 0; }
+  void close() {}
+};
+struct NativeFS {
+  bool exists(const char*) { return false; }
+  File open(const char*, const char*) { return File(); }
+};
+inline NativeFS WLED_FS;
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Effect tests for the native env: pio test -e native
+ * FX.cpp, FX_fcn.cpp and colors.cpp run against the shims in test/native, service() renders into a BusMemory.
+ *
+ * test_golden_frames: renders every effect on 60 LEDs like the {"fxbench":{"gold":2}} API does
+ * (seeded random, fixed frame times) and compares the CRC32 of the frames against tools/fxgold.json.
+ * Effects that do not render the same frames twice are listed under "skip" there and not compared.
+ * Build with -D FXGOLD_RECORD to write tools/fxgold.json instead:
+ * PLATFORMIO_BUILD_FLAGS=-DFXGOLD_RECORD pio test -e native
+ *
+ * test_static_frame: the solid color effect reaches the RAM bus through service() and strip.show().
+ *
+ * test_bus_map: BusManager routes single pixels and runs to adjacent busses and across holes through its
+ * pixel to bus map, and to every bus through the linear search if busses overlap.
+ *
+ * test_bus_config: busses are created again from Bus::getConfig(), as the benchmark restores them.
+ *
+ * test_ledmap: a segment with grouping 3 and mirror writes to the LEDs a generated reversing ledmap points to.
+ *
+ * test_benchmark: ns/pixel and heap used by every effect at 60, 1000 and 8192 LEDs, printed as JSON
+ * in the /fxbench.json format, once plain and once with grouping 3, mirror and a reversing ledmap.
+ * Timing is host time, useful to compare two builds on the same machine. The plain run is also written
+ * to FXBENCH_FILE, the native_segbuf env (WLED_USE_SEGMENT_BUFFER) writes its own, so the two can be compared:
+ * tools/fxbench.py .pio/fxbench_native_segbuf.json compare --baseline .pio/fxbench_native.json
+ */
+
+#include <unity.h>
+#include <string>
+
+#define FXGOLD_FILE      "tools/fxgold.json" //relative to the project directory, where pio test runs the program
+#define FXGOLD_LENGTH    60
+#define FXGOLD_FRAMES    20
+#define FXGOLD_SEED      1337
+#define FXGOLD_TIME      1000 //effect time of the first golden frame in ms
+#define FXGOLD_FRAMETIME 25   //effect time between golden frames in ms
+
+#ifdef WLED_USE_SEGMENT_BUFFER
+#define FXBENCH_FILE      ".pio/fxbench_native_segbuf.json"
+#else
+#define FXBENCH_FILE      ".pio/fxbench_native.json"
+#endif
+#define FXBENCH_FRAMES    20
+#define FXBENCH_FRAMETIME 25 //ms the fake clock advances per frame
+
+static const uint16_t benchLengths[] = {60, 1000, 8192};
+
+struct BenchOptions { uint8_t grouping; bool mirror; bool ledmap; };
+static const BenchOptions benchOptions[] = {{1, false, false}, {3, true, true}};
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len)
+{
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+//one RAM bus and one segment covering it, as setupLength() in fx_benchmark.cpp
+static bool setupLength(uint16_t len, const BenchOptions& opt = benchOptions[0])
+{
+  if (len > MAX_LEDS) return false;
+  busses.removeAll();
+  uint8_t pins[5] = {255, 255, 255, 255, 255};
+  BusConfig bc = BusConfig(TYPE_RESERVED, pins, 0, len);
+  if (busses.add(bc) < 0 || !busses.getBus(0)->isOk()) return false;
+  uint16_t* table = nullptr; //reverses the strip
+  uint16_t size = opt.ledmap ? len : 0;
+  if (size) {
+    table = new uint16_t[size];
+    for (uint16_t i = 0; i < size; i++) table[i] = size - 1 - i;
+  }
+  strip.swapLedmap(table, size);
+  delete[] table;
+  strip.finalizeInit();
+  strip.resetSegments();
+  strip.setSegment(0, 0, len, opt.grouping, 0, 0);
+  strip.getSegment(0).setOption(SEG_OPTION_MIRROR, opt.mirror);
+  return true;
+}
+
+static const uint32_t* pixels(uint8_t bus = 0)
+{
+  return static_cast<BusMemory*>(busses.getBus(bus))->getPixels();
+}
+
+static uint32_t shows = 0; //frames sent by strip.show()
+static void countShow() { shows++; }
+
+//adds a RAM bus per {start, length} pair
+static void setupBusses(const uint16_t (*ranges)[2], uint8_t count)
+{
+  busses.removeAll();
+  uint8_t pins[5] = {255, 255, 255, 255, 255};
+  for (uint8_t i = 0; i < count; i++) {
+    BusConfig bc = BusConfig(TYPE_RESERVED, pins, ranges[i][0], ranges[i][1]);
+    busses.add(bc);
+  }
+}
+
+static void test_bus_map()
+{
+  //adjacent busses, 20-24 are not driven by any bus
+  static const uint16_t ranges[][2] = {{0, 10}, {10, 10}, {25, 5}};
+  setupBusses(ranges, 3);
+  TEST_ASSERT_EQUAL(3, busses.getNumBusses());
+  busses.setPixelColor(9, 0x09);
+  busses.setPixelColor(10, 0x10);
+  busses.setPixelColor(22, 0x22); //hole
+  busses.setPixelColor(29, 0x29);
+  busses.setPixelColor(30, 0x30); //past the end
+  TEST_ASSERT_EQUAL_HEX32(0x09, pixels(0)[9]);
+  TEST_ASSERT_EQUAL_HEX32(0x10, pixels(1)[0]);
+  TEST_ASSERT_EQUAL_HEX32(0x29, pixels(2)[4]);
+  TEST_ASSERT_EQUAL_HEX32(0x29, busses.getPixelColor(29));
+  TEST_ASSERT_EQUAL_HEX32(0, busses.getPixelColor(22));
+  TEST_ASSERT_EQUAL_HEX32(0, busses.getPixelColor(30));
+
+  //one run across all three busses and the hole
+  uint32_t run[25];
+  for (uint16_t i = 0; i < 25; i++) run[i] = 0x100 + 5 + i;
+  busses.setPixelColors(5, 25, run);
+  for (uint16_t p = 0; p < 30; p++) {
+    uint32_t expected = (p < 5) ? 0 : 0x100 + p;
+    if (p >= 20 && p < 25) expected = 0; //hole
+    TEST_ASSERT_EQUAL_HEX32(expected, busses.getPixelColor(p));
+  }
+  TEST_ASSERT_EQUAL_HEX32(0x100 + 14, pixels(1)[4]);
+  TEST_ASSERT_EQUAL_HEX32(0x100 + 25, pixels(2)[0]);
+
+  //overlapping busses, pixels 5-9 go to both
+  static const uint16_t overlap[][2] = {{0, 10}, {5, 10}};
+  setupBusses(overlap, 2);
+  busses.setPixelColor(7, 0x07);
+  busses.setPixelColor(12, 0x12);
+  TEST_ASSERT_EQUAL_HEX32(0x07, pixels(0)[7]);
+  TEST_ASSERT_EQUAL_HEX32(0x07, pixels(1)[2]);
+  TEST_ASSERT_EQUAL_HEX32(0x12, pixels(1)[7]);
+  for (uint16_t i = 0; i < 6; i++) run[i] = 0x200 + 4 + i;
+  busses.setPixelColors(4, 6, run);
+  TEST_ASSERT_EQUAL_HEX32(0x204, pixels(0)[4]);
+  TEST_ASSERT_EQUAL_HEX32(0x209, pixels(0)[9]);
+  TEST_ASSERT_EQUAL_HEX32(0x205, pixels(1)[0]);
+  TEST_ASSERT_EQUAL_HEX32(0x209, pixels(1)[4]);
+  TEST_ASSERT_EQUAL_HEX32(0x12, pixels(1)[7]);
+}
+
+static void test_bus_config()
+{
+  static const uint16_t ranges[][2] = {{0, 10}, {10, 20}, {40, 5}};
+  setupBusses(ranges, 3);
+  BusConfig* saved[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    saved[i] = new BusConfig(busses.getBus(i)->getConfig());
+    TEST_ASSERT_EQUAL(busses.getBus(i)->getUniverse(), saved[i]->universe);
+  }
+  busses.removeAll();
+  for (uint8_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(i, busses.add(*saved[i]));
+    delete saved[i];
+  }
+  TEST_ASSERT_EQUAL(3, busses.getNumBusses());
+  for (uint8_t i = 0; i < 3; i++) {
+    Bus* b = busses.getBus(i);
+    TEST_ASSERT_EQUAL(TYPE_RESERVED, b->getType());
+    TEST_ASSERT_EQUAL(ranges[i][0], b->getStart());
+    TEST_ASSERT_EQUAL(ranges[i][1], b->getLength());
+    TEST_ASSERT_TRUE(b->isOk());
+  }
+}
+
+static void test_static_frame()
+{
+  TEST_ASSERT_TRUE(setupLength(60));
+  strip.setMode(0, FX_MODE_STATIC);
+  uint32_t lastShows = shows;
+  nativeMillis += FXBENCH_FRAMETIME;
+  strip.trigger();
+  strip.service();
+  TEST_ASSERT_EQUAL(lastShows + 1, shows);
+  uint32_t c = strip.gamma32(strip.getSegment(0).colors[0]);
+  for (uint16_t i = 0; i < 60; i++) TEST_ASSERT_EQUAL_HEX32(c, pixels()[i]);
+}
+
+static void test_ledmap()
+{
+  TEST_ASSERT_TRUE(setupLength(60, benchOptions[1]));
+  strip.setMode(0, FX_MODE_STATIC);
+  nativeMillis += FXBENCH_FRAMETIME;
+  strip.trigger();
+  strip.service(); //builds the address map of the segment
+  for (uint16_t i = 0; i < 60; i++) busses.setPixelColor(i, 0);
+  strip.setPixelSegment(0);
+  strip.setPixelColor(0, 0x00FF0000); //LEDs 0-2 and mirrored 57-59 before the ledmap
+  strip.setPixelColor(1, 0x0000FF00); //LEDs 3-5 and 54-56
+  for (uint16_t i = 0; i < 60; i++) {
+    uint32_t c = 0;
+    if (i < 3 || i >= 57) c = 0x00FF0000;
+    else if (i < 6 || i >= 54) c = 0x0000FF00;
+    TEST_ASSERT_EQUAL_HEX32(c, pixels()[59 - i]);
+  }
+  TEST_ASSERT_EQUAL_HEX32(0x0000FF00, strip.getPixelColor(1));
+  setupLength(60); //no ledmap for the following tests
+}
+
+//renders the golden frames of the current effect and returns their CRC
+static uint32_t renderGolden()
+{
+  for (uint16_t i = 0; i < FXGOLD_LENGTH; i++) busses.setPixelColor(i, 0);
+  strip.restartRuntime();
+  random16_set_seed(FXGOLD_SEED);
+  randomSeed(FXGOLD_SEED);
+  uint32_t crc = 0;
+  for (uint16_t f = 0; f < FXGOLD_FRAMES; f++) {
+    strip.fixedNow = FXGOLD_TIME + f * FXGOLD_FRAMETIME;
+    nativeMillis += FXGOLD_FRAMETIME;
+    strip.trigger();
+    strip.service();
+    crc = crc32(crc, (const uint8_t*)pixels(), FXGOLD_LENGTH * sizeof(uint32_t));
+  }
+  strip.fixedNow = 0;
+  return crc;
+}
+
+static void test_golden_frames()
+{
+  TEST_ASSERT_TRUE(setupLength(FXGOLD_LENGTH));
+  uint8_t modes = strip.getModeCount();
+  uint32_t crc[MODE_COUNT];
+  std::string skip;
+  for (uint8_t m = 0; m < modes; m++) {
+    strip.setMode(0, m);
+    uint32_t first = renderGolden();
+    crc[m] = (renderGolden() == first) ? first : 0; //0: effect is not deterministic
+    if (!crc[m]) skip += (skip.empty() ? "" : ",") + std::to_string(m);
+  }
+
+  #ifdef FXGOLD_RECORD
+  FILE* f = fopen(FXGOLD_FILE, "w");
+  TEST_ASSERT_NOT_NULL_MESSAGE(f, "cannot write " FXGOLD_FILE);
+  fprintf(f, "{\"env\":\"native\",\"len\":%u,\"frames\":%u,\"skip\":[%s],\"crc\":[", FXGOLD_LENGTH, FXGOLD_FRAMES, skip.c_str());
+  for (uint8_t m = 0; m < modes; m++) fprintf(f, m ? ",%u" : "%u", crc[m]);
+  fprintf(f, "]}\n");
+  fclose(f);
+  TEST_IGNORE_MESSAGE("golden frames recorded to " FXGOLD_FILE);
+  #else
+  FILE* f = fopen(FXGOLD_FILE, "r");
+  TEST_ASSERT_NOT_NULL_MESSAGE(f, "cannot read " FXGOLD_FILE);
+  std::string json;
+  char buf[256];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) json.append(buf, n);
+  fclose(f);
+
+  DynamicJsonDocument gold(8192);
+  TEST_ASSERT_FALSE(deserializeJson(gold, json));
+  TEST_ASSERT_EQUAL(FXGOLD_LENGTH, gold["len"].as<int>());
+  TEST_ASSERT_EQUAL(FXGOLD_FRAMES, gold["frames"].as<int>());
+  JsonArray goldCrc = gold["crc"];
+  TEST_ASSERT_EQUAL_MESSAGE(modes, goldCrc.size(), "effect count changed, record the golden frames again");
+
+  std::string failed;
+  for (uint8_t m = 0; m < modes; m++) {
+    uint32_t expected = goldCrc[m].as<uint32_t>();
+    if (!expected || !crc[m]) continue; //skipped when recording or now
+    if (crc[m] != expected) failed += (failed.empty() ? "" : ",") + std::to_string(m);
+  }
+  if (!skip.empty()) TEST_MESSAGE(("not deterministic: " + skip).c_str());
+  TEST_ASSERT_TRUE_MESSAGE(failed.empty(), ("effects differing from the golden frames: " + failed).c_str());
+  #endif
+}
+
+static std::string benchmark(const BenchOptions& opt)
+{
+  std::string out = "{\"frames\":" + std::to_string(FXBENCH_FRAMES) + ",\"grp\":" + std::to_string(opt.grouping)
+    + ",\"mi\":" + std::to_string(opt.mirror) + ",\"lm\":" + std::to_string(opt.ledmap) + ",\"fx\":[";
+  for (uint8_t l = 0; l < sizeof(benchLengths) / sizeof(benchLengths[0]); l++) {
+    uint16_t len = benchLengths[l];
+    if (l) out += ',';
+    out += "{\"len\":" + std::to_string(len) + ",\"res\":[";
+    if (setupLength(len, opt)) {
+      for (uint8_t m = 0; m < strip.getModeCount(); m++) {
+        strip.setMode(0, m);
+        strip.restartRuntime();
+        uint32_t time = 0;
+        uint32_t heapStart = strip.heapLow = ESP.getFreeHeap();
+        for (uint16_t f = 0; f < FXBENCH_FRAMES; f++) {
+          nativeMillis += FXBENCH_FRAMETIME;
+          uint32_t start = micros();
+          strip.trigger();
+          strip.service();
+          time += micros() - start;
+          strip.sampleHeap();
+        }
+        uint32_t nsPerPixel = ((uint64_t)time * 1000) / ((uint64_t)FXBENCH_FRAMES * len);
+        if (m) out += ',';
+        //[ns per pixel, heap used by the effect in bytes]
+        out += "[" + std::to_string(nsPerPixel) + "," + std::to_string(heapStart - strip.heapLow) + "]";
+      }
+      strip.heapLow = 0;
+    }
+    out += "]}";
+  }
+  out += "]}";
+  printf("%s\n", out.c_str());
+  return out;
+}
+
+static void test_benchmark()
+{
+  for (const BenchOptions& opt : benchOptions) {
+    std::string out = benchmark(opt);
+    if (&opt != benchOptions) continue;
+    FILE* f = fopen(FXBENCH_FILE, "w");
+    if (!f) continue; //not run from the project directory, the result is printed anyway
+    fprintf(f, "%s\n", out.c_str());
+    fclose(f);
+  }
+  setupLength(60);
+  TEST_ASSERT_TRUE(shows > 0);
+}
+
+int main(int argc, char **argv)
+{
+  strip.setShowCallback(countShow);
+  UNITY_BEGIN();
+  RUN_TEST(test_bus_map);
+  RUN_TEST(test_bus_config);
+  RUN_TEST(test_static_frame);
+  RUN_TEST(test_ledmap);
+  RUN_TEST(test_golden_frames);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+/*
+ * Snapshot tests for the native env: pio test -e native
+ * snapshot.cpp runs against the shims in test/native, the segments come from a strip rendering into a BusMemory.
+ *
+ * test_json_round_trip: a preset in the serializeState(root, true) format is encoded by jsonToSnapshot()
+ * and comes back unchanged from snapshotToJson(), encoding that JSON again gives the same bytes.
+ *
+ * test_not_representable: presets with other keys or relative values are left to the JSON path.
+ *
+ * test_state_round_trip: the quick save encoding of the current segments (writeStateSnapshot()) survives
+ * the conversion to JSON and back.
+ */
+
+#include <unity.h>
+#include <string>
+
+#define SNAPTEST_SIZE 1024
+
+//key order as snapshotToJson() writes it, so the serialized strings can be compared
+static const char presetJson[] =
+  "{\"n\":\"Evening\",\"ql\":\"E\",\"on\":true,\"bri\":128,\"transition\":7,\"mainseg\":1,\"seg\":["
+  "{\"id\":0,\"start\":0,\"stop\":30,\"grp\":1,\"spc\":0,\"of\":0,\"on\":true,\"frz\":false,\"bri\":255,\"cct\":127,"
+  "\"col\":[[255,160,0,0],[0,0,0,0],[0,0,0,20]],\"fx\":9,\"sx\":128,\"ix\":64,\"pal\":11,\"sel\":true,\"rev\":false,\"mi\":false},"
+  "{\"id\":1,\"start\":30,\"stop\":60,\"grp\":2,\"spc\":1,\"of\":3,\"on\":false,\"frz\":true,\"bri\":80,\"cct\":0,\"n\":\"Shelf\","
+  "\"col\":[[1,2,3,4],[5,6,7,8],[9,10,11,12]],\"fx\":0,\"sx\":10,\"ix\":250,\"pal\":0,\"sel\":false,\"rev\":true,\"mi\":true},"
+  "{\"stop\":0}],"
+  "\"playlist\":{\"ps\":[2,5],\"dur\":[300,100],\"transition\":[7,0],\"repeat\":3,\"end\":4,\"r\":true}}";
+
+//encodes root, returns the snapshot length, 0 if it is not representable or the sizes do not match
+static size_t encode(JsonObject root, uint8_t* buf)
+{
+  size_t len = jsonToSnapshot(root, nullptr, 0);
+  if (!len || len > SNAPTEST_SIZE) return 0;
+  if (jsonToSnapshot(root, buf, len - 1)) return 0; //too small
+  return jsonToSnapshot(root, buf, len);
+}
+
+static void test_json_round_trip()
+{
+  DynamicJsonDocument in(4096), out(4096);
+  TEST_ASSERT_TRUE(deserializeJson(in, presetJson) == DeserializationError::Ok);
+
+  uint8_t buf[SNAPTEST_SIZE], again[SNAPTEST_SIZE];
+  size_t len = encode(in.as<JsonObject>(), buf);
+  TEST_ASSERT_TRUE(len > 0);
+  TEST_ASSERT_TRUE(snapshotToJson(buf, len, out.to<JsonObject>()));
+
+  std::string json;
+  serializeJson(out, json);
+  TEST_ASSERT_EQUAL_STRING(presetJson, json.c_str());
+  TEST_ASSERT_EQUAL(len, encode(out.as<JsonObject>(), again));
+  TEST_ASSERT_EQUAL_MEMORY(buf, again, len);
+
+  //truncated and corrupted snapshots are rejected
+  out.clear();
+  TEST_ASSERT_FALSE(snapshotToJson(buf, len - 1, out.to<JsonObject>()));
+  buf[2]++; //version
+  TEST_ASSERT_FALSE(snapshotToJson(buf, len, out.to<JsonObject>()));
+}
+
+static void test_not_representable()
+{
+  static const char* const presets[] = {
+    "{\"on\":true,\"ps\":3}",                   //other keys
+    "{\"bri\":\"~\"}",                          //relative value
+    "{\"on\":\"t\"}",                           //toggle
+    "{\"seg\":[{\"id\":0,\"col\":[\"FF0000\"]}]}", //partial segment, hex color
+    "{\"playlist\":{\"ps\":[1,2],\"dur\":100}}" //transition depends on the current one
+  };
+  DynamicJsonDocument in(1024);
+  for (const char* preset : presets) {
+    TEST_ASSERT_TRUE(deserializeJson(in, preset) == DeserializationError::Ok);
+    TEST_ASSERT_EQUAL_MESSAGE(0, jsonToSnapshot(in.as<JsonObject>(), nullptr, 0), preset);
+  }
+}
+
+static void test_state_round_trip()
+{
+  busses.removeAll();
+  uint8_t pins[5] = {255, 255, 255, 255, 255};
+  BusConfig bc = BusConfig(TYPE_RESERVED, pins, 0, 60);
+  TEST_ASSERT_TRUE(busses.add(bc) >= 0);
+  strip.finalizeInit();
+  strip.resetSegments();
+  strip.setSegment(0, 0, 20, 1, 0, 0);
+  strip.setSegment(1, 20, 60, 2, 1, 5);
+  WS2812FX::Segment& seg = strip.getSegment(1);
+  seg.name = new char[6];
+  strlcpy(seg.name, "Shelf", 6);
+  seg.setColor(0, RGBW32(1, 2, 3, 4), 1);
+  seg.setOption(SEG_OPTION_REVERSED, true);
+  strip.setMode(1, FX_MODE_RAINBOW);
+
+  uint8_t buf[SNAPTEST_SIZE], again[SNAPTEST_SIZE];
+  size_t len = writeStateSnapshot(nullptr, 0);
+  TEST_ASSERT_TRUE(len > 0 && len <= SNAPTEST_SIZE);
+  TEST_ASSERT_EQUAL(len, writeStateSnapshot(buf, len));
+
+  DynamicJsonDocument out(8192);
+  TEST_ASSERT_TRUE(snapshotToJson(buf, len, out.to<JsonObject>()));
+  TEST_ASSERT_EQUAL(strip.getMaxSegments(), out["seg"].size());
+  TEST_ASSERT_EQUAL(20, out["seg"][1]["start"].as<int>());
+  TEST_ASSERT_EQUAL_STRING("Shelf", out["seg"][1]["n"].as<const char*>());
+  TEST_ASSERT_EQUAL(FX_MODE_RAINBOW, out["seg"][1]["fx"].as<int>());
+  TEST_ASSERT_EQUAL(0, out["seg"][2]["stop"].as<int>());
+  TEST_ASSERT_EQUAL(len, encode(out.as<JsonObject>(), again));
+  TEST_ASSERT_EQUAL_MEMORY(buf, again, len);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_json_round_trip);
+  RUN_TEST(test_not_representable);
+  RUN_TEST(test_state_round_trip);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+Runs the on-device effect benchmark and golden frame check (wled00/fx_benchmark.cpp) over HTTP.
+The device needs a build with -D WLED_ENABLE_FX_BENCHMARK and OTA unlocked (file upload).
+Uses the Python standard library only, exits with 1 if a check fails, so it can run in CI
+against a device attached to the runner.
+
+  fxbench.py <host> record [--gold tools/fxgold_<arch>.json]
+      renders all effects, stores the frame hashes in the golden file (commit it)
+  fxbench.py <host> verify [--gold tools/fxgold_<arch>.json]
+      uploads the golden file and fails if an effect renders different frames
+  fxbench.py <host> bench [--out fxbench.json] [--baseline old.json] [--tolerance 10]
+                          [--grouping 3] [--mirror] [--ledmap]
+      stores ns per pixel and heap per effect and length, fails if an effect got slower
+      than the baseline by more than tolerance percent (and at least 5 ns/px)
+      --ledmap renders through a generated ledmap that reverses the strip
+  fxbench.py <result.json> compare --baseline old.json [--fx 66,101,115] [--tolerance 10]
+      compares two benchmark results, e.g. of the native envs with and without the
+      segment buffer (pio test -e native, pio test -e native_segbuf):
+      fxbench.py .pio/fxbench_native_segbuf.json compare --baseline .pio/fxbench_native.json
+      prints the effects given with --fx side by side (default fire_2012, pacifica, blends)
+
+Golden frames depend on the target (ESP8266/ESP32), record them on the same kind of device
+that verifies them. The default file is named after the "arch" the device reports.
+tools/fxgold.json is the reference of the native env ("pio test -e native", test/test_fx).
+"""
+
+import argparse
+import json
+import os
+import sys
+import time
+import urllib.request
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def request(host, path, data=None, headers=None, timeout=10):
+  req = urllib.request.Request("http://%s%s" % (host, path), data=data, headers=headers or {})
+  with urllib.request.urlopen(req, timeout=timeout) as res:
+    return res.read()
+
+
+def post_json(host, obj):
+  request(host, "/json/state", json.dumps(obj).encode(), {"Content-Type": "application/json"})
+
+
+def get_json(host, path):
+  return json.loads(request(host, path))
+
+
+def upload(host, name, content):
+  boundary = "----wledfxbench%d" % int(time.time())
+  body = ("--%s\r\nContent-Disposition: form-data; name=\"data\"; filename=\"%s\"\r\n"
+          "Content-Type: application/json\r\n\r\n" % (boundary, name)).encode()
+  body += content + ("\r\n--%s--\r\n" % boundary).encode()
+  request(host, "/upload", body, {"Content-Type": "multipart/form-data; boundary=" + boundary})
+
+
+def run(host, cmd, timeout):
+  info = get_json(host, "/json/info")
+  if "fxb" not in info:
+    sys.exit("%s: firmware was built without WLED_ENABLE_FX_BENCHMARK" % host)
+  post_json(host, {"fxbench": cmd})
+  start = time.time()
+  while time.time() - start < timeout:
+    time.sleep(2)
+    try:
+      if not get_json(host, "/json/info")["fxb"]:
+        return
+    except OSError:
+      pass  # the device is busy rendering, try again
+  sys.exit("%s: benchmark did not finish within %u s" % (host, timeout))
+
+
+def gold_file(args):
+  if args.gold:
+    return args.gold
+  return os.path.join(TOOLS_DIR, "fxgold_%s.json" % get_json(args.host, "/json/info")["arch"])
+
+
+def record(args):
+  path = gold_file(args)
+  run(args.host, {"gold": 1, "frames": args.frames}, args.timeout)
+  gold = get_json(args.host, "/fxgold.json")
+  with open(path, "w") as f:
+    json.dump(gold, f, separators=(",", ":"))
+    f.write("\n")
+  skip = gold.get("skip", [])
+  print("recorded %u effects to %s, not deterministic: %s" % (len(gold["crc"]), path, ", ".join(str(m) for m in skip) or "none"))
+
+
+def verify(args):
+  path = gold_file(args)
+  with open(path, "rb") as f:
+    content = f.read()
+  gold = json.loads(content)
+  if not any(gold.get("crc", [])):
+    sys.exit("%s has no hashes, record them with: fxbench.py <host> record" % path)
+  upload(args.host, "/fxgold.json", content)
+  run(args.host, {"gold": 2}, args.timeout)
+  check = get_json(args.host, "/fxcheck.json")
+  if check["fail"]:
+    print("effects with different frames: %s" % ", ".join(str(m) for m in check["fail"]))
+    sys.exit(1)
+  print("all effects match the golden frames, %u skipped (not deterministic)" % check["skip"])
+
+
+def compare_results(res, args):
+  with open(args.baseline) as f:
+    base = {l["len"]: l["res"] for l in json.load(f)["fx"]}
+  listed = [int(m) for m in args.fx.split(",") if m]
+  slower = 0
+  for length in res["fx"]:
+    old = base.get(length["len"], [])
+    for mode, (ns, heap) in enumerate(length["res"]):
+      if mode >= len(old):
+        continue
+      ns_old, heap_old = old[mode]
+      if mode in listed:
+        print("FX %u len %u: %u ns/px (baseline %u), %u B heap (baseline %u)" % (mode, length["len"], ns, ns_old, heap, heap_old))
+      if ns > ns_old * (100 + args.tolerance) / 100 and ns - ns_old >= 5:
+        print("FX %u len %u: %u ns/px, was %u" % (mode, length["len"], ns, ns_old))
+        slower += 1
+      if heap > heap_old:
+        print("FX %u len %u: %u B heap, was %u" % (mode, length["len"], heap, heap_old))
+  if slower:
+    sys.exit(1)
+
+
+def bench(args):
+  run(args.host, {"frames": args.frames, "grp": args.grouping, "mi": args.mirror, "lm": args.ledmap}, args.timeout)
+  res = get_json(args.host, "/fxbench.json")
+  with open(args.out, "w") as f:
+    json.dump(res, f, separators=(",", ":"))
+    f.write("\n")
+  if args.baseline:
+    compare_results(res, args)
+
+
+def compare(args):
+  if not args.baseline:
+    sys.exit("compare needs --baseline")
+  with open(args.host) as f:
+    compare_results(json.load(f), args)
+
+
+def main():
+  p = argparse.ArgumentParser(description="WLED effect benchmark and golden frame check")
+  p.add_argument("host", help="device, or the benchmark result file for compare")
+  p.add_argument("command", choices=["record", "verify", "bench", "compare"])
+  p.add_argument("--gold", help="golden frame file, default tools/fxgold_<arch>.json")
+  p.add_argument("--out", default="fxbench.json", help="benchmark result file")
+  p.add_argument("--baseline", help="earlier benchmark result to compare with")
+  p.add_argument("--tolerance", type=int, default=10, help="percent an effect may get slower")
+  p.add_argument("--fx", default="66,101,115", help="effects to print next to the baseline")
+  p.add_argument("--frames", type=int, default=20)
+  p.add_argument("--grouping", type=int, default=1, help="segment grouping for bench")
+  p.add_argument("--mirror", action="store_true", help="mirror the segment for bench")
+  p.add_argument("--ledmap", action="store_true", help="use a generated reversing ledmap for bench")
+  p.add_argument("--timeout", type=int, default=900, help="seconds to wait for the device")
+  args = p.parse_args()
+  {"record": record, "verify": verify, "bench": bench, "compare": compare}[args.command](args)
+
+
+if __name__ == "__main__":
+  main()
@@ -29,6 +29,10 @@
 
 #include "const.h"
 
+#ifdef ARDUINO_ARCH_ESP32
+#include "freertos/semphr.h"
+#endif
+
 #define FASTLED_INTERNAL //remove annoying pragma messages
 #define USE_GET_MILLISECOND_TIMER
 #include "FastLED.h"
@@ -349,6 +353,7 @@ class WS2812FX {
       bool allocateData(uint16_t len){
         if (data && _dataLen == len) return true; //already allocated
         deallocateData();
+        if (WS2812FX::instance->_usedSegmentData + len > MAX_SEGMENT_DATA) WS2812FX::instance->freeSegmentMaps(); //effect data goes first
         if (WS2812FX::instance->_usedSegmentData + len > MAX_SEGMENT_DATA) return false; //not enough memory
         // if possible use SPI RAM on ESP32
         #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_USE_PSRAM)
@@ -358,6 +363,9 @@ class WS2812FX {
         #endif
           data = (byte*) malloc(len);
         if (!data) return false; //allocation failed
+        #ifdef WLED_ENABLE_FX_BENCHMARK
+        WS2812FX::instance->sampleHeap();
+        #endif
         WS2812FX::instance->_usedSegmentData += len;
         _dataLen = len;
         memset(data, 0, len);
@@ -366,9 +374,64 @@ class WS2812FX {
       void deallocateData(){
         free(data);
         data = nullptr;
+        if (_dataLen) WS2812FX::instance->_segmentMapsEvicted = false; //budget freed, evicted maps may be rebuilt
         WS2812FX::instance->_usedSegmentData -= _dataLen;
         _dataLen = 0;
       }
+      #ifdef WLED_USE_SEGMENT_BUFFER
+      // per-segment frame buffer, holds unscaled effect output in virtual (segment) pixel space
+      uint32_t* pixels = nullptr;
+      uint16_t pixelCount = 0;
+      bool allocatePixels(uint16_t len){
+        if (pixels && pixelCount == len) return true; //already allocated
+        deallocatePixels();
+        if (len == 0) return false;
+        #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_USE_PSRAM)
+        if (psramFound())
+          pixels = (uint32_t*) ps_malloc(len * sizeof(uint32_t));
+        else
+        #endif
+          pixels = (uint32_t*) malloc(len * sizeof(uint32_t));
+        if (!pixels) return false; //allocation failed, effects will write to the busses directly
+        pixelCount = len;
+        memset(pixels, 0, len * sizeof(uint32_t));
+        return true;
+      }
+      void deallocatePixels(){
+        free(pixels);
+        pixels = nullptr;
+        pixelCount = 0;
+      }
+      #endif
+
+      // cached segment address map: mapStride physical pixel indices per virtual pixel (0xFFFF if not set)
+      // only (re)built by WS2812FX::updateSegmentMap() from service(), so it is never freed while in use
+      // counts toward MAX_SEGMENT_DATA
+      uint16_t* map = nullptr;
+      uint16_t mapLen = 0;
+      uint16_t mapStride = 0;
+      void deallocateMap(){
+        if (map) WS2812FX::instance->_segmentMapsEvicted = false; //budget freed, evicted maps may be rebuilt
+        free(map);
+        map = nullptr;
+        WS2812FX::instance->_usedSegmentData -= mapLen * mapStride * sizeof(uint16_t);
+        mapLen = 0;
+        mapStride = 0;
+        _mapValid = false;
+      }
+      // true if the map was built for the current geometry of the segment
+      bool mapIsValid(const Segment& seg) {
+        return _mapValid && _mapStart == seg.start && _mapStop == seg.stop && _mapOffset == seg.offset
+          && _mapGrouping == seg.grouping && _mapSpacing == seg.spacing && _mapOptions == (seg.options & (REVERSE | MIRROR));
+      }
+      void setMapValid(const Segment& seg) {
+        _mapStart = seg.start; _mapStop = seg.stop; _mapOffset = seg.offset;
+        _mapGrouping = seg.grouping; _mapSpacing = seg.spacing; _mapOptions = seg.options & (REVERSE | MIRROR);
+        _mapValid = true;
+      }
+      inline bool hasValidMap() { return map && _mapValid; }
+      // safe to call from network requests, the map is rebuilt before the next frame
+      inline void invalidateMap() { _mapValid = false; }
 
       /** 
        * If reset of this segment was request, clears runtime
@@ -381,6 +444,9 @@ class WS2812FX {
         if (_requiresReset) {
           next_time = 0; step = 0; call = 0; aux0 = 0; aux1 = 0; 
           deallocateData();
+          #ifdef WLED_USE_SEGMENT_BUFFER
+          if (pixels) memset(pixels, 0, pixelCount * sizeof(uint32_t)); //effects start from a black frame
+          #endif
           _requiresReset = false;
         }
       }
@@ -395,6 +461,9 @@ class WS2812FX {
       private:
         uint16_t _dataLen = 0;
         bool _requiresReset = false;
+        bool _mapValid = false;
+        uint16_t _mapStart = 0, _mapStop = 0, _mapOffset = 0;
+        uint8_t _mapGrouping = 0, _mapSpacing = 0, _mapOptions = 0;
     } segment_runtime;
 
     typedef struct ColorTransition { // 12 bytes
@@ -482,6 +551,18 @@ class WS2812FX {
       }
     } color_transition;
 
+    typedef struct PerfStat { // 12 bytes, CPU cycles (ESP.getCycleCount())
+      uint32_t last = 0;
+      uint32_t max = 0;
+      uint32_t avg = 0; //exponentially weighted moving average, newest sample weighs 1/8
+      void add(uint32_t cycles) {
+        last = cycles;
+        if (cycles > max) max = cycles;
+        avg = avg ? avg - (avg >> 3) + (cycles >> 3) : cycles;
+      }
+      void reset() { last = 0; max = 0; avg = 0; }
+    } perf_stat;
+
     WS2812FX() {
       WS2812FX::instance = this;
       //assign each member of the _mode[] array to its respective function reference 
@@ -638,6 +719,7 @@ class WS2812FX {
       fixInvalidSegments(),
       setPixelColor(uint16_t n, uint32_t c),
       setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w = 0),
+      setPixelColors(uint16_t n, uint16_t len, const uint32_t* c),
       show(void),
 			setTargetFps(uint8_t fps),
       deserializeMap(uint8_t n=0);
@@ -693,6 +775,13 @@ class WS2812FX {
       getLastShow(void),
       getPixelColor(uint16_t);
 
+    #ifdef WLED_ENABLE_FX_BENCHMARK
+    uint32_t fixedNow = 0; //if set, service() uses this as effect time instead of millis() + timebase (golden frames)
+    uint32_t heapLow = 0;  //if set, lowest free heap seen while effects run and allocate data (benchmark)
+    inline void sampleHeap() {if (heapLow) {uint32_t h = ESP.getFreeHeap(); if (h < heapLow) heapLow = h;}}
+    void swapLedmap(uint16_t* &table, uint16_t &size); //exchanges the ledmap with a generated one, no file system (benchmark)
+    #endif
+
     WS2812FX::Segment
       &getSegment(uint8_t n),
       &getFirstSelectedSeg(void),
@@ -842,8 +931,14 @@ class WS2812FX {
     bool
       _isOffRefreshRequired = false, //periodic refresh is required for the strip to remain off.
       _hasWhiteChannel = false,
+      _segmentMapsEvicted = false, //address maps gave way to effect data, not rebuilt until segment data is freed
       _triggered;
 
+    volatile bool _isServicing = false; //true while service() renders a frame, see isUpdating()
+    #ifdef ARDUINO_ARCH_ESP32
+    SemaphoreHandle_t _renderMutex = nullptr;
+    #endif
+
     mode_ptr _mode[MODE_COUNT]; // SRAM footprint: 4 bytes per element
 
     show_callback _callback = nullptr;
@@ -887,6 +982,10 @@ class WS2812FX {
 
     uint32_t _colors_t[3];
     uint8_t _bri_t;
+
+    uint32_t _busPowerSum[WLED_MAX_BUSSES] = {0}; //cached power units per bus, see estimateCurrentAndLimitBri()
+    uint16_t _busCurrent[WLED_MAX_BUSSES] = {0};  //estimated mA per bus
+    bool _busPowerWS2815 = false;
     
     uint8_t _segment_index = 0;
     uint8_t _segment_index_palette_last = 99;
@@ -902,13 +1001,41 @@ class WS2812FX {
     ColorTransition transitions[MAX_NUM_TRANSITIONS]; //12 bytes per element
     friend class ColorTransition;
 
+    perf_stat _segmentPerf[MAX_NUM_SEGMENTS]; //effect function time per segment, 12 bytes per element
+    perf_stat _showPerf, _ablPerf, _busShowPerf; //show() total, estimateCurrentAndLimitBri() and busses.show()
+
     uint16_t
       realPixelIndex(uint16_t i),
       transitionProgress(uint8_t tNr);
+
+    void
+      setPixelColorMapped(uint16_t i, uint32_t col),
+      updateSegmentMap(void),
+      freeSegmentMaps(void),
+      mapGroupPixel(uint16_t realIndex, uint8_t j, uint16_t &indexSet, uint16_t &indexMir);
   
   public:
     inline bool hasWhiteChannel(void) {return _hasWhiteChannel;}
     inline bool isOffRefreshRequired(void) {return _isOffRefreshRequired;}
+    inline uint16_t getBusCurrent(uint8_t b) {return (b < WLED_MAX_BUSSES) ? _busCurrent[b] : 0;}
+    inline const perf_stat& getSegmentPerf(uint8_t n) {return _segmentPerf[(n < MAX_NUM_SEGMENTS) ? n : 0];}
+    inline const perf_stat& getShowPerf(void) {return _showPerf;}
+    inline const perf_stat& getABLPerf(void) {return _ablPerf;}
+    inline const perf_stat& getBusShowPerf(void) {return _busShowPerf;}
+    void resetPerf(void);
+
+    // serializes segment/bus changes and reads with rendering (loop() or the render task) and the network tasks, recursive
+    // ESP8266 network callbacks never run concurrently with loop()
+    // taken after the JSON buffer lock, never wait for that one (or access files) while holding this
+    // usermods and userLoop() are called without it and lock around their own segment changes
+    #ifdef ARDUINO_ARCH_ESP32
+    void initRenderLock(void);
+    bool lockRender(uint32_t timeoutMs = UINT32_MAX);
+    void unlockRender(void);
+    #else
+    inline bool lockRender(uint32_t timeoutMs = UINT32_MAX) {return true;}
+    inline void unlockRender(void) {}
+    #endif
 };
 
 //10 names per line
@@ -120,8 +120,12 @@ void WS2812FX::finalizeInit(void)
 void WS2812FX::service() {
   uint32_t nowUp = millis(); // Be aware, millis() rolls over every 49 days
   now = nowUp + timebase;
+  #ifdef WLED_ENABLE_FX_BENCHMARK
+  if (fixedNow) now = fixedNow;
+  #endif
   if (nowUp - _lastShow < MIN_SHOW_DELAY) return;
   bool doShow = false;
+  _isServicing = true;
 
   for(uint8_t i=0; i < MAX_NUM_SEGMENTS; i++)
   {
@@ -131,7 +135,13 @@ void WS2812FX::service() {
     // segment's buffers are cleared
     SEGENV.resetIfRequired();
 
-    if (!SEGMENT.isActive()) continue;
+    if (!SEGMENT.isActive()) {
+      if (SEGENV.map) SEGENV.deallocateMap();
+      #ifdef WLED_USE_SEGMENT_BUFFER
+      SEGENV.deallocatePixels();
+      #endif
+      continue;
+    }
 
     if(nowUp > SEGENV.next_time || _triggered || (doShow && SEGMENT.mode == 0)) //last is temporary
     {
@@ -139,25 +149,57 @@ void WS2812FX::service() {
       doShow = true;
       uint16_t delay = FRAMETIME;
 
+      _virtualSegmentLength = SEGMENT.virtualLength();
+      _bri_t = SEGMENT.opacity; _colors_t[0] = SEGMENT.colors[0]; _colors_t[1] = SEGMENT.colors[1]; _colors_t[2] = SEGMENT.colors[2];
+      uint8_t _cct_t = SEGMENT.cct;
+      if (!IS_SEGMENT_ON) _bri_t = 0;
+      for (uint8_t t = 0; t < MAX_NUM_TRANSITIONS; t++) {
+        if ((transitions[t].segment & 0x3F) != i) continue;
+        uint8_t slot = transitions[t].segment >> 6;
+        if (slot == 0) _bri_t = transitions[t].currentBri();
+        if (slot == 1) _cct_t = transitions[t].currentBri(false, 1);
+        _colors_t[slot] = transitions[t].currentColor(SEGMENT.colors[slot]);
+      }
+      if (!cctFromRgb || correctWB) busses.setSegmentCCT(_cct_t, correctWB);
+      for (uint8_t c = 0; c < 3; c++) _colors_t[c] = gamma32(_colors_t[c]);
+      updateSegmentMap();
+      #ifdef WLED_USE_SEGMENT_BUFFER
+      SEGENV.allocatePixels(_virtualSegmentLength);
+      #endif
+
       if (!SEGMENT.getOption(SEG_OPTION_FREEZE)) { //only run effect function if not frozen
-        _virtualSegmentLength = SEGMENT.virtualLength();
-        _bri_t = SEGMENT.opacity; _colors_t[0] = SEGMENT.colors[0]; _colors_t[1] = SEGMENT.colors[1]; _colors_t[2] = SEGMENT.colors[2];
-        uint8_t _cct_t = SEGMENT.cct;
-        if (!IS_SEGMENT_ON) _bri_t = 0;
-        for (uint8_t t = 0; t < MAX_NUM_TRANSITIONS; t++) {
-          if ((transitions[t].segment & 0x3F) != i) continue;
-          uint8_t slot = transitions[t].segment >> 6;
-          if (slot == 0) _bri_t = transitions[t].currentBri();
-          if (slot == 1) _cct_t = transitions[t].currentBri(false, 1);
-          _colors_t[slot] = transitions[t].currentColor(SEGMENT.colors[slot]);
-        }
-        if (!cctFromRgb || correctWB) busses.setSegmentCCT(_cct_t, correctWB);
-        for (uint8_t c = 0; c < 3; c++) _colors_t[c] = gamma32(_colors_t[c]);
         handle_palette();
+        uint32_t cycles = ESP.getCycleCount();
         delay = (this->*_mode[SEGMENT.mode])(); //effect function
+        _segmentPerf[i].add(ESP.getCycleCount() - cycles);
+        #ifdef WLED_ENABLE_FX_BENCHMARK
+        sampleHeap(); //temporary buffers of the effect are still allocated here
+        #endif
         if (SEGMENT.mode != FX_MODE_HALLOWEEN_EYES) SEGENV.call++;
       }
 
+      #ifdef WLED_USE_SEGMENT_BUFFER
+      //write the segment frame out to the busses in one pass (frozen segments too, their buffer may have been set via JSON)
+      if (SEGENV.pixels) {
+        if (SEGMENT.groupLength() == 1 && !SEGMENT.offset && !IS_REVERSE && !IS_MIRROR && !customMappingSize) {
+          //1:1 mapping, pass the frame on as a whole or in spans with opacity applied
+          if (_bri_t == 255) {
+            busses.setPixelColors(SEGMENT.start, SEGENV.pixelCount, SEGENV.pixels);
+          } else {
+            uint32_t span[32];
+            for (uint16_t p = 0; p < SEGENV.pixelCount; p += 32) {
+              uint16_t n = SEGENV.pixelCount - p;
+              if (n > 32) n = 32;
+              colorFadeSpan(SEGENV.pixels + p, span, n, _bri_t);
+              busses.setPixelColors(SEGMENT.start + p, n, span);
+            }
+          }
+        } else {
+          for (uint16_t p = 0; p < SEGENV.pixelCount; p++) setPixelColorMapped(p, SEGENV.pixels[p]);
+        }
+      }
+      #endif
+
       SEGENV.next_time = nowUp + delay;
     }
   }
@@ -168,6 +210,7 @@ void WS2812FX::service() {
     show();
   }
   _triggered = false;
+  _isServicing = false;
 }
 
 void IRAM_ATTR WS2812FX::setPixelColor(uint16_t n, uint32_t c) {
@@ -195,45 +238,140 @@ uint16_t IRAM_ATTR WS2812FX::realPixelIndex(uint16_t i) {
 void IRAM_ATTR WS2812FX::setPixelColor(uint16_t i, byte r, byte g, byte b, byte w)
 {
   if (SEGLEN) {//from segment
-    uint16_t realIndex = realPixelIndex(i);
-    uint16_t len = SEGMENT.length();
-
-    //color_blend(getpixel, col, _bri_t); (pseudocode for future blending of segments)
-    if (_bri_t < 255) {  
-      r = scale8(r, _bri_t);
-      g = scale8(g, _bri_t);
-      b = scale8(b, _bri_t);
-      w = scale8(w, _bri_t);
-    }
-    uint32_t col = RGBW32(r, g, b, w);
-
-    /* Set all the pixels in the group */
-    for (uint16_t j = 0; j < SEGMENT.grouping; j++) {
-      uint16_t indexSet = realIndex + (IS_REVERSE ? -j : j);
-      if (indexSet >= SEGMENT.start && indexSet < SEGMENT.stop) {
-        if (IS_MIRROR) { //set the corresponding mirrored pixel
-          uint16_t indexMir = SEGMENT.stop - indexSet + SEGMENT.start - 1;
-          /* offset/phase */
-          indexMir += SEGMENT.offset;
-          if (indexMir >= SEGMENT.stop) indexMir -= len;
-
-          if (indexMir < customMappingSize) indexMir = customMappingTable[indexMir];
-          busses.setPixelColor(indexMir, col);
-        }
-        /* offset/phase */
-        indexSet += SEGMENT.offset;
-        if (indexSet >= SEGMENT.stop) indexSet -= len;
-
-        if (indexSet < customMappingSize) indexSet = customMappingTable[indexSet];
-        busses.setPixelColor(indexSet, col);
-      }
+    #ifdef WLED_USE_SEGMENT_BUFFER
+    if (SEGENV.pixels) {
+      if (i < SEGENV.pixelCount) SEGENV.pixels[i] = RGBW32(r, g, b, w);
+      if (_isServicing) return; //written out to the busses once the effect has finished rendering the frame
+      //outside of service() (setPixelSegment(), usermods) the pixel goes to the busses as well, the next frame may be far off
     }
+    #endif
+    setPixelColorMapped(i, RGBW32(r, g, b, w));
   } else { //live data, etc.
     if (i < customMappingSize) i = customMappingTable[i];
     busses.setPixelColor(i, RGBW32(r, g, b, w));
   }
 }
 
+//live data: sets len consecutive physical pixels, passed on to the busses as one run unless a ledmap is active
+void WS2812FX::setPixelColors(uint16_t n, uint16_t len, const uint32_t* c)
+{
+  if (customMappingSize) {
+    for (uint16_t i = 0; i < len; i++) {
+      uint16_t pix = n + i;
+      if (pix < customMappingSize) pix = customMappingTable[pix];
+      busses.setPixelColor(pix, c[i]);
+    }
+    return;
+  }
+  busses.setPixelColors(n, len, c);
+}
+
+//applies segment brightness and maps a virtual segment pixel to its physical pixels (grouping, spacing, reverse, mirror, offset, ledmap)
+void IRAM_ATTR WS2812FX::setPixelColorMapped(uint16_t i, uint32_t col)
+{
+  //color_blend(getpixel, col, _bri_t); (pseudocode for future blending of segments)
+  if (_bri_t < 255) col = colorFade(col, _bri_t);
+
+  if (SEGENV.hasValidMap()) { //precomputed addresses, see updateSegmentMap()
+    if (i >= SEGENV.mapLen) return;
+    const uint16_t* m = SEGENV.map + i * SEGENV.mapStride;
+    for (uint16_t j = 0; j < SEGENV.mapStride; j++) {
+      if (m[j] != 0xFFFF) busses.setPixelColor(m[j], col);
+    }
+    return;
+  }
+
+  uint16_t realIndex = realPixelIndex(i);
+
+  /* Set all the pixels in the group */
+  for (uint16_t j = 0; j < SEGMENT.grouping; j++) {
+    uint16_t indexSet, indexMir;
+    mapGroupPixel(realIndex, j, indexSet, indexMir);
+    if (indexMir != 0xFFFF) busses.setPixelColor(indexMir, col);
+    if (indexSet != 0xFFFF) busses.setPixelColor(indexSet, col);
+  }
+}
+
+//physical index of pixel j of the group starting at realIndex, and of its mirrored pixel (0xFFFF if none)
+void IRAM_ATTR WS2812FX::mapGroupPixel(uint16_t realIndex, uint8_t j, uint16_t &indexSet, uint16_t &indexMir)
+{
+  uint16_t len = SEGMENT.length();
+  indexMir = 0xFFFF;
+  indexSet = realIndex + (IS_REVERSE ? -j : j);
+  if (indexSet < SEGMENT.start || indexSet >= SEGMENT.stop) {
+    indexSet = 0xFFFF;
+    return;
+  }
+  if (IS_MIRROR) { //set the corresponding mirrored pixel
+    indexMir = SEGMENT.stop - indexSet + SEGMENT.start - 1;
+    /* offset/phase */
+    indexMir += SEGMENT.offset;
+    if (indexMir >= SEGMENT.stop) indexMir -= len;
+
+    if (indexMir < customMappingSize) indexMir = customMappingTable[indexMir];
+  }
+  /* offset/phase */
+  indexSet += SEGMENT.offset;
+  if (indexSet >= SEGMENT.stop) indexSet -= len;
+
+  if (indexSet < customMappingSize) indexSet = customMappingTable[indexSet];
+}
+
+//rebuilds the virtual to physical address map of the current segment if its geometry or the ledmap has changed
+//must only be called from service(), as the old map is freed
+void WS2812FX::updateSegmentMap()
+{
+  if (SEGENV.mapIsValid(SEGMENT)) return;
+  SEGENV.deallocateMap();
+  if (_segmentMapsEvicted) return; //slow path until segment data is freed, see deallocateData()
+
+  uint16_t vLen = SEGMENT.virtualLength();
+  uint16_t stride = SEGMENT.grouping * (IS_MIRROR ? 2 : 1);
+  uint32_t entries = (uint32_t)vLen * stride;
+  uint32_t bytes = entries * sizeof(uint16_t);
+  if (entries && _usedSegmentData + bytes <= MAX_SEGMENT_DATA
+    #ifdef ESP8266
+    && ESP.getFreeHeap() > bytes + MIN_HEAP_SIZE //only a speedup, not worth running low on heap
+    #endif
+  ) {
+    SEGENV.map = (uint16_t*) malloc(bytes);
+  }
+  if (entries && !SEGENV.map) { //no room, use the slow path until segment data is freed
+    _segmentMapsEvicted = true;
+    return;
+  }
+  if (SEGENV.map) {
+    _usedSegmentData += bytes;
+    SEGENV.mapLen = vLen;
+    SEGENV.mapStride = stride;
+    for (uint16_t i = 0; i < vLen; i++) {
+      uint16_t realIndex = realPixelIndex(i);
+      uint16_t* m = SEGENV.map + i * stride;
+      for (uint16_t j = 0; j < SEGMENT.grouping; j++) {
+        if (IS_MIRROR) {
+          mapGroupPixel(realIndex, j, m[1], m[0]); //mirrored pixel is set first
+          m += 2;
+        } else {
+          uint16_t indexMir;
+          mapGroupPixel(realIndex, j, *m, indexMir);
+          m++;
+        }
+      }
+    }
+  }
+  SEGENV.setMapValid(SEGMENT);
+}
+
+//frees all address maps to make room for effect data, the segments use the slow path until segment data is freed again
+//must only be called from service() (allocateData() of an effect)
+void WS2812FX::freeSegmentMaps()
+{
+  for (uint8_t i = 0; i < MAX_NUM_SEGMENTS; i++) {
+    if (_segment_runtimes[i].map) _segment_runtimes[i].deallocateMap();
+  }
+  _segmentMapsEvicted = true;
+}
+
 
 //DISCLAIMER
 //The following function attemps to calculate the current LED power usage,
@@ -261,6 +399,7 @@ void WS2812FX::estimateCurrentAndLimitBri() {
 
   if (ablMilliampsMax < 150 || actualMilliampsPerLed == 0) { //0 mA per LED and too low numbers turn off calculation
     currentMilliamps = 0;
+    memset(_busCurrent, 0, sizeof(_busCurrent));
     busses.setBrightness(_brightness);
     return;
   }
@@ -276,38 +415,46 @@ void WS2812FX::estimateCurrentAndLimitBri() {
 
   uint32_t powerSum = 0;
 
-  for (uint8_t b = 0; b < busses.getNumBusses(); b++) {
+  uint8_t numBusses = busses.getNumBusses();
+  for (uint8_t b = 0; b < numBusses; b++) {
     Bus *bus = busses.getBus(b);
     if (bus->getType() >= TYPE_NET_DDP_RGB) continue; //exclude non-physical network busses
-    uint16_t len = bus->getLength();
-    uint32_t busPowerSum = 0;
-    for (uint16_t i = 0; i < len; i++) { //sum up the usage of each LED
-      uint32_t c = bus->getPixelColor(i);
-      byte r = R(c), g = G(c), b = B(c), w = W(c);
-
-      if(useWackyWS2815PowerModel) { //ignore white component on WS2815 power calculation
-        busPowerSum += (MAX(MAX(r,g),b)) * 3;
-      } else {
-        busPowerSum += (r + g + b + w);
+    //only read back busses that were written to since the last estimate, unchanged busses keep their sum
+    if (busses.isChanged(b) || useWackyWS2815PowerModel != _busPowerWS2815) {
+      uint16_t len = bus->getLength();
+      uint32_t busPowerSum = 0;
+      for (uint16_t i = 0; i < len; i++) { //sum up the usage of each LED
+        uint32_t c = bus->getPixelColor(i);
+        byte r = R(c), g = G(c), b = B(c), w = W(c);
+
+        if(useWackyWS2815PowerModel) { //ignore white component on WS2815 power calculation
+          busPowerSum += (MAX(MAX(r,g),b)) * 3;
+        } else {
+          busPowerSum += (r + g + b + w);
+        }
       }
-    }
 
-    if (bus->isRgbw()) { //RGBW led total output with white LEDs enabled is still 50mA, so each channel uses less
-      busPowerSum *= 3;
-      busPowerSum = busPowerSum >> 2; //same as /= 4
+      if (bus->isRgbw()) { //RGBW led total output with white LEDs enabled is still 50mA, so each channel uses less
+        busPowerSum *= 3;
+        busPowerSum = busPowerSum >> 2; //same as /= 4
+      }
+      _busPowerSum[b] = busPowerSum;
+      busses.clearChanged(b);
     }
-    powerSum += busPowerSum;
+    powerSum += _busPowerSum[b];
   }
+  _busPowerWS2815 = useWackyWS2815PowerModel;
 
   uint32_t powerSum0 = powerSum;
   powerSum *= _brightness;
+  uint8_t newBri = _brightness;
   
   if (powerSum > powerBudget) //scale brightness down to stay in current limit
   {
     float scale = (float)powerBudget / (float)powerSum;
     uint16_t scaleI = scale * 255;
     uint8_t scaleB = (scaleI > 255) ? 255 : scaleI;
-    uint8_t newBri = scale8(_brightness, scaleB);
+    newBri = scale8(_brightness, scaleB);
     busses.setBrightness(newBri); //to keep brightness uniform, sets virtual busses too
     currentMilliamps = (powerSum0 * newBri) / puPerMilliamp;
   } else {
@@ -316,20 +463,36 @@ void WS2812FX::estimateCurrentAndLimitBri() {
   }
   currentMilliamps += MA_FOR_ESP; //add power of ESP back to estimate
   currentMilliamps += pLen; //add standby power back to estimate
+
+  //per bus estimate (including standby power, excluding the ESP)
+  for (uint8_t b = 0; b < WLED_MAX_BUSSES; b++) {
+    Bus *bus = busses.getBus(b);
+    if (bus == nullptr || bus->getType() >= TYPE_NET_DDP_RGB) {
+      _busCurrent[b] = 0;
+      continue;
+    }
+    _busCurrent[b] = (_busPowerSum[b] * newBri) / puPerMilliamp + bus->getLength();
+  }
 }
 
 void WS2812FX::show(void) {
+  uint32_t cyclesShow = ESP.getCycleCount();
 
   // avoid race condition, caputre _callback value
   show_callback callback = _callback;
   if (callback) callback();
 
+  uint32_t cycles = ESP.getCycleCount();
   estimateCurrentAndLimitBri();
+  _ablPerf.add(ESP.getCycleCount() - cycles);
   
   // some buses send asynchronously and this method will return before
   // all of the data has been sent.
   // See https://github.com/Makuna/NeoPixelBus/wiki/ESP32-NeoMethods#neoesp32rmt-methods
+  cycles = ESP.getCycleCount();
   busses.show();
+  _busShowPerf.add(ESP.getCycleCount() - cycles);
+  _showPerf.add(ESP.getCycleCount() - cyclesShow);
   unsigned long now = millis();
   unsigned long diff = now - _lastShow;
   uint16_t fpsCurr = 200;
@@ -338,14 +501,41 @@ void WS2812FX::show(void) {
   _lastShow = now;
 }
 
+//clears the render time statistics reported in the "perf" info object
+void WS2812FX::resetPerf() {
+  for (uint8_t i = 0; i < MAX_NUM_SEGMENTS; i++) _segmentPerf[i].reset();
+  _showPerf.reset();
+  _ablPerf.reset();
+  _busShowPerf.reset();
+}
+
 /**
  * Returns a true value if any of the strips are still being updated.
  * On some hardware (ESP32), strip updates are done asynchronously.
+ * Also true while service() renders a frame, e.g. in the render task (WLED_ENABLE_RENDER_TASK).
  */
 bool WS2812FX::isUpdating() {
-  return !busses.canAllShow();
+  return _isServicing || !busses.canAllShow();
 }
 
+#ifdef ARDUINO_ARCH_ESP32
+//called first thing in setup(), before any task could use the lock
+void WS2812FX::initRenderLock() {
+  if (_renderMutex == nullptr) _renderMutex = xSemaphoreCreateRecursiveMutex();
+}
+
+//blocks until the current frame is rendered or the segments are no longer changed, returns false on timeout
+bool WS2812FX::lockRender(uint32_t timeoutMs) {
+  if (_renderMutex == nullptr) return true; //not created yet (setup() not started)
+  TickType_t ticks = (timeoutMs == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+  return xSemaphoreTakeRecursive(_renderMutex, ticks) == pdTRUE;
+}
+
+void WS2812FX::unlockRender() {
+  if (_renderMutex) xSemaphoreGiveRecursive(_renderMutex);
+}
+#endif
+
 /**
  * Returns the refresh rate of the LED strip. Useful for finding out whether a given setup is fast enough.
  * Only updates on show() or is set to 0 fps if last show is more than 2 secs ago, so accurary varies
@@ -488,6 +678,14 @@ uint8_t WS2812FX::getActiveSegmentsNum(void) {
 
 uint32_t WS2812FX::getPixelColor(uint16_t i)
 {
+  #ifdef WLED_USE_SEGMENT_BUFFER
+  //effects read back their own unscaled output instead of the brightness-scaled bus state
+  if (SEGLEN && SEGENV.pixels) return (i < SEGENV.pixelCount) ? SEGENV.pixels[i] : 0;
+  #endif
+  if (SEGLEN && SEGENV.hasValidMap() && i < SEGENV.mapLen) {
+    uint16_t p = SEGENV.map[i * SEGENV.mapStride + (IS_MIRROR ? 1 : 0)];
+    if (p != 0xFFFF) return (p < _length) ? busses.getPixelColor(p) : 0;
+  }
   i = realPixelIndex(i);
 
   if (SEGLEN) {
@@ -557,6 +755,7 @@ uint8_t WS2812FX::Segment::differs(Segment& b) {
   {
     if (colors[i] != b.colors[i]) d |= SEG_DIFFERS_COL;
   }
+  if (cct != b.cct) d |= SEG_DIFFERS_COL;
 
   return d;
 }
@@ -652,6 +851,7 @@ void WS2812FX::setSegment(uint8_t n, uint16_t i1, uint16_t i2, uint8_t grouping,
   }
 	if (offset < UINT16_MAX) seg.offset = offset;
   _segment_runtimes[n].markForReset();
+  _segment_runtimes[n].invalidateMap();
 }
 
 void WS2812FX::restartRuntime() {
@@ -769,6 +969,7 @@ uint8_t WS2812FX::setPixelSegment(uint8_t n)
   if (n < MAX_NUM_SEGMENTS) {
     _segment_index = n;
     _virtualSegmentLength = SEGMENT.virtualLength();
+    if (!SEGENV.mapIsValid(SEGMENT)) SEGENV.invalidateMap(); //fall back to the slow path until the next frame
   }
   return prevSegId;
 }
@@ -1148,9 +1349,12 @@ void WS2812FX::deserializeMap(uint8_t n) {
   if (!isFile) {
     // erase custom mapping if selecting nonexistent ledmap.json (n==0)
     if (!n && customMappingTable != nullptr) {
+      lockRender();
+      for (uint8_t i = 0; i < MAX_NUM_SEGMENTS; i++) _segment_runtimes[i].invalidateMap();
       customMappingSize = 0;
       delete[] customMappingTable;
       customMappingTable = nullptr;
+      unlockRender();
     }
     return;
   }
@@ -1169,24 +1373,43 @@ void WS2812FX::deserializeMap(uint8_t n) {
     return; //if file does not exist just exit
   }
 
-  // erase old custom ledmap
-  if (customMappingTable != nullptr) {
-    customMappingSize = 0;
-    delete[] customMappingTable;
-    customMappingTable = nullptr;
-  }
-
+  // the new map is built before the render lock is taken, only swapping it stops rendering
+  uint16_t* newTable = nullptr;
+  uint16_t newSize = 0;
   JsonArray map = doc[F("map")];
   if (!map.isNull() && map.size()) {  // not an empty map
-    customMappingSize  = map.size();
-    customMappingTable = new uint16_t[customMappingSize];
-    for (uint16_t i=0; i<customMappingSize; i++) {
-      customMappingTable[i] = (uint16_t) map[i];
+    newSize  = map.size();
+    newTable = new uint16_t[newSize];
+    for (uint16_t i=0; i<newSize; i++) {
+      newTable[i] = (uint16_t) map[i];
     }
   }
-
   releaseJSONBufferLock();
+
+  lockRender();
+  for (uint8_t i = 0; i < MAX_NUM_SEGMENTS; i++) _segment_runtimes[i].invalidateMap();
+
+  // replace old custom ledmap
+  delete[] customMappingTable;
+  customMappingTable = newTable;
+  customMappingSize  = newSize;
+  unlockRender();
+}
+
+#ifdef WLED_ENABLE_FX_BENCHMARK
+//installs the given ledmap and hands back the previous one, the caller owns it afterwards
+void WS2812FX::swapLedmap(uint16_t* &table, uint16_t &size) {
+  lockRender();
+  for (uint8_t i = 0; i < MAX_NUM_SEGMENTS; i++) _segment_runtimes[i].invalidateMap();
+  uint16_t* oldTable = customMappingTable;
+  uint16_t  oldSize  = customMappingSize;
+  customMappingTable = table;
+  customMappingSize  = table ? size : 0;
+  table = oldTable;
+  size  = oldSize;
+  unlockRender();
 }
+#endif
 
 //gamma 2.8 lookup table used for color correction
 byte gammaT[] = {
@@ -23,8 +23,19 @@ struct NodeStruct
   uint8_t   age;
   uint8_t   nodeType;
   uint32_t  build;
+  // node time sync (see timesync.cpp)
+  bool      timeSync;       // node answers time sync requests
+  uint8_t   timeSource;     // toki time source of the node
+  uint8_t   timeFailed;     // consecutive unanswered requests
+  uint32_t  timeRequest;    // micros() the pending request was sent, 0 if none
+  int32_t   timeOffset;     // us, effect time of the node minus ours
+  uint32_t  timeJitter;     // us, average change of the clock offset between samples
+  uint32_t  timeRtt;        // us, round trip of the last accepted sample
+  uint32_t  timeRttMin;     // us, lowest recent round trip
+  int32_t   timeClock;      // us, micros() of the node minus ours at the last accepted sample
 
-  NodeStruct() : age(0), nodeType(0), build(0)
+  NodeStruct() : age(0), nodeType(0), build(0), timeSync(false), timeSource(0), timeFailed(0),
+                 timeRequest(0), timeOffset(0), timeJitter(0), timeRtt(0), timeRttMin(0), timeClock(0)
   {
     for (uint8_t i = 0; i < 4; ++i) { ip[i] = 0; }
   }
@@ -77,6 +77,7 @@ void onAlexaChange(EspalexaDevice* dev)
 			if (!ct) return;
 			uint16_t k = 1000000 / ct; //mireds to kelvin
 			
+			strip.lockRender();
 			if (strip.hasCCTBus()) {
 				strip.setCCT(k);
 				rgbw[0]= 0; rgbw[1]= 0; rgbw[2]= 0; rgbw[3]= 255;
@@ -93,9 +94,12 @@ void onAlexaChange(EspalexaDevice* dev)
         colorKtoRGB(k, rgbw);
       }
       strip.setColor(0, rgbw[0], rgbw[1], rgbw[2], rgbw[3]);
+      strip.unlockRender();
     } else {
       uint32_t color = espalexaDevice->getRGB();
+      strip.lockRender();
       strip.setColor(0, color);
+      strip.unlockRender();
     }
     stateUpdated(CALL_MODE_ALEXA);
   }
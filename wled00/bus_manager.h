@@ -6,8 +6,10 @@
  */
 
 #include "const.h"
+#ifndef WLED_BUS_MEMORY_ONLY //native test env (test/native), BusMemory is the only bus type
 #include "pin_manager.h"
 #include "bus_wrapper.h"
+#endif
 #include <Arduino.h>
 
 //colors.cpp
@@ -49,6 +51,7 @@ struct BusConfig {
   uint8_t skipAmount;
   bool refreshReq;
   uint8_t pins[5] = {LEDPIN, 255, 255, 255, 255};
+  uint16_t universe = 0; // first universe of E1.31/ArtNet network busses (0: default, 1 for E1.31)
   BusConfig(uint8_t busType, uint8_t* ppins, uint16_t pstart, uint16_t len = 1, uint8_t pcolorOrder = COL_ORDER_GRB, bool rev = false, uint8_t skip = 0) {
     refreshReq = (bool) GET_BIT(busType,7);
     type = busType & 0x7F;  // bit 7 may be/is hacked to include refresh info (1=refresh in off state, 0=no refresh)
@@ -143,6 +146,7 @@ class Bus {
     virtual bool     canShow() { return true; }
 		virtual void     setStatusPixel(uint32_t c) {}
     virtual void     setPixelColor(uint16_t pix, uint32_t c) {}
+    virtual void     setPixelColors(uint16_t pix, uint16_t len, const uint32_t* c) { for (uint16_t i = 0; i < len; i++) setPixelColor(pix + i, c[i]); }
     virtual uint32_t getPixelColor(uint16_t pix) { return 0; }
     virtual void     setBrightness(uint8_t b) {}
     virtual void     cleanup() {}
@@ -151,6 +155,7 @@ class Bus {
     virtual void     setColorOrder() {}
     virtual uint8_t  getColorOrder() { return COL_ORDER_RGB; }
     virtual uint8_t  skippedLeds() { return 0; }
+    virtual uint16_t getUniverse() { return 0; }
     inline  uint16_t getStart() { return _start; }
     inline  void     setStart(uint16_t start) { _start = start; }
     inline  uint8_t  getType() { return _type; }
@@ -158,6 +163,15 @@ class Bus {
     inline  bool     isOffRefreshRequired() { return _needsRefresh; }
             bool     containsPixel(uint16_t pix) { return pix >= _start && pix < _start+_len; }
 
+    //configuration to create the same bus again
+    BusConfig getConfig() {
+      uint8_t pins[5] = {255, 255, 255, 255, 255};
+      getPins(pins);
+      BusConfig bc(_type | (_needsRefresh << 7), pins, _start, getLength(), getColorOrder(), reversed, skippedLeds());
+      bc.universe = getUniverse();
+      return bc;
+    }
+
     virtual bool isRgbw() { return Bus::isRgbw(_type); }
     static  bool isRgbw(uint8_t type) {
       if (type == TYPE_SK6812_RGBW || type == TYPE_TM1814) return true;
@@ -206,6 +220,7 @@ class Bus {
 };
 
 
+#ifndef WLED_BUS_MEMORY_ONLY
 class BusDigital : public Bus {
   public:
   BusDigital(BusConfig &bc, uint8_t nr, const ColorOrderMap &com) : Bus(bc.type, bc.start), _colorOrderMap(com) {
@@ -266,6 +281,19 @@ class BusDigital : public Bus {
     PolyBus::setPixelColor(_busPtr, _iType, pix, c, _colorOrderMap.getPixelColorOrder(pix+_start, _colorOrder));
   }
 
+  //same as setPixelColor() for a run of pixels, per-bus checks are only done once
+  void setPixelColors(uint16_t pix, uint16_t len, const uint32_t* c) {
+    bool awc = (_type == TYPE_SK6812_RGBW || _type == TYPE_TM1814);
+    bool cctc = (_cct >= 1900);
+    for (uint16_t i = 0; i < len; i++, pix++) {
+      uint32_t col = c[i];
+      if (awc) col = autoWhiteCalc(col);
+      if (cctc) col = colorBalanceFromKelvin(_cct, col); //color correction from CCT
+      uint16_t p = reversed ? _len - pix -1 : pix + _skip;
+      PolyBus::setPixelColor(_busPtr, _iType, p, col, _colorOrderMap.getPixelColorOrder(p+_start, _colorOrder));
+    }
+  }
+
   uint32_t getPixelColor(uint16_t pix) {
     if (reversed) pix = _len - pix -1;
     else pix += _skip;
@@ -505,6 +533,7 @@ class BusNetwork : public Bus {
       memset(_data, 0, bc.count * _UDPchannels);
       _len = bc.count;
       _client = IPAddress(bc.pins[0],bc.pins[1],bc.pins[2],bc.pins[3]);
+      _universe = (_UDPtype == 1 && !bc.universe) ? 1 : bc.universe; //sACN universes start at 1
       _broadcastLock = false;
       _valid = true;
     };
@@ -529,7 +558,7 @@ class BusNetwork : public Bus {
   void show() {
     if (!_valid || !canShow()) return;
     _broadcastLock = true;
-    realtimeBroadcast(_UDPtype, _client, _len, _data, _bri, _rgbw);
+    realtimeBroadcast(_UDPtype, _client, _len, _data, _bri, _rgbw, &_udp, &_stats, _universe, &_sequence);
     _broadcastLock = false;
   }
 
@@ -557,11 +586,20 @@ class BusNetwork : public Bus {
     return _len;
   }
 
+  inline uint16_t getUniverse() {
+    return _universe;
+  }
+
+  inline const RealtimeOutStats& getStats() {
+    return _stats;
+  }
+
   void cleanup() {
     _type = I_NONE;
     _valid = false;
     if (_data != nullptr) free(_data);
     _data = nullptr;
+    _udp.stop();
   }
 
   ~BusNetwork() {
@@ -569,7 +607,11 @@ class BusNetwork : public Bus {
   }
 
   private:
+    WiFiUDP   _udp; //kept open between frames
+    RealtimeOutStats _stats;
     IPAddress _client;
+    uint16_t  _universe;
+    uint8_t   _sequence = 0; //E1.31/ArtNet, per bus so receivers see every universe count up by one per frame
     uint8_t   _bri = 255;
     uint8_t   _UDPtype;
     uint8_t   _UDPchannels;
@@ -577,6 +619,57 @@ class BusNetwork : public Bus {
     bool      _broadcastLock;
     byte     *_data;
 };
+#endif
+
+
+//bus without any output, pixels are only kept in RAM. Used to benchmark effects
+class BusMemory : public Bus {
+  public:
+  BusMemory(BusConfig &bc) : Bus(bc.type, bc.start) {
+    _len = bc.count;
+    _data = (uint32_t*) malloc(_len * sizeof(uint32_t));
+    if (_data == nullptr) return;
+    memset(_data, 0, _len * sizeof(uint32_t));
+    _valid = true;
+  }
+
+  void setPixelColor(uint16_t pix, uint32_t c) {
+    if (!_valid || pix >= _len) return;
+    _data[pix] = c;
+  }
+
+  void setPixelColors(uint16_t pix, uint16_t len, const uint32_t* c) {
+    if (!_valid || pix >= _len) return;
+    if (pix + len > _len) len = _len - pix;
+    memcpy(_data + pix, c, len * sizeof(uint32_t));
+  }
+
+  uint32_t getPixelColor(uint16_t pix) {
+    if (!_valid || pix >= _len) return 0;
+    return _data[pix];
+  }
+
+  inline void setBrightness(uint8_t b) {
+    _bri = b;
+  }
+
+  inline const uint32_t* getPixels() {
+    return _data;
+  }
+
+  void cleanup() {
+    _valid = false;
+    free(_data);
+    _data = nullptr;
+  }
+
+  ~BusMemory() {
+    cleanup();
+  }
+
+  private:
+    uint32_t *_data = nullptr;
+};
 
 
 class BusManager {
@@ -609,14 +702,24 @@ class BusManager {
   
   int add(BusConfig &bc) {
     if (numBusses >= WLED_MAX_BUSSES) return -1;
+    #ifdef WLED_BUS_MEMORY_ONLY
+    if (bc.type != TYPE_RESERVED) return -1;
+    busses[numBusses] = new BusMemory(bc);
+    #else
     if (bc.type >= TYPE_NET_DDP_RGB && bc.type < 96) {
       busses[numBusses] = new BusNetwork(bc);
+    } else if (bc.type == TYPE_RESERVED) {
+      busses[numBusses] = new BusMemory(bc);
     } else if (IS_DIGITAL(bc.type)) {
       busses[numBusses] = new BusDigital(bc, numBusses, colorOrderMap);
     } else {
       busses[numBusses] = new BusPwm(bc);
     }
-    return numBusses++;
+    #endif
+    numBusses++;
+    buildBusMap();
+    changedBusses = 0xFFFFFFFF;
+    return numBusses -1;
   }
 
   //do not call this method from system context (network callback)
@@ -626,6 +729,8 @@ class BusManager {
     while (!canAllShow()) yield();
     for (uint8_t i = 0; i < numBusses; i++) delete busses[i];
     numBusses = 0;
+    buildBusMap();
+    changedBusses = 0xFFFFFFFF;
   }
 
   void show() {
@@ -641,11 +746,34 @@ class BusManager {
 	}
 
   void IRAM_ATTR setPixelColor(uint16_t pix, uint32_t c, int16_t cct=-1) {
+    if (busMap) {
+      if (pix >= busMapLen || busMap[pix] >= numBusses) return;
+      Bus* b = busses[busMap[pix]];
+      b->setPixelColor(pix - b->getStart(), c);
+      changedBusses |= (1 << busMap[pix]);
+      return;
+    }
     for (uint8_t i = 0; i < numBusses; i++) {
       Bus* b = busses[i];
       uint16_t bstart = b->getStart();
       if (pix < bstart || pix >= bstart + b->getLength()) continue;
       busses[i]->setPixelColor(pix - bstart, c);
+      changedBusses |= (1 << i);
+    }
+  }
+
+  //sets len consecutive pixels starting at pix, each bus receives its part of the run in one call
+  void setPixelColors(uint16_t pix, uint16_t len, const uint32_t* c) {
+    uint32_t end = (uint32_t)pix + len;
+    for (uint8_t i = 0; i < numBusses; i++) {
+      Bus* b = busses[i];
+      uint32_t bstart = b->getStart();
+      uint32_t bend = bstart + b->getLength();
+      uint32_t from = (pix > bstart) ? pix : bstart;
+      uint32_t to = (end < bend) ? end : bend;
+      if (from >= to) continue;
+      b->setPixelColors(from - bstart, to - from, c + (from - pix));
+      changedBusses |= (1 << i);
     }
   }
 
@@ -665,6 +793,11 @@ class BusManager {
   }
 
   uint32_t getPixelColor(uint16_t pix) {
+    if (busMap) {
+      if (pix >= busMapLen || busMap[pix] >= numBusses) return 0;
+      Bus* b = busses[busMap[pix]];
+      return b->getPixelColor(pix - b->getStart());
+    }
     for (uint8_t i = 0; i < numBusses; i++) {
       Bus* b = busses[i];
       uint16_t bstart = b->getStart();
@@ -674,6 +807,15 @@ class BusManager {
     return 0;
   }
 
+  //true if pixels of the bus were set since the last clearChanged() call
+  inline bool isChanged(uint8_t busNr) {
+    return (changedBusses >> busNr) & 0x01;
+  }
+
+  inline void clearChanged(uint8_t busNr) {
+    changedBusses &= ~(1 << busNr);
+  }
+
   bool canAllShow() {
     for (uint8_t i = 0; i < numBusses; i++) {
       if (!busses[i]->canShow()) return false;
@@ -709,5 +851,38 @@ class BusManager {
   uint8_t numBusses = 0;
   Bus* busses[WLED_MAX_BUSSES];
   ColorOrderMap colorOrderMap;
+  uint32_t changedBusses = 0xFFFFFFFF; //bit set for each bus written to, used by the power estimation
+  uint8_t* busMap = nullptr; //index of the bus driving each pixel, 0xFF if none
+  uint16_t busMapLen = 0;
+
+  //builds the pixel to bus lookup table used by set/getPixelColor()
+  //if busses overlap, a pixel has to go to all of them, so the linear search is kept
+  void buildBusMap() {
+    free(busMap);
+    busMap = nullptr;
+    busMapLen = 0;
+    uint16_t len = 0;
+    for (uint8_t i = 0; i < numBusses; i++) {
+      uint16_t bend = busses[i]->getStart() + busses[i]->getLength();
+      if (bend > len) len = bend;
+    }
+    if (len == 0 || len > MAX_LEDS) return;
+    busMap = (uint8_t*) malloc(len);
+    if (busMap == nullptr) return; //fall back to linear search
+    memset(busMap, 0xFF, len);
+    for (uint8_t i = 0; i < numBusses; i++) {
+      uint16_t bstart = busses[i]->getStart();
+      uint16_t bend = bstart + busses[i]->getLength();
+      for (uint16_t p = bstart; p < bend; p++) {
+        if (busMap[p] != 0xFF) { //overlapping busses
+          free(busMap);
+          busMap = nullptr;
+          return;
+        }
+        busMap[p] = i;
+      }
+    }
+    busMapLen = len;
+  }
 };
 #endif
@@ -173,12 +173,14 @@ void handleAnalog(uint8_t b)
     } else {
       // otherwise use "double press" for segment selection
       WS2812FX::Segment& seg = strip.getSegment(macroDoublePress[b]);
+      strip.lockRender();
       if (aRead == 0) {
         seg.setOption(SEG_OPTION_ON, 0); // off
       } else {
         seg.setOpacity(aRead, macroDoublePress[b]);
         seg.setOption(SEG_OPTION_ON, 1);
       }
+      strip.unlockRender();
       // this will notify clients of update (websockets,mqtt,etc)
       updateInterfaces(CALL_MODE_BUTTON);
     }
@@ -116,6 +116,7 @@ bool deserializeConfig(JsonObject doc, bool fromFS) {
       ledType |= refresh << 7;  // hack bit 7 to indicate strip requires off refresh
       s++;
       BusConfig bc = BusConfig(ledType, pins, start, length, colorOrder, reversed, skipFirst);
+      bc.universe = elm[F("uni")] | 0; // E1.31/ArtNet network busses
       mem += BusManager::memUsage(bc);
       if (mem <= MAX_LED_MEMORY && busses.getNumBusses() <= WLED_MAX_BUSSES) busses.add(bc);  // finalization will be done in WLED::beginStrip()
     }
@@ -249,12 +250,16 @@ bool deserializeConfig(JsonObject doc, bool fromFS) {
   CJSON(bootPreset, def["ps"]);
   CJSON(turnOnAtBoot, def["on"]); // true
   CJSON(briS, def["bri"]); // 128
+  uint32_t prevCacheSize = presetCacheSize;
+  CJSON(presetCacheSize, def[F("pcache")]);
+  if (presetCacheSize != prevCacheSize) invalidatePresetCache(0); //refilled within the new budget
 
   JsonObject interfaces = doc["if"];
 
   JsonObject if_sync = interfaces["sync"];
   CJSON(udpPort, if_sync[F("port0")]); // 21324
   CJSON(udpPort2, if_sync[F("port1")]); // 65506
+  CJSON(syncMulticast, if_sync[F("mc")]);
 
   JsonObject if_sync_recv = if_sync["recv"];
   CJSON(receiveNotificationBrightness, if_sync_recv["bri"]);
@@ -275,11 +280,13 @@ bool deserializeConfig(JsonObject doc, bool fromFS) {
   CJSON(notifyHue, if_sync_send["hue"]);
   CJSON(notifyMacro, if_sync_send["macro"]);
   CJSON(notifyTwice, if_sync_send[F("twice")]);
+  CJSON(syncDelta, if_sync_send[F("delta")]);
   CJSON(syncGroups, if_sync_send["grp"]);
 
   JsonObject if_nodes = interfaces["nodes"];
   CJSON(nodeListEnabled, if_nodes[F("list")]);
   CJSON(nodeBroadcastEnabled, if_nodes[F("bcast")]);
+  CJSON(nodeTimeSync, if_nodes[F("tsync")]);
 
   JsonObject if_live = interfaces["live"];
   CJSON(receiveDirect, if_live["en"]);
@@ -298,6 +305,13 @@ bool deserializeConfig(JsonObject doc, bool fromFS) {
   CJSON(arlsForceMaxBri, if_live[F("maxbri")]);
   CJSON(arlsDisableGammaCorrection, if_live[F("no-gc")]); // false
   CJSON(arlsOffset, if_live[F("offset")]); // 0
+  CJSON(realtimeBufferFrames, if_live[F("jbuf")]); // 0
+  if (realtimeBufferFrames > RT_BUFFER_MAX_FRAMES) realtimeBufferFrames = RT_BUFFER_MAX_FRAMES;
+
+  JsonObject if_live_out = if_live[F("out")];
+  CJSON(e131OutPriority, if_live_out[F("pri")]); // 100
+  if (e131OutPriority > 200) e131OutPriority = 200;
+  CJSON(e131OutSyncUniverse, if_live_out[F("sync")]); // 0
 
   CJSON(alexaEnabled, interfaces["va"][F("alexa")]); // false
 
@@ -593,6 +607,7 @@ void serializeConfig() {
     ins[F("skip")] = bus->skippedLeds();
     ins["type"] = bus->getType() & 0x7F;
     ins["ref"] = bus->isOffRefreshRequired();
+    if (bus->getType() == TYPE_NET_E131_RGB || bus->getType() == TYPE_NET_ARTNET_RGB) ins[F("uni")] = bus->getUniverse();
     //ins[F("rgbw")] = bus->isRgbw();
   }
 
@@ -666,12 +681,14 @@ void serializeConfig() {
   def["ps"] = bootPreset;
   def["on"] = turnOnAtBoot;
   def["bri"] = briS;
+  def[F("pcache")] = presetCacheSize;
 
   JsonObject interfaces = doc.createNestedObject("if");
 
   JsonObject if_sync = interfaces.createNestedObject("sync");
   if_sync[F("port0")] = udpPort;
   if_sync[F("port1")] = udpPort2;
+  if_sync[F("mc")] = syncMulticast;
 
   JsonObject if_sync_recv = if_sync.createNestedObject("recv");
   if_sync_recv["bri"] = receiveNotificationBrightness;
@@ -688,11 +705,13 @@ void serializeConfig() {
   if_sync_send["hue"] = notifyHue;
   if_sync_send["macro"] = notifyMacro;
   if_sync_send[F("twice")] = notifyTwice;
+  if_sync_send[F("delta")] = syncDelta;
   if_sync_send["grp"] = syncGroups;
 
   JsonObject if_nodes = interfaces.createNestedObject("nodes");
   if_nodes[F("list")] = nodeListEnabled;
   if_nodes[F("bcast")] = nodeBroadcastEnabled;
+  if_nodes[F("tsync")] = nodeTimeSync;
 
   JsonObject if_live = interfaces.createNestedObject("live");
   if_live["en"] = receiveDirect;
@@ -709,6 +728,11 @@ void serializeConfig() {
   if_live[F("maxbri")] = arlsForceMaxBri;
   if_live[F("no-gc")] = arlsDisableGammaCorrection;
   if_live[F("offset")] = arlsOffset;
+  if_live[F("jbuf")] = realtimeBufferFrames;
+
+  JsonObject if_live_out = if_live.createNestedObject(F("out"));
+  if_live_out[F("pri")] = e131OutPriority;
+  if_live_out[F("sync")] = e131OutSyncUniverse;
 
   JsonObject if_va = interfaces.createNestedObject("va");
   if_va[F("alexa")] = alexaEnabled;
@@ -219,6 +219,9 @@ void colorRGBtoRGBW(byte* rgb) //rgb to rgbw (http://codewelt.com/rgbw). (RGBW_M
 }
 */
 
+//x/255 for x <= 255*255 without a division
+inline uint8_t div255(uint16_t x) { return ((uint32_t)x + 1 + (x >> 8)) >> 8; }
+
 byte correctionRGB[4] = {0,0,0,0};
 uint16_t lastKelvin = 0;
 
@@ -229,13 +232,39 @@ uint32_t colorBalanceFromKelvin(uint16_t kelvin, uint32_t rgb)
   if (lastKelvin != kelvin) colorKtoRGB(kelvin, correctionRGB);  // convert Kelvin to RGB
   lastKelvin = kelvin;
   byte rgbw[4];
-  rgbw[0] = ((uint16_t) correctionRGB[0] * R(rgb)) /255; // correct R
-  rgbw[1] = ((uint16_t) correctionRGB[1] * G(rgb)) /255; // correct G
-  rgbw[2] = ((uint16_t) correctionRGB[2] * B(rgb)) /255; // correct B
+  rgbw[0] = div255((uint16_t) correctionRGB[0] * R(rgb)); // correct R
+  rgbw[1] = div255((uint16_t) correctionRGB[1] * G(rgb)); // correct G
+  rgbw[2] = div255((uint16_t) correctionRGB[2] * B(rgb)); // correct B
   rgbw[3] =                                W(rgb);
   return RGBW32(rgbw[0],rgbw[1],rgbw[2],rgbw[3]);
 }
 
+/*
+ * Scales all 4 channels of a color by amount, with the same result as scale8() on each channel.
+ * Red/blue and white/green are each done with a single 32 bit multiplication (SWAR).
+ */
+uint32_t IRAM_ATTR colorFade(uint32_t c, uint8_t amount)
+{
+  uint32_t scale = (uint32_t)amount + 1;
+  uint32_t rb = (((c & 0x00FF00FF) * scale) >> 8) & 0x00FF00FF;
+  uint32_t wg = (((c >> 8) & 0x00FF00FF) * scale) & 0xFF00FF00;
+  return rb | wg;
+}
+
+//colorFade() for a span of pixels, src and dest may be the same buffer
+void IRAM_ATTR colorFadeSpan(const uint32_t* src, uint32_t* dest, uint16_t len, uint8_t amount)
+{
+  if (amount == 255) {
+    if (src != dest) memcpy(dest, src, len * sizeof(uint32_t));
+    return;
+  }
+  uint32_t scale = (uint32_t)amount + 1;
+  for (uint16_t i = 0; i < len; i++) {
+    uint32_t c = src[i];
+    dest[i] = ((((c & 0x00FF00FF) * scale) >> 8) & 0x00FF00FF) | ((((c >> 8) & 0x00FF00FF) * scale) & 0xFF00FF00);
+  }
+}
+
 //approximates a Kelvin color temperature from an RGB color.
 //this does no check for the "whiteness" of the color,
 //so should be used combined with a saturation check (as done by auto-white)
@@ -139,7 +139,7 @@
 //bit 7 is reserved and set to 0
 
 #define TYPE_NONE                 0            //light is not configured
-#define TYPE_RESERVED             1            //unused. Might indicate a "virtual" light
+#define TYPE_RESERVED             1            //"virtual" light without output, backed by RAM (used by the effect benchmark)
 //Digital types (data pin only) (16-31)
 #define TYPE_WS2812_1CH          20            //white-only chips
 #define TYPE_WS2812_WWA          21            //amber + warm + cold white
@@ -251,9 +251,80 @@
 #define NL_MODE_COLORFADE         2            //Fade to target brightness and secondary color gradually
 #define NL_MODE_SUN               3            //Sunrise/sunset. Target brightness is set immediately, then Sunrise effect is started. Max 60 min.
 
+//Main loop stages (timed in loop_perf.cpp)
+#define LOOP_STAGE_SYS            0            //yield() and time outside of WLED::loop() (WiFi/system tasks)
+#define LOOP_STAGE_TIME           1
+#define LOOP_STAGE_IR             2
+#define LOOP_STAGE_CONNECTION     3
+#define LOOP_STAGE_SERIAL         4
+#define LOOP_STAGE_NOTIFICATIONS  5
+#define LOOP_STAGE_TRANSITIONS    6
+#define LOOP_STAGE_DMX            7
+#define LOOP_STAGE_USERLOOP       8
+#define LOOP_STAGE_USERMODS       9
+#define LOOP_STAGE_IO            10
+#define LOOP_STAGE_ALEXA         11
+#define LOOP_STAGE_HOMEKIT       12
+#define LOOP_STAGE_OTA           13            //DNS server (AP mode) and ArduinoOTA
+#define LOOP_STAGE_NIGHTLIGHT    14            //nightlight and playlist
+#define LOOP_STAGE_HUE           15
+#define LOOP_STAGE_BLYNK         16
+#define LOOP_STAGE_STRIP         17            //strip.service()
+#define LOOP_STAGE_MQTT          18            //MQTT reconnect and node list refresh
+#define LOOP_STAGE_BUSSES        19            //bus re-init and ledmap loading
+#define LOOP_STAGE_WS            20
+#define LOOP_STAGE_STATUSLED     21
+#define LOOP_STAGE_COUNT         22
+
+#define LOOP_PERF_BUCKETS        16            //histogram bucket n counts durations of 2^(n-1) to 2^n-1 us, the last one everything longer
+
+//Render task (WLED_ENABLE_RENDER_TASK, ESP32 only)
+//runs on the core loop() does not use unless WLED_RENDER_TASK_CORE is defined
+#ifndef WLED_RENDER_TASK_PRIORITY
+  #define WLED_RENDER_TASK_PRIORITY 2          //below the async TCP (3) and WiFi tasks sharing core 0 with it
+#endif
+#define WLED_RENDER_TASK_STACK      8192       //same as loopTask, effects and usermod overlays run on it
+
 
 #define NTP_PACKET_SIZE 48
 
+//Realtime input protocols (telemetry, see realtime_stats.cpp)
+#define RT_PROTO_E131             0
+#define RT_PROTO_ARTNET           1
+#define RT_PROTO_DDP              2
+#define RT_PROTO_TPM2NET          3
+#define RT_PROTO_UDP              4            // WARLS, DRGB, DRGBW, DNRGB
+#define RT_PROTO_HYPERION         5
+#define RT_PROTO_COUNT            6
+#define RT_STATS_WS_ENTRY         23           // bytes per entry of the binary telemetry WS message
+
+//Realtime pixel data layouts (setRealtimePixels())
+#define RT_LAYOUT_RGB             0            // 3 bytes per pixel
+#define RT_LAYOUT_RGBW            1            // 4 bytes per pixel
+
+//DDP protocol
+#define DDP_HEADER_LEN 10
+#define DDP_SYNCPACKET_LEN 10
+
+#define DDP_FLAGS1_VER 0xc0  // version mask
+#define DDP_FLAGS1_VER1 0x40 // version=1
+#define DDP_FLAGS1_PUSH 0x01
+#define DDP_FLAGS1_QUERY 0x02
+#define DDP_FLAGS1_REPLY 0x04
+#define DDP_FLAGS1_STORAGE 0x08
+#define DDP_FLAGS1_TIME 0x10
+
+#define DDP_ID_DISPLAY 1
+#define DDP_ID_CONFIG 250
+#define DDP_ID_STATUS 251
+
+#define DDP_TYPE_RGBW 0b011  // data type bits 3-5 (TTT), 0b001 is RGB
+
+// 1440 channels per packet
+#define DDP_CHANNELS_PER_PACKET 1440 // 480 leds
+
+#define DDP_MAX_TIMECODE_DELAY 1000  // ms, frames scheduled further ahead are shown right away (clocks not in sync)
+
 //maximum number of rendered LEDs - this does not have to match max. physical LEDs, e.g. if there are virtual busses 
 #ifndef MAX_LEDS
 #ifdef ESP8266
@@ -292,6 +363,25 @@
   #endif
 #endif
 
+#define RT_BUFFER_MAX_FRAMES 4     // realtime jitter buffer depth limit (realtimeBufferFrames)
+
+#define E131_FRAME_TIMEOUT 40      // ms after the first universe of a frame until it is shown even if incomplete
+#define E131_SYNC_TIMEOUT  2500    // ms without sync packets after which complete frames are shown right away again
+
+#ifndef PRESET_CACHE_SIZE
+  #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_USE_PSRAM)
+    #define PRESET_CACHE_SIZE 65536 // default byte budget of the preset cache (presetCacheSize)
+  #elif defined(ARDUINO_ARCH_ESP32)
+    #define PRESET_CACHE_SIZE 8192
+  #else
+    #define PRESET_CACHE_SIZE 0
+  #endif
+#endif
+
+#define TIMESYNC_INTERVAL  1000    // ms between node time sync requests
+#define TIMESYNC_STEP        50    // ms, larger effect time offsets are corrected at once instead of gradually
+#define TIMESYNC_TIMEOUT  10000    // ms without a reply from the reference node after which notifications set the timebase again
+
 #define ABL_MILLIAMPS_DEFAULT 850  // auto lower brightness to stay close to milliampere limit
 
 // PWM settings
@@ -312,6 +402,13 @@
   #define JSON_BUFFER_SIZE 20480
 #endif
 
+// Streamed JSON (json_stream.cpp), same as the sub-JSON ids of serveJson()
+#define JSON_STREAM_STATE      1
+#define JSON_STREAM_INFO       2
+#define JSON_STREAM_STATE_INFO 3
+#define JSON_STREAM_NO_STATS  0x80 // or-ed with the above: info without perf, rtin, jbuf, pcache and jlock (WebSocket pushes)
+#define JSON_STREAM_SLACK     32 // bytes added to the measured size for values that change until written
+
 #ifdef WLED_USE_DYNAMIC_JSON
   #define MIN_HEAP_SIZE JSON_BUFFER_SIZE+512
 #else
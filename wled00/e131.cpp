@@ -8,9 +8,40 @@
  * E1.31 handler
  */
 
-//DDP protocol support, called by handleE131Packet
-//handles RGB data only
-void handleDDPPacket(e131_packet_t* p) {
+//multi-universe frame assembly, see handleE131Frame()
+static uint32_t e131FrameMask = 0;        //universes received for the frame being assembled
+static unsigned long e131FrameStart = 0;  //millis() the first universe of that frame arrived
+static unsigned long e131LastSync = 0;    //millis() of the last sync packet, 0 if none seen
+static uint16_t e131SyncUniverse = 0;     //synchronization address announced in the E1.31 data packets
+
+//DDP status/config query waiting for a reply from handleDDPQuery()
+static IPAddress ddpQueryIP;
+static uint8_t ddpQueryId = 0;
+
+//returns the millis() value at which a frame with the given DDP timecode is due
+//timecode is the middle 32 bits of an NTP timestamp (16 bit seconds, 16 bit fraction)
+static bool getDDPShowTime(uint32_t timecode, unsigned long &showTime) {
+  if (toki.getTimeSource() < TOKI_TS_MS) return false; //no millisecond accurate clock to schedule against
+  Toki::Time now = toki.getTime();
+  int16_t secDiff = (int16_t)((timecode >> 16) - ((now.sec + YEARS_70) & 0xFFFF));
+  int32_t msDiff = secDiff * 1000 + (((timecode & 0xFFFF) * 1000) >> 16) - now.ms;
+  if (msDiff <= 0 || msDiff > DDP_MAX_TIMECODE_DELAY) return false; //late, or sender clock not in sync
+  showTime = millis() + msDiff;
+  return true;
+}
+
+//DDP protocol support, called by decodeE131Packet
+//handles RGB and RGBW data, timecodes and status/config queries
+void handleDDPPacket(e131_packet_t* p, IPAddress clientIP) {
+  if (p->flags & DDP_FLAGS1_QUERY) {
+    //answered from the main loop, we are in a network callback here
+    if (p->destination == DDP_ID_STATUS || p->destination == DDP_ID_CONFIG) {
+      ddpQueryIP = clientIP;
+      ddpQueryId = p->destination;
+    }
+    return;
+  }
+
   int lastPushSeq = e131LastSequenceNumber[0];
   
   //reject late packets belonging to previous frame (assuming 4 packets max. before push)
@@ -25,32 +56,127 @@ void handleDDPPacket(e131_packet_t* p) {
     }
   }
 
-  uint32_t start = htonl(p->channelOffset) /3;
-  start += DMXAddress /3;
-  uint16_t stop = start + htons(p->dataLen) /3;
+  uint8_t ddpChannelsPerLed = (((p->dataType >> 3) & 0x07) == DDP_TYPE_RGBW) ? 4 : 3;
+  uint32_t start = htonl(p->channelOffset) / ddpChannelsPerLed;
+  start += DMXAddress / ddpChannelsPerLed;
+  uint16_t stop = start + htons(p->dataLen) / ddpChannelsPerLed;
   uint8_t* data = p->data;
   uint16_t c = 0;
-  if (p->flags & DDP_TIMECODE_FLAG) c = 4; //packet has timecode flag, we do not support it, but data starts 4 bytes later
+  uint32_t timecode = 0;
+  if (p->flags & DDP_TIMECODE_FLAG) { //data starts after the 4 byte timecode
+    timecode = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | (data[2] << 8) | data[3];
+    c = 4;
+  }
 
   realtimeLock(realtimeTimeoutMs, REALTIME_MODE_DDP);
   
   if (!realtimeOverride) {
-    for (uint16_t i = start; i < stop; i++) {
-      setRealtimePixel(i, data[c], data[c+1], data[c+2], 0);
-      c+=3;
-    }
+    setRealtimePixels(start, stop - start, data + c, (ddpChannelsPerLed == 4) ? RT_LAYOUT_RGBW : RT_LAYOUT_RGB);
   }
 
   bool push = p->flags & DDP_PUSH_FLAG;
   if (push) {
-    e131NewData = true;
+    //hold the frame in the realtime ring until its timecode so several receivers show it at the same time
+    //late frames and frames arriving before the ring is allocated are shown right away
+    unsigned long showTime = 0;
+    if (timecode && getDDPShowTime(timecode, showTime) && !showTime) showTime = 1; //0 means no timecode
+    if (!queueRealtimeFrame(showTime)) e131NewData = true;
     byte sn = p->sequenceNum & 0xF;
     if (sn) e131LastSequenceNumber[0] = sn;
   }
 }
 
+//replies to the last DDP status or config query
+void handleDDPQuery() {
+  if (!ddpQueryId) return;
+  uint8_t id = ddpQueryId;
+  ddpQueryId = 0;
+
+  char json[192];
+  int len;
+  if (id == DDP_ID_STATUS) {
+    len = snprintf_P(json, sizeof(json), PSTR("{\"status\":{\"man\":\"WLED\",\"mod\":\"%s\",\"ver\":\"%s\",\"mac\":\"%s\"}}"),
+                     serverDescription, versionString, escapedMac.c_str());
+  } else {
+    IPAddress ip = Network.localIP();
+    len = snprintf_P(json, sizeof(json), PSTR("{\"config\":{\"ip\":\"%u.%u.%u.%u\",\"ports\":[{\"port\":0,\"ts\":0,\"l\":%u,\"ss\":%u}]}}"),
+                     ip[0], ip[1], ip[2], ip[3], strip.getLengthTotal(), DMXAddress / 3);
+  }
+  if (len <= 0 || len >= (int)sizeof(json)) return;
+
+  uint8_t header[DDP_HEADER_LEN] = {DDP_FLAGS1_VER1 | DDP_FLAGS1_REPLY | DDP_FLAGS1_PUSH, 0, 0, id, 0, 0, 0, 0, (uint8_t)(len >> 8), (uint8_t)len};
+  WiFiUDP ddpReplyUdp;
+  if (!ddpReplyUdp.beginPacket(ddpQueryIP, DDP_DEFAULT_PORT)) return;
+  ddpReplyUdp.write(header, DDP_HEADER_LEN);
+  ddpReplyUdp.write((uint8_t*)json, len);
+  ddpReplyUdp.endPacket();
+}
+
+//number of universes the LEDs span in the DMX_MODE_MULTIPLE_* modes
+static uint8_t getE131UniverseCount()
+{
+  bool is4Chan = (DMXMode == DMX_MODE_MULTIPLE_RGBW);
+  uint16_t dmxChannelsPerLed = is4Chan ? 4 : 3;
+  uint16_t ledsPerUniverse = is4Chan ? MAX_4_CH_LEDS_PER_UNIVERSE : MAX_3_CH_LEDS_PER_UNIVERSE;
+  uint16_t ledsInFirstUniverse = (MAX_CHANNELS_PER_UNIVERSE - DMXAddress) / dmxChannelsPerLed;
+  uint16_t totalLen = strip.getLengthTotal();
+  if (totalLen <= ledsInFirstUniverse) return 1;
+  uint16_t count = 1 + (totalLen - ledsInFirstUniverse + ledsPerUniverse -1) / ledsPerUniverse;
+  return (count > E131_MAX_UNIVERSE_COUNT) ? E131_MAX_UNIVERSE_COUNT : count;
+}
+
+static bool e131SyncActive()
+{
+  return e131LastSync && millis() - e131LastSync < E131_SYNC_TIMEOUT;
+}
+
+//shows the frame being assembled, torn if not all universes have arrived
+//frames spanning several universes are snapshot in the realtime ring, the next frame is written into another slot
+static void showE131Frame()
+{
+  uint8_t count = getE131UniverseCount();
+  if (e131FrameMask != (1UL << count) -1) e131FramesTorn++;
+  e131FrameMask = 0;
+  if (queueRealtimeFrame(0, count > 1)) return;
+  if (e131NewData) e131FramesDropped++; //the main loop did not show the previous frame yet
+  e131NewData = true;
+}
+
+//called before the pixels of universe n are written
+//a universe received twice means the sender started its next frame, the pending one is shown first
+//(senders covering fewer universes than the LEDs span then still get every frame shown)
+static void beginE131FrameUniverse(uint8_t n)
+{
+  if (e131FrameMask & (1UL << n)) showE131Frame();
+}
+
+//a universe of a multi-universe frame has been written
+//the frame is shown once all universes have arrived, or on a sync packet if the sender uses them
+static void addE131FrameUniverse(uint8_t n)
+{
+  if (!e131FrameMask) e131FrameStart = millis();
+  e131FrameMask |= 1UL << n;
+  if (e131FrameMask == (1UL << getE131UniverseCount()) -1 && !e131SyncActive()) showE131Frame();
+}
+
+//called from the main loop, shows an incomplete frame that got no more universes for E131_FRAME_TIMEOUT ms
+void handleE131Frame()
+{
+  if (e131FrameMask && millis() - e131FrameStart > E131_FRAME_TIMEOUT) showE131Frame();
+}
+
 //E1.31 and Art-Net protocol support
-void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
+static void decodeE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
+
+  if (protocol == P_E131_SYNC || protocol == P_ARTNET_SYNC) {
+    if (protocol == P_E131_SYNC) {
+      uint16_t syncUni = (p->raw[E131_SYNC_ADDR] << 8) | p->raw[E131_SYNC_ADDR +1];
+      if (syncUni != e131SyncUniverse) return;
+    }
+    e131LastSync = millis();
+    if (e131FrameMask) showE131Frame();
+    return;
+  }
 
   uint16_t uni = 0, dmxChannels = 0;
   uint8_t* e131_data = nullptr;
@@ -68,9 +194,11 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
     dmxChannels = htons(p->property_value_count) -1;
     e131_data = p->property_values;
     seq = p->sequence_number;
+    e131SyncUniverse = htons(p->reserved); //E1.31-2016 synchronization address
+    if (!e131SyncUniverse) e131LastSync = 0; //sender does not sync, show frames once complete
   } else { //DDP
-    realtimeIP = clientIP;
-    handleDDPPacket(p);
+    if (!(p->flags & DDP_FLAGS1_QUERY)) realtimeIP = clientIP;
+    handleDDPPacket(p, clientIP);
     return;
   }
 
@@ -84,10 +212,14 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
   #endif
 
   // only listen for universes we're handling & allocated memory
-  if (uni >= (e131Universe + E131_MAX_UNIVERSE_COUNT)) return;
+  if (uni < e131Universe || uni >= (e131Universe + E131_MAX_UNIVERSE_COUNT)) return;
 
   uint8_t previousUniverses = uni - e131Universe;
 
+  //sequence number 0 is not used by Art-Net senders that do not count
+  uint8_t lastSeq = e131LastSequenceNumber[previousUniverses];
+  if (seq && lastSeq && (int8_t)(seq - lastSeq) < 0) e131FramesLate++;
+
   if (e131SkipOutOfSequence)
     if (seq < e131LastSequenceNumber[uni-e131Universe] && seq > 20 && e131LastSequenceNumber[uni-e131Universe] < 250){
       DEBUG_PRINT("skipping E1.31 frame (last seq=");
@@ -105,6 +237,8 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
   realtimeIP = clientIP;
   byte wChannel = 0;
   uint16_t totalLen = strip.getLengthTotal();
+  uint32_t* frame;
+  uint16_t frameLen;
 
   switch (DMXMode) {
     case DMX_MODE_DISABLED:
@@ -117,8 +251,10 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
       realtimeLock(realtimeTimeoutMs, mde);
       if (realtimeOverride) return;
       wChannel = (dmxChannels-DMXAddress+1 > 3) ? e131_data[DMXAddress+3] : 0;
+      frame = getRealtimeFrame(frameLen); //jitter buffer, locked once for the packet
       for (uint16_t i = 0; i < totalLen; i++)
-        setRealtimePixel(i, e131_data[DMXAddress+0], e131_data[DMXAddress+1], e131_data[DMXAddress+2], wChannel);
+        setRealtimePixel(frame, frameLen, i, e131_data[DMXAddress+0], e131_data[DMXAddress+1], e131_data[DMXAddress+2], wChannel);
+      if (frame) releaseRealtimeFrame();
       break;
 
     case DMX_MODE_SINGLE_DRGB:
@@ -132,8 +268,10 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
         bri = e131_data[DMXAddress+0];
         strip.setBrightness(bri);
       }
+      frame = getRealtimeFrame(frameLen);
       for (uint16_t i = 0; i < totalLen; i++)
-        setRealtimePixel(i, e131_data[DMXAddress+1], e131_data[DMXAddress+2], e131_data[DMXAddress+3], wChannel);
+        setRealtimePixel(frame, frameLen, i, e131_data[DMXAddress+1], e131_data[DMXAddress+2], e131_data[DMXAddress+3], wChannel);
+      if (frame) releaseRealtimeFrame();
       break;
 
     case DMX_MODE_EFFECT:
@@ -173,9 +311,13 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
         const uint16_t dmxChannelsPerLed = is4Chan ? 4 : 3;
         const uint16_t ledsPerUniverse = is4Chan ? MAX_4_CH_LEDS_PER_UNIVERSE : MAX_3_CH_LEDS_PER_UNIVERSE;
         if (realtimeOverride) return;
+        if (previousUniverses == 0 && dmxChannels-DMXAddress < 1) return;
+        beginE131FrameUniverse(previousUniverses); //before any pixel of the pending frame is overwritten
+        //no ring (not allocated yet or out of RAM), the universes are written to the busses directly
+        //hold them until the main loop has shown the completed frame, so it is not mixed with the next one
+        if (e131NewData && getE131UniverseCount() > 1) return;
         uint16_t previousLeds, dmxOffset;
         if (previousUniverses == 0) {
-          if (dmxChannels-DMXAddress < 1) return;
           dmxOffset = DMXAddress;
           previousLeds = 0;
           // First DMX address is dimmer in DMX_MODE_MULTIPLE_DRGB mode.
@@ -189,18 +331,9 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
           previousLeds = ledsInFirstUniverse + (previousUniverses - 1) * ledsPerUniverse;
         }
         uint16_t ledsTotal = previousLeds + (dmxChannels - dmxOffset +1) / dmxChannelsPerLed;
-        if (!is4Chan) {
-          for (uint16_t i = previousLeds; i < ledsTotal; i++) {
-            setRealtimePixel(i, e131_data[dmxOffset], e131_data[dmxOffset+1], e131_data[dmxOffset+2], 0);
-            dmxOffset+=3;
-          }
-        } else {
-          for (uint16_t i = previousLeds; i < ledsTotal; i++) {
-            setRealtimePixel(i, e131_data[dmxOffset], e131_data[dmxOffset+1], e131_data[dmxOffset+2], e131_data[dmxOffset+3]);
-            dmxOffset+=4;
-          }
-        }
-        break;
+        setRealtimePixels(previousLeds, ledsTotal - previousLeds, e131_data + dmxOffset, is4Chan ? RT_LAYOUT_RGBW : RT_LAYOUT_RGB);
+        addE131FrameUniverse(previousUniverses);
+        return; //shown once the frame is complete
       }
     default:
       DEBUG_PRINTLN(F("unknown E1.31 DMX mode"));
@@ -208,5 +341,30 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
       break;
   }
 
-  e131NewData = true;
+  if (!queueRealtimeFrame()) e131NewData = true;
+}
+
+//called by ESPAsyncE131 for every E1.31, Art-Net and DDP packet, counts it for the realtime telemetry
+void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
+  uint32_t cycles = ESP.getCycleCount();
+  decodeE131Packet(p, clientIP, protocol);
+
+  switch (protocol) {
+    case P_E131: {
+      uint16_t uni = htons(p->universe);
+      int16_t idx = (uni >= e131Universe) ? uni - e131Universe : -2; //-2: no sequence tracking for other universes
+      countRealtimePacket(RT_PROTO_E131, idx, htons(p->property_value_count) -1, p->sequence_number +1, 256, cycles);
+      break;
+    }
+    case P_ARTNET: {
+      uint16_t uni = p->art_universe;
+      int16_t idx = (uni >= e131Universe) ? uni - e131Universe : -2;
+      countRealtimePacket(RT_PROTO_ARTNET, idx, htons(p->art_length), p->art_sequence_number, 255, cycles); //0: sequence disabled
+      break;
+    }
+    case P_DDP:
+      if (p->flags & DDP_FLAGS1_QUERY) break;
+      countRealtimePacket(RT_PROTO_DDP, -1, htons(p->dataLen), p->sequenceNum & 0xF, 15, cycles); //0: sequence unused
+      break;
+  }
 }
@@ -72,6 +72,8 @@ bool colorFromHexString(byte* rgb, const char* in);
 
 uint32_t colorBalanceFromKelvin(uint16_t kelvin, uint32_t rgb);
 uint16_t approximateKelvinFromRGB(uint32_t rgb);
+uint32_t colorFade(uint32_t c, uint8_t amount);
+void colorFadeSpan(const uint32_t* src, uint32_t* dest, uint16_t len, uint8_t amount);
 
 void setRandomColor(byte* rgb);
 
@@ -80,7 +82,10 @@ void initDMX();
 void handleDMX();
 
 //e131.cpp
+void handleDDPPacket(e131_packet_t* p, IPAddress clientIP);
 void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol);
+void handleDDPQuery();
+void handleE131Frame();
 
 //file.cpp
 bool handleFileRead(AsyncWebServerRequest*, String path);
@@ -90,6 +95,16 @@ bool readObjectFromFileUsingId(const char* file, uint16_t id, JsonDocument* dest
 bool readObjectFromFile(const char* file, const char* key, JsonDocument* dest);
 void updateFSInfo();
 void closeFile();
+void invalidatePresetIndex();
+void requestPresetsCompaction();
+void handlePresetsCompaction();
+void recoverPresetsFile();
+
+//fx_benchmark.cpp
+void startFxBenchmark(uint16_t frames, uint8_t grouping, bool mirror, bool ledmap, byte gold);
+bool handleFxBenchmark();
+bool isFxBenchmarkRunning();
+void startRealtimeBenchmark(uint8_t universes);
 
 //hue.cpp
 void handleHue();
@@ -137,8 +152,10 @@ void deserializeSegment(JsonObject elem, byte it, byte presetId = 0);
 bool deserializeState(JsonObject root, byte callMode = CALL_MODE_DIRECT_CHANGE, byte presetId = 0);
 void serializeSegment(JsonObject& root, WS2812FX::Segment& seg, byte id, bool forPreset = false, bool segmentBounds = true);
 void serializeState(JsonObject root, bool forPreset = false, bool includeBri = true, bool segmentBounds = true);
+void serializePerf(JsonObject root);
 void serializeInfo(JsonObject root);
 void serveJson(AsyncWebServerRequest* request);
+int getSignalQuality(int rssi);
 #ifdef WLED_ENABLE_JSONLIVE
 bool serveLiveLeds(AsyncWebServerRequest* request, uint32_t wsClient = 0);
 #endif
@@ -159,6 +176,13 @@ void handleTransitions();
 void handleNightlight();
 byte scaledBri(byte in);
 
+//loop_perf.cpp
+void resetLoopPerf();
+void loopStage(uint8_t stage);
+void loopStart();
+uint32_t getLoopsPerSec();
+void serializeLoopPerf(JsonObject root);
+
 //lx_parser.cpp
 bool parseLx(int lxValue, byte* rgbw);
 void parseLxJson(int lxValue, byte segId, bool secondary);
@@ -197,8 +221,17 @@ void _drawOverlayCronixie();
 void shufflePlaylist();
 void unloadPlaylist();
 int16_t loadPlaylist(JsonObject playlistObject, byte presetId = 0);
+int16_t loadPlaylist(const byte* presets, const uint16_t* durations, const uint16_t* transitions, byte len, int rep, byte endPreset, bool shuffle, byte presetId);
 void handlePlaylist();
 
+//preset_cache.cpp
+void invalidatePresetCache(uint8_t id);
+bool applyCachedPreset(uint8_t id, byte callMode);
+bool getCachedPreset(uint8_t id, JsonDocument* dest);
+void cachePreset(uint8_t id, JsonDocument* src);
+void resetPresetCacheStats();
+void serializePresetCache(JsonObject root);
+
 //presets.cpp
 bool applyPreset(byte index, byte callMode = CALL_MODE_DIRECT_CHANGE);
 inline bool applyTemporaryPreset() {return applyPreset(255);};
@@ -206,6 +239,27 @@ void savePreset(byte index, bool persist = true, const char* pname = nullptr, Js
 inline void saveTemporaryPreset() {savePreset(255, false);};
 void deletePreset(byte index);
 
+//realtime_buffer.cpp
+uint32_t* getRealtimeFrame(uint16_t &len);
+void releaseRealtimeFrame();
+bool queueRealtimeFrame(unsigned long showTime = 0, bool multiPacket = false);
+void handleRealtimeBuffer();
+void serializeRealtimeBuffer(JsonObject root);
+
+//realtime_stats.cpp
+void resetRealtimeStats();
+void countRealtimePacket(uint8_t proto, int16_t universe, uint16_t bytes, uint16_t seq, uint16_t seqMax, uint32_t startCycles);
+void serializeRealtimeStats(JsonObject root);
+size_t writeRealtimeStats(uint8_t* buf, size_t len);
+
+//snapshot.cpp
+size_t writeStateSnapshot(uint8_t* buf, size_t len, bool includeBri = true, bool segmentBounds = true);
+size_t jsonToSnapshot(JsonObject root, uint8_t* buf, size_t len);
+bool snapshotToJson(const uint8_t* buf, size_t len, JsonObject root);
+bool applyStateSnapshot(const uint8_t* buf, size_t len, byte callMode, byte presetId = 0);
+bool saveStateSnapshotFile(const char* file);
+bool applyStateSnapshotFile(const char* file, byte callMode, byte presetId = 0);
+
 //set.cpp
 bool isAsterisksOnly(const char* str, byte maxLen);
 void handleSettingsSet(AsyncWebServerRequest *request, byte subPage);
@@ -214,12 +268,29 @@ int getNumVal(const String* req, uint16_t pos);
 void parseNumber(const char* str, byte* val, byte minv=0, byte maxv=255);
 bool updateVal(const String* req, const char* key, byte* val, byte minv=0, byte maxv=255);
 
+//timesync.cpp
+void handleTimeSync();
+bool handleTimeSyncPacket(const uint8_t* udpIn, uint16_t len, IPAddress ip, uint32_t rxTime);
+bool isTimeSynced();
+uint8_t getTimeSyncReference();
+
 //udp.cpp
+void joinSyncGroups(bool rejoin = false);
+typedef struct RealtimeOutStats { // packets sent by realtimeBroadcast()
+  uint32_t frames = 0;
+  uint32_t packets = 0;
+  uint32_t errors = 0;        // frames that could not be sent completely
+  uint32_t buildTime = 0;     // us spent on headers and brightness scaling for the last frame
+  uint32_t buildTimeMax = 0;
+} realtime_out_stats;
+
 void notify(byte callMode, bool followUp=false);
-uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, byte *buffer, uint8_t bri=255, bool isRGBW=false);
+uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, byte *buffer, uint8_t bri=255, bool isRGBW=false, WiFiUDP* udp=nullptr, RealtimeOutStats* stats=nullptr, uint16_t universe=0, uint8_t* sequence=nullptr);
 void realtimeLock(uint32_t timeoutMs, byte md = REALTIME_MODE_GENERIC);
 void handleNotifications();
 void setRealtimePixel(uint16_t i, byte r, byte g, byte b, byte w);
+void setRealtimePixel(uint32_t* frame, uint16_t frameLen, uint16_t i, byte r, byte g, byte b, byte w);
+void setRealtimePixels(uint16_t start, uint16_t count, const uint8_t* data, byte layout);
 void refreshNodeList();
 void sendSysInfoUDP();
 
@@ -232,12 +303,14 @@ void sendSysInfoUDP();
 //bool isAsterisksOnly(const char* str, byte maxLen);
 bool requestJSONBufferLock(uint8_t module=255);
 void releaseJSONBufferLock();
+void resetJSONBufferLockStats();
+void serializeJSONBufferLockStats(JsonObject root);
 uint8_t extractModeName(uint8_t mode, const char *src, char *dest, uint8_t maxLen);
 
 //um_manager.cpp
 class Usermod {
   public:
-    virtual void loop() {}
+    virtual void loop() {} // called without the render lock, wrap segment changes in strip.lockRender()/unlockRender()
     virtual void handleOverlayDraw() {}
     virtual bool handleButton(uint8_t b) { return false; }
     virtual void setup() {}
@@ -305,6 +378,11 @@ String settingsProcessor(const String& var);
 String dmxProcessor(const String& var);
 void serveSettings(AsyncWebServerRequest* request, bool post = false);
 
+//json_stream.cpp
+size_t streamJson(Print& out, byte what, byte error);
+size_t streamJson(uint8_t* buf, size_t len, byte what, byte error);
+size_t measureStreamJson(byte what, byte error);
+
 //ws.cpp
 void handleWs();
 void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventType type, void * arg, uint8_t *data, size_t len);
@@ -165,6 +165,7 @@ void writeSpace(uint16_t l)
 {
   byte buf[FS_BUFSIZE];
   memset(buf, ' ', FS_BUFSIZE);
+  uint16_t len = l;
 
   while (l > 0) {
     uint16_t block = (l>FS_BUFSIZE) ? FS_BUFSIZE : l;
@@ -172,9 +173,239 @@ void writeSpace(uint16_t l)
     l -= block;
   }
 
-  if (knownLargestSpace < l) knownLargestSpace = l;
+  if (knownLargestSpace < len) knownLargestSpace = len;
 }
 
+/*
+ * Preset offset index
+ * /presets.idx maps preset ids to the position and length of their object in /presets.json,
+ * so a preset is read with one seek instead of a bufferedFind() from the start of the file.
+ * Layout (little endian): 'W','P','I', version, 4 byte size of presets.json, 4 byte presetsModifiedTime,
+ * 4 byte reserved, then PRESET_INDEX_IDS entries of 4 byte object position (0 if not present) and 2 byte length.
+ * writeObjectToFile() keeps it up to date, it is rebuilt with a single pass over the file when the size
+ * or modification time of presets.json does not match. If the keys are not where the index points to
+ * (e.g. a hand edited file), presets are found with bufferedFind() until presets.json changes again.
+ */
+
+#define PRESET_INDEX_FILE    "/presets.idx"
+#define PRESET_INDEX_VERSION 1
+#define PRESET_INDEX_HEADER  16
+#define PRESET_INDEX_ENTRY   6
+#define PRESET_INDEX_IDS     251  // 0-250
+
+static bool presetIndexValid = false; // header matches presets.json as of the last check
+static uint32_t presetIndexUnusable = 0; // size of the presets.json lookups failed for, not rebuilt for it
+static uint32_t indexedKeyPos = 0; // key (and whitespace before it) of the last seekIndexedObject() match
+
+static bool presetsStatsValid = false;     // presetsWasted and presetsHoles are up to date
+static unsigned long presetsLastChange = 0; // millis() of the last write to presets.json
+#ifdef ARDUINO_ARCH_ESP32
+// presets.json is read from the async_tcp task (JSON API) while compaction runs in the loop task
+static SemaphoreHandle_t presetsMutex = nullptr; // created at boot by recoverPresetsFile()
+#else
+static bool presetsFileBusy = false; // presets.json is being read, written or compacted
+#endif
+
+static bool isPresetsFile(const char* file)
+{
+  return !strcmp_P(file, PSTR("/presets.json"));
+}
+
+// preset id from a key like "12":, -1 if it is not one
+static int16_t getPresetIndexId(const char* key)
+{
+  if (key == nullptr || key[0] != '"') return -1;
+  int16_t id = atoi(key +1);
+  return (id > 0 && id < PRESET_INDEX_IDS) ? id : -1;
+}
+
+static void writePresetIndexHeader(File &idx, uint32_t size)
+{
+  uint8_t header[PRESET_INDEX_HEADER] = {'W','P','I',PRESET_INDEX_VERSION};
+  memcpy(header + 4, &size, 4);
+  memcpy(header + 8, &presetsModifiedTime, 4);
+  idx.seek(0);
+  idx.write(header, PRESET_INDEX_HEADER);
+}
+
+// checks the index against the size and modification time of presets.json
+static bool loadPresetIndex(uint32_t size)
+{
+  presetIndexValid = false;
+  File idx = WLED_FS.open(PRESET_INDEX_FILE, "r");
+  if (!idx) return false;
+  uint8_t header[PRESET_INDEX_HEADER];
+  bool ok = idx.size() == PRESET_INDEX_HEADER + PRESET_INDEX_IDS * PRESET_INDEX_ENTRY
+         && idx.read(header, PRESET_INDEX_HEADER) == PRESET_INDEX_HEADER;
+  idx.close();
+  if (!ok || header[0] != 'W' || header[1] != 'P' || header[2] != 'I' || header[3] != PRESET_INDEX_VERSION) return false;
+  uint32_t idxSize, stamp;
+  memcpy(&idxSize, header + 4, 4);
+  memcpy(&stamp, header + 8, 4);
+  if (idxSize != size) return false;
+  if (presetsModifiedTime == 0) presetsModifiedTime = stamp; //not known yet after boot
+  presetIndexValid = (stamp == presetsModifiedTime);
+  return presetIndexValid;
+}
+
+//called if presets.json was replaced as a whole
+void invalidatePresetIndex()
+{
+  presetIndexValid = false;
+  presetIndexUnusable = 0;
+  presetsStatsValid = false;
+  presetsLastChange = millis();
+  WLED_FS.remove(PRESET_INDEX_FILE);
+}
+
+// single pass over presets.json recording the position and length of each top-level object
+static bool buildPresetIndex()
+{
+  #ifdef WLED_DEBUG_FS
+    DEBUGFS_PRINTLN(F("Build preset index"));
+    uint32_t s = millis();
+  #endif
+  presetIndexValid = false;
+  File pf = WLED_FS.open("/presets.json", "r");
+  if (!pf) return false;
+  File idx = WLED_FS.open(PRESET_INDEX_FILE, "w");
+  if (!idx) { pf.close(); return false; }
+
+  byte buf[FS_BUFSIZE];
+  memset(buf, 0, FS_BUFSIZE);
+  writePresetIndexHeader(idx, 0); //written again once complete
+  for (uint16_t l = PRESET_INDEX_IDS * PRESET_INDEX_ENTRY; l > 0;) {
+    uint16_t block = (l > FS_BUFSIZE) ? FS_BUFSIZE : l;
+    idx.write(buf, block);
+    l -= block;
+  }
+
+  uint16_t depth = 0;
+  bool inString = false, escaped = false;
+  int16_t key = -1, id = -1;  //id of the last top-level key, -1 if none
+  uint32_t objStart = 0;
+  uint32_t pos = 0;
+  while (pf.available()) {
+    uint16_t bufsize = pf.read(buf, FS_BUFSIZE);
+    for (uint16_t i = 0; i < bufsize; i++, pos++) {
+      char c = buf[i];
+      if (inString) {
+        if (escaped) escaped = false;
+        else if (c == '\\') escaped = true;
+        else if (c == '"') inString = false;
+        else if (depth == 1 && key >= 0) key = (c >= '0' && c <= '9') ? key * 10 + c - '0' : -1;
+        if (key > 999) key = -1;
+        continue;
+      }
+      if (c == '"') {
+        inString = true;
+        key = (depth == 1) ? 0 : -1;
+      } else if (c == '{') {
+        if (++depth == 2) { id = key; objStart = pos; }
+      } else if (c == '}' && depth) {
+        if (--depth == 1 && id > 0 && id < PRESET_INDEX_IDS) {
+          uint8_t entry[PRESET_INDEX_ENTRY];
+          uint16_t len = pos - objStart +1;
+          memcpy(entry, &objStart, 4);
+          memcpy(entry + 4, &len, 2);
+          idx.seek(PRESET_INDEX_HEADER + id * PRESET_INDEX_ENTRY);
+          idx.write(entry, PRESET_INDEX_ENTRY);
+          id = -1;
+        }
+      }
+    }
+  }
+
+  if (presetsModifiedTime == 0) presetsModifiedTime = toki.second();
+  writePresetIndexHeader(idx, pf.size());
+  pf.close();
+  idx.close();
+  presetIndexValid = true;
+  DEBUGFS_PRINTF("Built, took %d ms\n", millis() - s);
+  return true;
+}
+
+static bool isJsonSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// seeks f (presets.json) to the object with the given key
+// returns 1 if found, 0 if there is no such object and -1 if the index can not tell (use bufferedFind())
+static int8_t seekIndexedObject(const char* key)
+{
+  int16_t id = getPresetIndexId(key);
+  if (id < 0) return -1;
+  if (!loadPresetIndex(f.size()) && (presetIndexUnusable == f.size() || !buildPresetIndex())) return -1;
+
+  File idx = WLED_FS.open(PRESET_INDEX_FILE, "r");
+  if (!idx) return -1;
+  uint8_t entry[PRESET_INDEX_ENTRY];
+  idx.seek(PRESET_INDEX_HEADER + id * PRESET_INDEX_ENTRY);
+  bool ok = idx.read(entry, PRESET_INDEX_ENTRY) == PRESET_INDEX_ENTRY;
+  idx.close();
+  uint32_t objPos;
+  memcpy(&objPos, entry, 4);
+  size_t keyLen = strlen(key);
+  if (!ok) return -1;
+  if (objPos == 0) return 0;
+
+  //make sure the key is in front of the object, in case presets.json was changed behind our back
+  //pretty printed files have whitespace around the colon
+  char buf[32];
+  if (keyLen < sizeof(buf) && objPos < f.size()) {
+    uint32_t start = (objPos > sizeof(buf) -1) ? objPos - (sizeof(buf) -1) : 0;
+    size_t e = objPos - start; //index of the '{' in buf
+    f.seek(start);
+    if (f.read((uint8_t*)buf, e +1) == e +1 && buf[e] == '{') {
+      while (e > 0 && isJsonSpace(buf[e-1])) e--;
+      if (key[keyLen-1] == ':' && e > 0 && buf[e-1] == ':') {
+        keyLen--; e--;
+        while (e > 0 && isJsonSpace(buf[e-1])) e--;
+      }
+      if (e >= keyLen && !strncmp(buf + e - keyLen, key, keyLen)) {
+        e -= keyLen;
+        while (e > 0 && isJsonSpace(buf[e-1])) e--; //deleting the object also removes the comma in front
+        indexedKeyPos = start + e;
+        f.seek(objPos);
+        return 1;
+      }
+    }
+  }
+  //rebuilding would give the same index, presets.json is searched instead until it changes
+  DEBUGFS_PRINTLN(F("Preset index unusable"));
+  presetIndexValid = false;
+  presetIndexUnusable = f.size();
+  WLED_FS.remove(PRESET_INDEX_FILE);
+  return -1;
+}
+
+// record an object written by writeObjectToFile() (pos 0 if deleted)
+static void updatePresetIndex(int16_t id, uint32_t pos, uint32_t len)
+{
+  presetsModifiedTime = toki.second(); //unix time
+  presetsStatsValid = false;
+  presetsLastChange = millis();
+  presetIndexUnusable = 0;
+  if (!presetIndexValid || id < 0) { //could not be kept up to date, rebuild on next read
+    presetIndexValid = false;
+    WLED_FS.remove(PRESET_INDEX_FILE);
+    return;
+  }
+  File idx = WLED_FS.open(PRESET_INDEX_FILE, "r+");
+  if (!idx) { presetIndexValid = false; return; }
+  uint8_t entry[PRESET_INDEX_ENTRY];
+  uint16_t l = len;
+  memcpy(entry, &pos, 4);
+  memcpy(entry + 4, &l, 2);
+  idx.seek(PRESET_INDEX_HEADER + id * PRESET_INDEX_ENTRY);
+  idx.write(entry, PRESET_INDEX_ENTRY);
+  writePresetIndexHeader(idx, f.size());
+  idx.close();
+}
+
+static uint32_t appendedObjectPos = 0; //position of the object written by the last appendObjectToFile()
+
 bool appendObjectToFile(const char* key, JsonDocument* content, uint32_t s, uint32_t contentLen = 0)
 {
   #ifdef WLED_DEBUG_FS
@@ -201,6 +432,7 @@ bool appendObjectToFile(const char* key, JsonDocument* content, uint32_t s, uint
   if (bufferedFindSpace(contentLen + strlen(key) + 1)) {
     if (f.position() > 2) f.write(','); //add comma if not first object
     f.print(key);
+    appendedObjectPos = f.position();
     serializeJson(*content, f);
     DEBUGFS_PRINTF("Inserted, took %d ms (total %d)", millis() - s1, millis() - s);
     doCloseFile = true;
@@ -246,6 +478,7 @@ bool appendObjectToFile(const char* key, JsonDocument* content, uint32_t s, uint
   f.print(key);
 
   //Append object
+  appendedObjectPos = f.position();
   serializeJson(*content, f);
   f.write('}');
 
@@ -261,7 +494,34 @@ bool writeObjectToFileUsingId(const char* file, uint16_t id, JsonDocument* conte
   return writeObjectToFile(file, objKey, content);
 }
 
-bool writeObjectToFile(const char* file, const char* key, JsonDocument* content)
+// waits up to timeoutMs for other users of presets.json, compaction does not hold the JSON buffer
+static bool lockPresetsFile(uint32_t timeoutMs = 1000)
+{
+  #ifdef ARDUINO_ARCH_ESP32
+  if (presetsMutex == nullptr) return true; // file system not mounted
+  if (xSemaphoreTake(presetsMutex, pdMS_TO_TICKS(timeoutMs)) == pdTRUE) return true;
+  #else
+  unsigned long now = millis();
+  while (presetsFileBusy && millis()-now < timeoutMs) delay(1);
+  if (!presetsFileBusy) {
+    presetsFileBusy = true;
+    return true;
+  }
+  #endif
+  DEBUGFS_PRINTLN(F("Presets file busy!"));
+  return false;
+}
+
+static void unlockPresetsFile()
+{
+  #ifdef ARDUINO_ARCH_ESP32
+  if (presetsMutex) xSemaphoreGive(presetsMutex);
+  #else
+  presetsFileBusy = false;
+  #endif
+}
+
+static bool writeObject(const char* file, const char* key, JsonDocument* content)
 {
   uint32_t s = 0; //timing
   #ifdef WLED_DEBUG_FS
@@ -277,10 +537,19 @@ bool writeObjectToFile(const char* file, const char* key, JsonDocument* content)
     DEBUGFS_PRINTLN(F("Failed to open!"));
     return false;
   }
-  
-  if (!bufferedFind(key)) //key does not exist in file
+
+  bool indexed = isPresetsFile(file);
+  int16_t id = indexed ? getPresetIndexId(key) : -1;
+  int8_t found = indexed ? seekIndexedObject(key) : -1;
+  bool foundByIndex = found > 0; //at the '{', else right after the key
+  if (found < 0) found = bufferedFind(key);
+
+  if (!found) //key does not exist in file
   {
-    return appendObjectToFile(key, content, s);
+    appendedObjectPos = 0;
+    bool success = appendObjectToFile(key, content, s);
+    if (indexed) updatePresetIndex(id, success ? appendedObjectPos : 0, success ? measureJson(*content) : 0);
+    return success;
   } 
   
   //an object with this key already exists, replace or delete it
@@ -306,17 +575,25 @@ bool writeObjectToFile(const char* file, const char* key, JsonDocument* content)
     f.seek(pos);
     serializeJson(*content, f);
     writeSpace(pos2 - f.position());
+    if (indexed) updatePresetIndex(id, pos, contentLen);
   } else if (contentLen && bufferedFindSpace(contentLen - oldLen, false)) { //enough leading spaces to replace
     DEBUGFS_PRINTLN(F("replace (trailing)"));
     f.seek(pos);
     serializeJson(*content, f);
+    if (indexed) updatePresetIndex(id, pos, contentLen);
   } else {
     DEBUGFS_PRINTLN(F("delete"));
-    pos -= strlen(key);
+    pos = foundByIndex ? indexedKeyPos : pos - strlen(key);
     if (pos > 3) pos--; //also delete leading comma if not first object
     f.seek(pos);
     writeSpace(pos2 - pos);
-    if (contentLen) return appendObjectToFile(key, content, s, contentLen);
+    if (contentLen) {
+      appendedObjectPos = 0;
+      bool success = appendObjectToFile(key, content, s, contentLen);
+      if (indexed) updatePresetIndex(id, success ? appendedObjectPos : 0, success ? contentLen : 0);
+      return success;
+    }
+    if (indexed) updatePresetIndex(id, 0, 0);
   }
 
   doCloseFile = true;
@@ -324,6 +601,15 @@ bool writeObjectToFile(const char* file, const char* key, JsonDocument* content)
   return true;
 }
 
+bool writeObjectToFile(const char* file, const char* key, JsonDocument* content)
+{
+  if (!isPresetsFile(file)) return writeObject(file, key, content);
+  if (!lockPresetsFile()) return false;
+  bool success = writeObject(file, key, content);
+  unlockPresetsFile();
+  return success;
+}
+
 bool readObjectFromFileUsingId(const char* file, uint16_t id, JsonDocument* dest)
 {
   char objKey[10];
@@ -332,7 +618,7 @@ bool readObjectFromFileUsingId(const char* file, uint16_t id, JsonDocument* dest
 }
 
 //if the key is a nullptr, deserialize entire object
-bool readObjectFromFile(const char* file, const char* key, JsonDocument* dest)
+static bool readObject(const char* file, const char* key, JsonDocument* dest)
 {
   if (doCloseFile) closeFile();
   #ifdef WLED_DEBUG_FS
@@ -342,7 +628,9 @@ bool readObjectFromFile(const char* file, const char* key, JsonDocument* dest)
   f = WLED_FS.open(file, "r");
   if (!f) return false;
 
-  if (key != nullptr && !bufferedFind(key)) //key does not exist in file
+  int8_t found = (key != nullptr && isPresetsFile(file)) ? seekIndexedObject(key) : -1;
+  if (key != nullptr && found < 0) found = bufferedFind(key);
+  if (key != nullptr && !found) //key does not exist in file
   {
     f.close();
     dest->clear();
@@ -357,6 +645,154 @@ bool readObjectFromFile(const char* file, const char* key, JsonDocument* dest)
   return true;
 }
 
+bool readObjectFromFile(const char* file, const char* key, JsonDocument* dest)
+{
+  if (!isPresetsFile(file)) return readObject(file, key, dest);
+  if (!lockPresetsFile()) return false;
+  bool success = readObject(file, key, dest);
+  unlockPresetsFile();
+  return success;
+}
+
+/*
+ * Preset file compaction
+ * Deleted and shrunk objects leave spaces in presets.json that are only reused by objects that fit.
+ * Compaction copies the file without any whitespace outside of strings to /presets.tmp and renames it,
+ * so an interrupted compaction leaves the original file intact, or the complete copy if it was already removed
+ * (see recoverPresetsFile()).
+ * Runs from the main loop once the file has not been written for PRESETS_COMPACT_DELAY and
+ * whitespace exceeds PRESETS_COMPACT_WASTE percent of it, or when requested via JSON API {"pcomp":true}.
+ */
+
+#define PRESETS_COMPACT_DELAY    10000 // ms after the last write
+#define PRESETS_COMPACT_WASTE       25 // % of the file size
+#define PRESETS_COMPACT_MIN_WASTE 2048 // bytes, smaller files are not worth the flash wear
+
+static bool presetsCompactRequested = false;
+
+// copies presets.json to dest without whitespace outside of strings (dest may be closed to only count)
+// counts whitespace bytes and runs of it
+static bool copyPresetsCompacted(File &src, File &dest, uint32_t &wasted, uint16_t &holes)
+{
+  byte buf[FS_BUFSIZE];
+  byte out[FS_BUFSIZE];
+  uint16_t outLen = 0;
+  bool inString = false, escaped = false, inHole = false;
+  wasted = 0;
+  holes = 0;
+  src.seek(0);
+  while (src.available()) {
+    uint16_t bufsize = src.read(buf, FS_BUFSIZE);
+    for (uint16_t i = 0; i < bufsize; i++) {
+      char c = buf[i];
+      if (!inString && (c == ' ' || c == '\t' || c == '\n' || c == '\r')) {
+        wasted++;
+        if (!inHole) holes++;
+        inHole = true;
+        continue;
+      }
+      inHole = false;
+      if (inString) {
+        if (escaped) escaped = false;
+        else if (c == '\\') escaped = true;
+        else if (c == '"') inString = false;
+      } else if (c == '"') inString = true;
+      if (!dest) continue;
+      out[outLen++] = c;
+      if (outLen == FS_BUFSIZE) {
+        if (dest.write(out, outLen) != outLen) return false;
+        outLen = 0;
+      }
+    }
+  }
+  if (dest && outLen && dest.write(out, outLen) != outLen) return false;
+  return true;
+}
+
+static void updatePresetsStats()
+{
+  File pf = WLED_FS.open("/presets.json", "r");
+  File none;
+  presetsWasted = presetsHoles = 0;
+  if (pf) copyPresetsCompacted(pf, none, presetsWasted, presetsHoles);
+  pf.close();
+  presetsStatsValid = true;
+}
+
+static bool compactPresets()
+{
+  #ifdef WLED_DEBUG_FS
+    DEBUGFS_PRINTLN(F("Compact presets"));
+    uint32_t s = millis();
+  #endif
+  File pf = WLED_FS.open("/presets.json", "r");
+  if (!pf) return false;
+  updateFSInfo();
+  if (pf.size() + 4096 > fsBytesTotal - fsBytesUsed) { pf.close(); return false; } //no room for the copy
+
+  File tmp = WLED_FS.open("/presets.tmp", "w");
+  uint32_t wasted;
+  uint16_t holes;
+  bool success = tmp && copyPresetsCompacted(pf, tmp, wasted, holes);
+  pf.close();
+  tmp.close();
+  if (success && !WLED_FS.rename("/presets.tmp", "/presets.json")) {
+    //some file systems do not replace existing files, the copy is renamed at boot if this is interrupted
+    success = WLED_FS.remove("/presets.json") && WLED_FS.rename("/presets.tmp", "/presets.json");
+  }
+  if (!success) {
+    if (WLED_FS.exists("/presets.json")) WLED_FS.remove("/presets.tmp"); //else the copy is all that is left
+    DEBUGFS_PRINTLN(F("Compaction failed"));
+    return false;
+  }
+
+  invalidatePresetIndex(); //object positions changed, rebuilt on next read
+  knownLargestSpace = 0;
+  presetsWasted = presetsHoles = 0;
+  presetsStatsValid = true;
+  updateFSInfo();
+  DEBUGFS_PRINTF("Compacted, took %d ms\n", millis() - s);
+  return true;
+}
+
+void requestPresetsCompaction()
+{
+  presetsCompactRequested = true;
+}
+
+// called from the main loop
+void handlePresetsCompaction()
+{
+  if (!presetsCompactRequested) {
+    if (presetsStatsValid || millis() - presetsLastChange < PRESETS_COMPACT_DELAY) return;
+    if (realtimeMode || currentPlaylist >= 0) return; //do not stall live data or playlist timing
+  }
+
+  //only presets.json is touched, so the JSON buffer stays free. Wait until f (closed by the main loop) is not left open by a write
+  if (!lockPresetsFile(0)) return;
+  if (doCloseFile) { unlockPresetsFile(); return; }
+  if (!presetsStatsValid) updatePresetsStats();
+  File pf = WLED_FS.open("/presets.json", "r");
+  uint32_t size = pf ? pf.size() : 0;
+  pf.close();
+  if (presetsCompactRequested || (presetsWasted >= PRESETS_COMPACT_MIN_WASTE && presetsWasted * 100 >= size * PRESETS_COMPACT_WASTE)) {
+    if (presetsWasted) compactPresets();
+  }
+  presetsCompactRequested = false;
+  unlockPresetsFile();
+}
+
+// called at boot, finishes a compaction that was interrupted between removing presets.json and renaming the copy
+void recoverPresetsFile()
+{
+  #ifdef ARDUINO_ARCH_ESP32
+  if (presetsMutex == nullptr) presetsMutex = xSemaphoreCreateMutex();
+  #endif
+  if (!WLED_FS.exists("/presets.tmp")) return;
+  if (WLED_FS.exists("/presets.json")) WLED_FS.remove("/presets.tmp"); //interrupted while copying
+  else WLED_FS.rename("/presets.tmp", "/presets.json");
+}
+
 void updateFSInfo() {
   #ifdef ARDUINO_ARCH_ESP32
     #if WLED_FS == LITTLEFS || ESP_IDF_VERSION_MAJOR >= 4
@@ -0,0 +1,441 @@
+#include "wled.h"
+
+/*
+ * Effect benchmark and golden frame check
+ * Renders a number of frames of every effect into a RAM-only bus (BusMemory).
+ * The LED outputs are not driven while it runs. Busses and state are restored afterwards.
+ *
+ * Benchmark: {"fxbench":{"frames":20,"grp":1,"mi":false,"lm":false}}
+ * Writes the time per pixel and the heap used by each effect for several strip lengths to /fxbench.json.
+ * "lm" renders through a generated ledmap that reverses the strip. The ledmap of the device is never used,
+ * it is put aside while the benchmark runs, so results do not depend on the installed ledmap.json.
+ * Heap is sampled by service() right after the effect function and by allocateData() (strip.heapLow).
+ * The same benchmark runs on the host with "pio test -e native" (test/test_fx), without the network and file system.
+ *
+ * Golden frames: {"fxbench":{"frames":20,"gold":1}} to record, {"fxbench":{"gold":2}} to verify
+ * Renders every effect on 60 LEDs with seeded random, fixed frame times and the default palette
+ * and hashes the output. Recording writes one CRC32 per effect to /fxgold.json,
+ * verifying compares against it and writes the effects that differ to /fxcheck.json.
+ * Each effect is rendered twice. Effects that do not produce the same frames both times
+ * (e.g. because they use millis() or the hardware RNG) are stored as 0, listed under "skip" and not compared.
+ * tools/fxgold.json holds the reference recorded by the native env (test/test_fx), devices record their own.
+ *
+ * Realtime ingestion: {"fxbench":{"rt":20}}
+ * Feeds synthetic E1.31 frames of the given number of universes (RGB, 170 LEDs each) through handleE131Packet()
+ * for one second and writes the sustained packets and frames per second to /rtbench.json.
+ *
+ * tools/fxbench.py runs these over HTTP and checks the results against tools/fxgold_<arch>.json or an earlier benchmark.
+ */
+
+#ifdef WLED_ENABLE_FX_BENCHMARK
+
+#define FXBENCH_FILE     "/fxbench.json"
+#define FXGOLD_FILE      "/fxgold.json"
+#define FXCHECK_FILE     "/fxcheck.json"
+#define RTBENCH_FILE     "/rtbench.json"
+
+#define FXBENCH_IDLE     0
+#define FXBENCH_REQUEST  1
+#define FXBENCH_SETUP    2
+#define FXBENCH_RUN      3
+#define FXBENCH_FINISH   4
+#define FXBENCH_REALTIME 5
+
+#define FXGOLD_NONE      0
+#define FXGOLD_RECORD    1
+#define FXGOLD_VERIFY    2
+
+#define FXGOLD_LENGTH    60
+#define FXGOLD_SEED      1337
+#define FXGOLD_TIME      1000 //effect time of the first golden frame in ms
+#define FXGOLD_FRAMETIME 25   //effect time between golden frames in ms
+
+#define RTBENCH_TIME     1000 //ms spent feeding realtime packets
+#define RTBENCH_LEDS_PER_UNIVERSE 170
+
+static const uint16_t benchLengths[] = {60, 1000, 8192};
+#define FXBENCH_NUM_LENGTHS (sizeof(benchLengths) / sizeof(benchLengths[0]))
+
+static byte      benchState = FXBENCH_IDLE;
+static byte      benchGold = FXGOLD_NONE;
+static uint16_t  benchFrames = 20;
+static uint8_t   benchGrouping = 1;
+static bool      benchMirror = false;
+static bool      benchLedmap = false;
+static uint16_t* benchSavedMap = nullptr; //ledmap of the device while the benchmark runs
+static uint16_t  benchSavedMapSize = 0;
+static uint8_t   benchLenIdx = 0;
+static uint8_t   benchMode = 0;
+static uint16_t  benchFrame = 0;
+static uint32_t  benchTime = 0;     //us spent in service() for the current effect
+static uint32_t  benchHeapStart = 0;
+static uint8_t   benchPass = 0;     //golden frames: every effect is rendered twice
+static uint32_t  benchCrc[2];
+static uint16_t  benchFailed = 0;
+static uint16_t  benchSkipped = 0;
+static uint8_t   benchSkipMask[(MODE_COUNT + 7) / 8]; //effects recorded as not deterministic
+static uint8_t   benchUniverses = 0;
+static uint32_t* benchGolden = nullptr;
+static File      benchFile;
+static BusConfig* benchBusConfigs[WLED_MAX_BUSSES] = {nullptr};
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len)
+{
+  static const uint32_t crcTable[16] PROGMEM = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = pgm_read_dword(&crcTable[crc & 0x0F]) ^ (crc >> 4);
+    crc = pgm_read_dword(&crcTable[crc & 0x0F]) ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+//can be called from network callbacks, the benchmark itself runs from the main loop
+void startFxBenchmark(uint16_t frames, uint8_t grouping, bool mirror, bool ledmap, byte gold)
+{
+  if (benchState != FXBENCH_IDLE) return;
+  benchFrames = frames ? frames : 1;
+  benchGrouping = grouping ? grouping : 1;
+  benchMirror = mirror;
+  benchLedmap = ledmap;
+  benchGold = (gold > FXGOLD_VERIFY) ? FXGOLD_NONE : gold;
+  benchState = FXBENCH_REQUEST;
+}
+
+void startRealtimeBenchmark(uint8_t universes)
+{
+  if (benchState != FXBENCH_IDLE || !universes) return;
+  benchUniverses = universes;
+  benchGrouping = 1; //setupLength() must not use the options of an earlier effect benchmark
+  benchMirror = false;
+  benchLedmap = false;
+  benchState = FXBENCH_REALTIME;
+}
+
+bool isFxBenchmarkRunning()
+{
+  return benchState != FXBENCH_IDLE;
+}
+
+//installs a ledmap reversing len LEDs, or none, and frees the one used before
+static bool setLedmap(uint16_t len)
+{
+  uint16_t* table = nullptr;
+  if (len) {
+    table = new uint16_t[len];
+    if (table == nullptr) return false;
+    for (uint16_t i = 0; i < len; i++) table[i] = len - 1 - i;
+  }
+  strip.swapLedmap(table, len);
+  delete[] table;
+  return true;
+}
+
+//remember the current bus setup and ledmap so they can be restored after the benchmark
+static void saveBusses()
+{
+  benchSavedMap = nullptr;
+  benchSavedMapSize = 0;
+  strip.swapLedmap(benchSavedMap, benchSavedMapSize);
+  for (uint8_t i = 0; i < WLED_MAX_BUSSES; i++) {
+    Bus *bus = busses.getBus(i);
+    if (bus == nullptr || bus->getLength() == 0) break;
+    benchBusConfigs[i] = new BusConfig(bus->getConfig()); //includes the universe of network busses
+  }
+}
+
+static void restoreBusses()
+{
+  busses.removeAll();
+  for (uint8_t i = 0; i < WLED_MAX_BUSSES; i++) {
+    if (benchBusConfigs[i] == nullptr) break;
+    busses.add(*benchBusConfigs[i]);
+    delete benchBusConfigs[i]; benchBusConfigs[i] = nullptr;
+  }
+  strip.swapLedmap(benchSavedMap, benchSavedMapSize);
+  delete[] benchSavedMap; //the benchmark ledmap, if any
+  benchSavedMap = nullptr;
+  strip.finalizeInit();
+}
+
+//set up a single RAM bus and a single segment covering it
+static bool setupLength(uint16_t len)
+{
+  if (len > MAX_LEDS) return false;
+  busses.removeAll();
+  uint8_t pins[5] = {255, 255, 255, 255, 255};
+  BusConfig bc = BusConfig(TYPE_RESERVED, pins, 0, len);
+  if (busses.add(bc) < 0 || !busses.getBus(0)->isOk()) return false;
+  if (!setLedmap(benchLedmap ? len : 0)) return false;
+  strip.finalizeInit();
+  strip.resetSegments();
+  strip.setSegment(0, 0, len, benchGrouping, 0, 0);
+  strip.getSegment(0).setOption(SEG_OPTION_MIRROR, benchMirror);
+  return true;
+}
+
+//read the recorded hashes from /fxgold.json, frame count is taken from the recording
+static bool loadGolden()
+{
+  #ifdef WLED_USE_DYNAMIC_JSON
+  DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+  #else
+  if (!requestJSONBufferLock(22)) return false;
+  #endif
+
+  if (readObjectFromFile(FXGOLD_FILE, nullptr, &doc)) {
+    JsonArray crc = doc[F("crc")];
+    if (!crc.isNull() && doc["len"] == FXGOLD_LENGTH) {
+      benchFrames = doc[F("frames")] | benchFrames;
+      benchGolden = new uint32_t[MODE_COUNT];
+      for (uint8_t i = 0; i < MODE_COUNT; i++) benchGolden[i] = crc[i].as<uint32_t>(); //not "| 0", an int default drops CRCs >= 2^31
+    }
+  }
+
+  releaseJSONBufferLock();
+  return benchGolden != nullptr;
+}
+
+//start the current effect from a black frame with the same seed every time
+static void restartGolden()
+{
+  for (uint16_t i = 0; i < FXGOLD_LENGTH; i++) busses.setPixelColor(i, 0);
+  strip.restartRuntime();
+  random16_set_seed(FXGOLD_SEED);
+  randomSeed(FXGOLD_SEED);
+  benchCrc[benchPass] = 0;
+}
+
+static void handleGoldenResult()
+{
+  uint32_t crc = (benchCrc[0] == benchCrc[1]) ? benchCrc[0] : 0; //0: effect is not deterministic
+  if (benchGold == FXGOLD_RECORD) {
+    if (benchMode) benchFile.print(',');
+    benchFile.print(crc);
+    if (!crc) benchSkipMask[benchMode >> 3] |= 1 << (benchMode & 7);
+    return;
+  }
+  if (!crc || !benchGolden[benchMode]) {
+    benchSkipped++;
+    return;
+  }
+  if (crc == benchGolden[benchMode]) return;
+  if (benchFailed++) benchFile.print(',');
+  benchFile.print(benchMode);
+  DEBUG_PRINTF("FX %u differs from golden frames\n", benchMode);
+}
+
+static void nextLength()
+{
+  benchFile.print(F("]}"));
+  benchLenIdx++;
+  benchState = (benchLenIdx < FXBENCH_NUM_LENGTHS) ? FXBENCH_SETUP : FXBENCH_FINISH;
+}
+
+//blocks the main loop for RTBENCH_TIME, E1.31 settings and realtime state are restored afterwards
+static void runRealtimeBenchmark()
+{
+  uint8_t universes = benchUniverses;
+  if (universes > E131_MAX_UNIVERSE_COUNT) universes = E131_MAX_UNIVERSE_COUNT;
+  if (universes > MAX_LEDS / RTBENCH_LEDS_PER_UNIVERSE) universes = MAX_LEDS / RTBENCH_LEDS_PER_UNIVERSE;
+
+  File f = WLED_FS.open(RTBENCH_FILE, "w");
+  if (!f) return;
+  e131_packet_t* p = new e131_packet_t;
+  if (p == nullptr) { f.close(); return; }
+  DEBUG_PRINTLN(F("Realtime benchmark started."));
+  saveTemporaryPreset();
+  saveBusses();
+
+  uint16_t oldUniverse = e131Universe;
+  uint16_t oldAddress = DMXAddress;
+  byte oldMode = DMXMode;
+  bool oldSkip = e131SkipOutOfSequence;
+  byte oldOverride = realtimeOverride;
+  int oldOffset = arlsOffset;
+  e131Universe = 1;
+  DMXAddress = 1;
+  DMXMode = DMX_MODE_MULTIPLE_RGB;
+  e131SkipOutOfSequence = false;
+  realtimeOverride = REALTIME_OVERRIDE_NONE;
+  arlsOffset = 0;
+
+  uint32_t packets = 0, frames = 0, elapsed = 0;
+  if (setupLength(universes * RTBENCH_LEDS_PER_UNIVERSE)) {
+    memset(p, 0, sizeof(e131_packet_t));
+    p->property_value_count = htons(RTBENCH_LEDS_PER_UNIVERSE * 3 +1); //+1: start code
+    for (uint16_t i = 1; i <= RTBENCH_LEDS_PER_UNIVERSE * 3; i++) p->property_values[i] = i;
+    IPAddress ip = Network.localIP();
+    uint32_t start = micros();
+    do {
+      for (uint8_t u = 0; u < universes; u++) {
+        p->universe = htons(e131Universe + u);
+        p->sequence_number = frames;
+        p->property_values[1] = frames; //change the data every frame
+        handleE131Packet(p, ip, P_E131);
+        packets++;
+      }
+      strip.show();
+      frames++;
+      yield();
+      elapsed = micros() - start;
+    } while (elapsed < RTBENCH_TIME * 1000UL);
+  }
+
+  e131Universe = oldUniverse;
+  DMXAddress = oldAddress;
+  DMXMode = oldMode;
+  e131SkipOutOfSequence = oldSkip;
+  realtimeOverride = oldOverride;
+  arlsOffset = oldOffset;
+  realtimeTimeout = 0; //leave realtime mode on the next loop
+  delete p;
+
+  uint32_t pps = elapsed ? ((uint64_t)packets * 1000000) / elapsed : 0;
+  uint32_t fps = elapsed ? ((uint64_t)frames * 1000000) / elapsed : 0;
+  f.printf_P(PSTR("{\"uni\":%u,\"leds\":%u,\"pps\":%u,\"fps\":%u}"), universes, universes * RTBENCH_LEDS_PER_UNIVERSE, pps, fps);
+  f.close();
+  DEBUG_PRINTF("Realtime benchmark: %u universes, %u packets/s, %u frames/s\n", universes, pps, fps);
+  restoreBusses();
+  applyPreset(255, CALL_MODE_NO_NOTIFY);
+  updateFSInfo();
+}
+
+//call from the main loop instead of strip.service(), returns false if no benchmark is running
+bool handleFxBenchmark()
+{
+  switch (benchState) {
+    case FXBENCH_IDLE: return false;
+
+    case FXBENCH_REQUEST: {
+      if (benchGold == FXGOLD_VERIFY && !loadGolden()) { benchState = FXBENCH_IDLE; return false; }
+      const char* fileName = FXBENCH_FILE;
+      if (benchGold == FXGOLD_RECORD) fileName = FXGOLD_FILE;
+      if (benchGold == FXGOLD_VERIFY) fileName = FXCHECK_FILE;
+      benchFile = WLED_FS.open(fileName, "w");
+      if (!benchFile) {
+        delete[] benchGolden; benchGolden = nullptr;
+        benchState = FXBENCH_IDLE;
+        return false;
+      }
+      DEBUG_PRINTLN(F("FX benchmark started."));
+      saveTemporaryPreset(); //current state is restored from /tmp.snap afterwards
+      saveBusses();
+      switch (benchGold) {
+        case FXGOLD_NONE:
+          benchFile.printf_P(PSTR("{\"frames\":%u,\"grp\":%u,\"mi\":%u,\"lm\":%u,\"fx\":["), benchFrames, benchGrouping, benchMirror, benchLedmap); break;
+        case FXGOLD_RECORD:
+          benchFile.printf_P(PSTR("{\"vid\":%d,\"len\":%u,\"frames\":%u,\"crc\":["), VERSION, FXGOLD_LENGTH, benchFrames); break;
+        case FXGOLD_VERIFY:
+          benchFile.print(F("{\"fail\":[")); break;
+      }
+      benchLenIdx = 0;
+      benchFailed = 0;
+      benchSkipped = 0;
+      memset(benchSkipMask, 0, sizeof(benchSkipMask));
+      benchState = FXBENCH_SETUP;
+      return true;
+    }
+
+    case FXBENCH_SETUP: {
+      if (benchGold) {
+        benchGrouping = 1;
+        benchMirror = false;
+        benchLedmap = false;
+        if (!setupLength(FXGOLD_LENGTH)) { benchState = FXBENCH_FINISH; return true; }
+      } else {
+        uint16_t len = benchLengths[benchLenIdx];
+        if (benchLenIdx) benchFile.print(',');
+        benchFile.printf_P(PSTR("{\"len\":%u,\"res\":["), len);
+        if (!setupLength(len)) { //length not supported or not enough RAM
+          nextLength();
+          return true;
+        }
+      }
+      benchMode = 0;
+      benchFrame = 0;
+      benchPass = 0;
+      benchState = FXBENCH_RUN;
+      return true;
+    }
+
+    case FXBENCH_RUN: {
+      if (millis() - strip.getLastShow() < 16) return true; //service() would skip the frame
+      if (benchFrame == 0) {
+        if (benchPass == 0) strip.setMode(0, benchMode);
+        if (benchGold) restartGolden();
+        benchTime = 0;
+        benchHeapStart = strip.heapLow = ESP.getFreeHeap(); //sampled by service() after the effect function and on allocateData()
+      }
+      if (benchGold) strip.fixedNow = FXGOLD_TIME + benchFrame * FXGOLD_FRAMETIME;
+      uint32_t start = micros();
+      strip.trigger();
+      strip.service();
+      benchTime += micros() - start;
+      strip.sampleHeap();
+
+      if (benchGold) {
+        strip.fixedNow = 0;
+        const uint32_t* pixels = static_cast<BusMemory*>(busses.getBus(0))->getPixels();
+        benchCrc[benchPass] = crc32(benchCrc[benchPass], (const uint8_t*)pixels, FXGOLD_LENGTH * sizeof(uint32_t));
+      }
+
+      if (++benchFrame < benchFrames) return true;
+      benchFrame = 0;
+
+      if (benchGold) {
+        if (++benchPass < 2) return true; //render the same frames again to find non-deterministic effects
+        benchPass = 0;
+        handleGoldenResult();
+        if (++benchMode >= strip.getModeCount()) benchState = FXBENCH_FINISH;
+        return true;
+      }
+
+      uint64_t pixels = (uint64_t)benchFrames * benchLengths[benchLenIdx];
+      uint32_t nsPerPixel = ((uint64_t)benchTime * 1000) / pixels;
+      if (benchMode) benchFile.print(',');
+      //[ns per pixel, heap used by the effect in bytes]
+      benchFile.printf_P(PSTR("[%u,%u]"), nsPerPixel, benchHeapStart - strip.heapLow);
+      DEBUG_PRINTF("FX %u len %u: %u ns/px, %u B\n", benchMode, benchLengths[benchLenIdx], nsPerPixel, benchHeapStart - strip.heapLow);
+
+      if (++benchMode >= strip.getModeCount()) nextLength();
+      return true;
+    }
+
+    case FXBENCH_REALTIME:
+      runRealtimeBenchmark();
+      benchState = FXBENCH_IDLE;
+      return true;
+
+    case FXBENCH_FINISH:
+      if (benchGold == FXGOLD_VERIFY) benchFile.printf_P(PSTR("],\"skip\":%u}"), benchSkipped);
+      else if (benchGold == FXGOLD_RECORD) {
+        benchFile.print(F("],\"skip\":["));
+        bool first = true;
+        for (uint8_t i = 0; i < MODE_COUNT; i++) {
+          if (!(benchSkipMask[i >> 3] & (1 << (i & 7)))) continue;
+          if (!first) benchFile.print(',');
+          benchFile.print(i);
+          first = false;
+        }
+        benchFile.print(F("]}"));
+      }
+      else benchFile.print(F("]}"));
+      benchFile.close();
+      strip.heapLow = 0;
+      delete[] benchGolden; benchGolden = nullptr;
+      restoreBusses();
+      applyPreset(255, CALL_MODE_NO_NOTIFY);
+      updateFSInfo();
+      DEBUG_PRINTLN(F("FX benchmark done."));
+      benchState = FXBENCH_IDLE;
+      return true;
+  }
+  return false;
+}
+
+#endif
@@ -63,7 +63,9 @@ void updateColor(double hue, double sat) {
 
     uint32_t color = ((rgb[0] << 16) | (rgb[1] << 8) | (rgb[2]));
 
+    strip.lockRender();
     strip.setColor(0, color);
+    strip.unlockRender();
     stateUpdated(CALL_MODE_HOMEKIT);
 }
 
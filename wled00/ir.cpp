@@ -90,6 +90,7 @@ byte relativeChange(byte property, int8_t amount, byte lowerBoundary, byte highe
 
 void changeEffect(uint8_t fx)
 {
+  strip.lockRender(); //IR codes are decoded without the render lock, presets must not be loaded under it
   if (irApplyToAllSelected) {
     for (uint8_t i = 0; i < strip.getMaxSegments(); i++) {
       WS2812FX::Segment& seg = strip.getSegment(i);
@@ -102,10 +103,12 @@ void changeEffect(uint8_t fx)
     setValuesFromMainSeg();
   }
   stateChanged = true;
+  strip.unlockRender();
 }
 
 void changePalette(uint8_t pal)
 {
+  strip.lockRender();
   if (irApplyToAllSelected) {
     for (uint8_t i = 0; i < strip.getMaxSegments(); i++) {
       WS2812FX::Segment& seg = strip.getSegment(i);
@@ -118,10 +121,12 @@ void changePalette(uint8_t pal)
     setValuesFromMainSeg();
   }
   stateChanged = true;
+  strip.unlockRender();
 }
 
 void changeEffectSpeed(int8_t amount)
 {
+  strip.lockRender();
   if (effectCurrent != 0) {
     int16_t new_val = (int16_t) effectSpeed + amount;
     effectSpeed = (byte)constrain(new_val,0,255);
@@ -165,10 +170,12 @@ void changeEffectSpeed(int8_t amount)
   if(amount > 0) lastRepeatableAction = ACTION_SPEED_UP;
   if(amount < 0) lastRepeatableAction = ACTION_SPEED_DOWN;
   lastRepeatableValue = amount;
+  strip.unlockRender();
 }
 
 void changeEffectIntensity(int8_t amount)
 {
+  strip.lockRender();
   if (effectCurrent != 0) {
     int16_t new_val = (int16_t) effectIntensity + amount;
     effectIntensity = (byte)constrain(new_val,0,255);
@@ -210,10 +217,12 @@ void changeEffectIntensity(int8_t amount)
   if(amount > 0) lastRepeatableAction = ACTION_INTENSITY_UP;
   if(amount < 0) lastRepeatableAction = ACTION_INTENSITY_DOWN;
   lastRepeatableValue = amount;
+  strip.unlockRender();
 }
 
 void changeColor(uint32_t c, int16_t cct=-1)
 {
+  strip.lockRender();
   if (irApplyToAllSelected) {
     // main segment may not be selected!
     for (uint8_t i = 0; i < strip.getMaxSegments(); i++) {
@@ -249,6 +258,7 @@ void changeColor(uint32_t c, int16_t cct=-1)
     setValuesFromMainSeg();
   }
   stateChanged = true;
+  strip.unlockRender();
 }
 
 void changeWhite(int8_t amount, int16_t cct=-1)
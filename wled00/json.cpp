@@ -1,6 +1,7 @@
 #include "wled.h"
 
 #include "palettes.h"
+#include "json_stream.h"
 
 /*
  * JSON API (De)serialization
@@ -238,6 +239,8 @@ bool deserializeState(JsonObject root, byte callMode, byte presetId)
 {
   bool stateResponse = root[F("v")] | false;
 
+  strip.lockRender(); //presets below are loaded and saved without the lock
+
   getVal(root["bri"], &bri);
 
   bool on = root["on"] | (bri > 0);
@@ -286,6 +289,16 @@ bool deserializeState(JsonObject root, byte callMode, byte presetId)
   }
 
   doReboot = root[F("rb")] | doReboot;
+  if (root[F("pcomp")]) requestPresetsCompaction(); //rewrite presets.json without unused space
+
+  if (root[F("rstperf")]) { //clear main loop and render time statistics
+    resetLoopPerf();
+    strip.resetPerf();
+    e131FramesTorn = e131FramesLate = e131FramesDropped = 0;
+    resetRealtimeStats();
+    resetPresetCacheStats();
+    resetJSONBufferLockStats();
+  }
 
   realtimeOverride = root[F("lor")] | realtimeOverride;
   if (realtimeOverride > 2) realtimeOverride = REALTIME_OVERRIDE_ALWAYS;
@@ -340,6 +353,15 @@ bool deserializeState(JsonObject root, byte callMode, byte presetId)
 
   loadLedmap = root[F("ledmap")] | loadLedmap;
 
+  #ifdef WLED_ENABLE_FX_BENCHMARK
+  JsonObject fxbench = root[F("fxbench")];
+  if (!fxbench.isNull()) {
+    if (fxbench["rt"]) startRealtimeBenchmark(fxbench["rt"]);
+    else startFxBenchmark(fxbench[F("frames")] | 20, fxbench["grp"] | 1, fxbench[F("mi")] | false, fxbench["lm"] | false, fxbench[F("gold")] | 0);
+  }
+  #endif
+  strip.unlockRender();
+
   byte ps = root[F("psave")];
   if (ps > 0) {
     savePreset(ps, true, nullptr, root);
@@ -380,24 +402,30 @@ bool deserializeState(JsonObject root, byte callMode, byte presetId)
   return stateResponse;
 }
 
-void serializeSegment(JsonObject& root, WS2812FX::Segment& seg, byte id, bool forPreset, bool segmentBounds)
+/*
+ * Segment, state and info JSON are written by the templates below through a JsonObjectWriter (JsonObject)
+ * or a JsonStreamWriter (streamJson(), without the JSON buffer), see json_stream.h
+ */
+
+template <class W>
+static void writeSegment(W& w, WS2812FX::Segment& seg, byte id, bool forPreset, bool segmentBounds)
 {
-  root["id"] = id;
+  w.add("id", id);
   if (segmentBounds) {
-    root["start"] = seg.start;
-    root["stop"] = seg.stop;
-  }
-  if (!forPreset) root["len"] = seg.stop - seg.start;
-  root["grp"] = seg.grouping;
-  root[F("spc")] = seg.spacing;
-  root[F("of")] = seg.offset;
-  root["on"] = seg.getOption(SEG_OPTION_ON);
-  root["frz"] = seg.getOption(SEG_OPTION_FREEZE);
+    w.add("start", seg.start);
+    w.add("stop", seg.stop);
+  }
+  if (!forPreset) w.add("len", seg.stop - seg.start);
+  w.add("grp", seg.grouping);
+  w.add(F("spc"), seg.spacing);
+  w.add(F("of"), seg.offset);
+  w.add("on", seg.getOption(SEG_OPTION_ON));
+  w.add("frz", seg.getOption(SEG_OPTION_FREEZE));
   byte segbri = seg.opacity;
-  root["bri"] = (segbri) ? segbri : 255;
-  root["cct"] = seg.cct;
+  w.add("bri", (segbri) ? segbri : 255);
+  w.add("cct", seg.cct);
 
-  if (segmentBounds && seg.name != nullptr) root["n"] = reinterpret_cast<const char *>(seg.name); //not good practice, but decreases required JSON buffer
+  if (segmentBounds && seg.name != nullptr) w.add("n", reinterpret_cast<const char *>(seg.name)); //not good practice, but decreases required JSON buffer
 
   // to conserve RAM we will serialize the col array manually
   // this will reduce RAM footprint from ~300 bytes to 84 bytes per segment
@@ -415,64 +443,92 @@ void serializeSegment(JsonObject& root, WS2812FX::Segment& seg, byte id, bool fo
     strcat(colstr, i<2 ? strcat(tmpcol, ",") : tmpcol);
   }
   strcat(colstr, "]");
-  root["col"] = serialized(colstr);
-
-  root["fx"]     = seg.mode;
-  root[F("sx")]  = seg.speed;
-  root[F("ix")]  = seg.intensity;
-  root["pal"]    = seg.palette;
-  root[F("sel")] = seg.isSelected();
-  root["rev"]    = seg.getOption(SEG_OPTION_REVERSED);
-  root[F("mi")]  = seg.getOption(SEG_OPTION_MIRROR);
+  w.addRaw("col", colstr);
+
+  w.add("fx",     seg.mode);
+  w.add(F("sx"),  seg.speed);
+  w.add(F("ix"),  seg.intensity);
+  w.add("pal",    seg.palette);
+  w.add(F("sel"), seg.isSelected());
+  w.add("rev",    seg.getOption(SEG_OPTION_REVERSED));
+  w.add(F("mi"),  seg.getOption(SEG_OPTION_MIRROR));
 }
 
-void serializeState(JsonObject root, bool forPreset, bool includeBri, bool segmentBounds)
+static void usermodsState(JsonObject root) { usermods.addToJsonState(root); }
+static void usermodsInfo(JsonObject root)  { usermods.addToJsonInfo(root); }
+
+//error is written instead of errorFlag, so the same output can be measured before it is streamed
+template <class W>
+static void writeState(W& w, bool forPreset, bool includeBri, bool segmentBounds, byte error)
 {
   if (includeBri) {
-    root["on"] = (bri > 0);
-    root["bri"] = briLast;
-    root[F("transition")] = transitionDelay/100; //in 100ms
+    w.add("on", (bri > 0));
+    w.add("bri", briLast);
+    w.add(F("transition"), transitionDelay/100); //in 100ms
   }
 
   if (!forPreset) {
-    if (errorFlag) {root[F("error")] = errorFlag; errorFlag = ERR_NONE;} //prevent error message to persist on screen
+    if (error) w.add(F("error"), error);
 
-    root["ps"] = (currentPreset > 0) ? currentPreset : -1;
-    root[F("pl")] = currentPlaylist;
+    w.add("ps", (currentPreset > 0) ? currentPreset : -1);
+    w.add(F("pl"), currentPlaylist);
 
-    usermods.addToJsonState(root);
+    if (usermods.getModCount()) w.merge(usermodsState);
 
-    JsonObject nl = root.createNestedObject("nl");
-    nl["on"] = nightlightActive;
-    nl["dur"] = nightlightDelayMins;
-    nl["mode"] = nightlightMode;
-    nl[F("tbri")] = nightlightTargetBri;
+    w.beginObject("nl");
+    w.add("on", nightlightActive);
+    w.add("dur", nightlightDelayMins);
+    w.add("mode", nightlightMode);
+    w.add(F("tbri"), nightlightTargetBri);
     if (nightlightActive) {
-      nl[F("rem")] = (nightlightDelayMs - (millis() - nightlightStartTime)) / 1000; // seconds remaining
+      w.add(F("rem"), (nightlightDelayMs - (millis() - nightlightStartTime)) / 1000); // seconds remaining
     } else {
-      nl[F("rem")] = -1;
+      w.add(F("rem"), -1);
     }
+    w.endObject();
 
-    JsonObject udpn = root.createNestedObject("udpn");
-    udpn["send"] = notifyDirect;
-    udpn["recv"] = receiveNotifications;
+    w.beginObject("udpn");
+    w.add("send", notifyDirect);
+    w.add("recv", receiveNotifications);
+    w.endObject();
 
-    root[F("lor")] = realtimeOverride;
+    w.add(F("lor"), realtimeOverride);
   }
 
-  root[F("mainseg")] = strip.getMainSegmentId();
+  w.add(F("mainseg"), strip.getMainSegmentId());
 
-  JsonArray seg = root.createNestedArray("seg");
+  w.beginArray("seg");
   for (byte s = 0; s < strip.getMaxSegments(); s++) {
     WS2812FX::Segment &sg = strip.getSegment(s);
     if (sg.isActive()) {
-      JsonObject seg0 = seg.createNestedObject();
-      serializeSegment(seg0, sg, s, forPreset, segmentBounds);
+      w.beginObject();
+      writeSegment(w, sg, s, forPreset, segmentBounds);
+      w.endObject();
     } else if (forPreset && segmentBounds) { //disable segments not part of preset
-      JsonObject seg0 = seg.createNestedObject();
-      seg0["stop"] = 0;
+      w.beginObject();
+      w.add("stop", 0);
+      w.endObject();
     }
   }
+  w.endArray();
+}
+
+void serializeSegment(JsonObject& root, WS2812FX::Segment& seg, byte id, bool forPreset, bool segmentBounds)
+{
+  JsonObjectWriter w(root);
+  writeSegment(w, seg, id, forPreset, segmentBounds);
+}
+
+void serializeState(JsonObject root, bool forPreset, bool includeBri, bool segmentBounds)
+{
+  JsonObjectWriter w(root);
+  writeState(w, forPreset, includeBri, segmentBounds, forPreset ? ERR_NONE : errorFlag);
+  if (!forPreset) errorFlag = ERR_NONE; //prevent error message to persist on screen
+}
+
+void streamState(JsonStreamWriter& w, byte error)
+{
+  writeState(w, false, true, true, error);
 }
 
 //by https://github.com/tzapu/WiFiManager/blob/master/WiFiManager.cpp
@@ -495,119 +551,180 @@ int getSignalQuality(int rssi)
     return quality;
 }
 
-void serializeInfo(JsonObject root)
+//render times in us: "seg": [segment id, effect id, last, max, average] for each active segment, others [last, max, average]
+//"net": packet statistics of network busses
+void serializePerf(JsonObject root)
 {
-  root[F("ver")] = versionString;
-  root[F("vid")] = VERSION;
-  //root[F("cn")] = WLED_CODENAME;
-
-  JsonObject leds = root.createNestedObject("leds");
-  leds[F("count")] = strip.getLengthTotal();
-  leds[F("rgbw")] = strip.hasRGBWBus();         //deprecated, use info.leds.lc
-  leds[F("wv")] = false;                        //deprecated, use info.leds.lc
-  leds["cct"] = correctWB || strip.hasCCTBus(); //deprecated, use info.leds.lc
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  JsonArray seg = root.createNestedArray("seg");
+  for (uint8_t s = 0; s < strip.getMaxSegments(); s++) {
+    WS2812FX::Segment &sg = strip.getSegment(s);
+    if (!sg.isActive()) continue;
+    const WS2812FX::perf_stat &p = strip.getSegmentPerf(s);
+    JsonArray sp = seg.createNestedArray();
+    sp.add(s); sp.add(sg.mode);
+    sp.add(p.last / mhz); sp.add(p.max / mhz); sp.add(p.avg / mhz);
+  }
+  const WS2812FX::perf_stat* stats[] = {&strip.getShowPerf(), &strip.getABLPerf(), &strip.getBusShowPerf()};
+  const char* names[] = {"show", "abl", "bus"};
+  for (uint8_t i = 0; i < 3; i++) {
+    JsonArray sp = root.createNestedArray(names[i]);
+    sp.add(stats[i]->last / mhz); sp.add(stats[i]->max / mhz); sp.add(stats[i]->avg / mhz);
+  }
+  //network busses: [bus, frames, packets, errors, packet build time of last frame (us), max build time (us)]
+  JsonArray net = root.createNestedArray("net");
+  for (uint8_t b = 0; b < busses.getNumBusses(); b++) {
+    Bus *bus = busses.getBus(b);
+    if (bus->getType() < TYPE_NET_DDP_RGB || bus->getType() >= 96) continue;
+    const RealtimeOutStats &ns = static_cast<BusNetwork*>(bus)->getStats();
+    JsonArray np = net.createNestedArray();
+    np.add(b); np.add(ns.frames); np.add(ns.packets); np.add(ns.errors); np.add(ns.buildTime); np.add(ns.buildTimeMax);
+  }
+}
+
+//stats: include the statistics objects, left out of WebSocket pushes (/json/info has them, {"pf":true} and {"rt":true} stream perf and rtin)
+template <class W>
+static void writeInfo(W& w, bool stats = true)
+{
+  w.add(F("ver"), versionString);
+  w.add(F("vid"), VERSION);
+  //w.add(F("cn"), WLED_CODENAME);
+
+  w.beginObject("leds");
+  w.add(F("count"), strip.getLengthTotal());
+  w.add(F("rgbw"), strip.hasRGBWBus());         //deprecated, use info.leds.lc
+  bool wv = false;
   switch (Bus::getAutoWhiteMode()) {
     case RGBW_MODE_MANUAL_ONLY:
     case RGBW_MODE_DUAL:
-      if (strip.hasWhiteChannel()) leds[F("wv")] = true;
+      if (strip.hasWhiteChannel()) wv = true;
       break;
   }
+  w.add(F("wv"), wv);                           //deprecated, use info.leds.lc
+  w.add("cct", correctWB || strip.hasCCTBus()); //deprecated, use info.leds.lc
+
+  w.add(F("pwr"), strip.currentMilliamps);
+  w.beginArray(F("bpwr")); //estimated mA per bus, without ESP power
+  for (uint8_t b = 0; b < busses.getNumBusses(); b++) w.push(strip.getBusCurrent(b));
+  w.endArray();
+  w.add("fps", strip.getFps());
+  w.add(F("maxpwr"), (strip.currentMilliamps)? strip.ablMilliampsMax : 0);
+  w.add(F("maxseg"), strip.getMaxSegments());
+  //w.add(F("seglock"), false); //might be used in the future to prevent modifications to segment config
 
-  leds[F("pwr")] = strip.currentMilliamps;
-  leds["fps"] = strip.getFps();
-  leds[F("maxpwr")] = (strip.currentMilliamps)? strip.ablMilliampsMax : 0;
-  leds[F("maxseg")] = strip.getMaxSegments();
-  //leds[F("seglock")] = false; //might be used in the future to prevent modifications to segment config
-  
   uint8_t totalLC = 0;
-  JsonArray lcarr = leds.createNestedArray(F("seglc"));
+  w.beginArray(F("seglc"));
   uint8_t nSegs = strip.getLastActiveSegmentId();
   for (byte s = 0; s <= nSegs; s++) {
     uint8_t lc = strip.getSegment(s).getLightCapabilities();
     totalLC |= lc;
-    lcarr.add(lc);
+    w.push(lc);
   }
+  w.endArray();
+
+  w.add("lc", totalLC);
+  w.endObject();
 
-  leds["lc"] = totalLC;
+  if (stats) w.addObject(F("perf"), serializePerf);
 
-  root[F("str")] = syncToggleReceive;
+  w.add(F("str"), syncToggleReceive);
 
-  root[F("name")] = serverDescription;
-  root[F("udpport")] = udpPort;
-  root["live"] = (bool)realtimeMode;
+  w.add(F("name"), serverDescription);
+  w.add(F("udpport"), udpPort);
+  w.add("live", (bool)realtimeMode);
 
   switch (realtimeMode) {
-    case REALTIME_MODE_INACTIVE: root["lm"] = ""; break;
-    case REALTIME_MODE_GENERIC:  root["lm"] = ""; break;
-    case REALTIME_MODE_UDP:      root["lm"] = F("UDP"); break;
-    case REALTIME_MODE_HYPERION: root["lm"] = F("Hyperion"); break;
-    case REALTIME_MODE_E131:     root["lm"] = F("E1.31"); break;
-    case REALTIME_MODE_ADALIGHT: root["lm"] = F("USB Adalight/TPM2"); break;
-    case REALTIME_MODE_ARTNET:   root["lm"] = F("Art-Net"); break;
-    case REALTIME_MODE_TPM2NET:  root["lm"] = F("tpm2.net"); break;
-    case REALTIME_MODE_DDP:      root["lm"] = F("DDP"); break;
+    case REALTIME_MODE_UDP:      w.add("lm", F("UDP")); break;
+    case REALTIME_MODE_HYPERION: w.add("lm", F("Hyperion")); break;
+    case REALTIME_MODE_E131:     w.add("lm", F("E1.31")); break;
+    case REALTIME_MODE_ADALIGHT: w.add("lm", F("USB Adalight/TPM2")); break;
+    case REALTIME_MODE_ARTNET:   w.add("lm", F("Art-Net")); break;
+    case REALTIME_MODE_TPM2NET:  w.add("lm", F("tpm2.net")); break;
+    case REALTIME_MODE_DDP:      w.add("lm", F("DDP")); break;
+    default:                     w.add("lm", ""); break; //inactive, generic
   }
 
   if (realtimeIP[0] == 0)
   {
-    root[F("lip")] = "";
+    w.add(F("lip"), "");
   } else {
-    root[F("lip")] = realtimeIP.toString();
+    w.add(F("lip"), realtimeIP.toString());
+  }
+
+  if (stats) {
+    w.addObject(F("rtin"), serializeRealtimeStats);
+    w.addObject(F("jbuf"), serializeRealtimeBuffer);
+    w.addObject(F("pcache"), serializePresetCache);
+    w.addObject(F("jlock"), serializeJSONBufferLockStats);
   }
 
+  w.beginArray(F("e131"));
+  w.push(e131FramesTorn);
+  w.push(e131FramesLate);
+  w.push(e131FramesDropped);
+  w.endArray();
+
   #ifdef WLED_ENABLE_WEBSOCKETS
-  root[F("ws")] = ws.count();
+  w.add(F("ws"), ws.count());
   #else
-  root[F("ws")] = -1;
+  w.add(F("ws"), -1);
   #endif
 
-  root[F("fxcount")] = strip.getModeCount();
-  root[F("palcount")] = strip.getPaletteCount();
+  w.add(F("fxcount"), strip.getModeCount());
+  w.add(F("palcount"), strip.getPaletteCount());
 
-  JsonObject wifi_info = root.createNestedObject("wifi");
-  wifi_info[F("bssid")] = WiFi.BSSIDstr();
+  w.beginObject("wifi");
+  w.add(F("bssid"), WiFi.BSSIDstr());
   int qrssi = WiFi.RSSI();
-  wifi_info[F("rssi")] = qrssi;
-  wifi_info[F("signal")] = getSignalQuality(qrssi);
-  wifi_info[F("channel")] = WiFi.channel();
+  w.add(F("rssi"), qrssi);
+  w.add(F("signal"), getSignalQuality(qrssi));
+  w.add(F("channel"), WiFi.channel());
+  #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_DEBUG)
+  w.add(F("txPower"), (int) WiFi.getTxPower());
+  w.add(F("sleep"), (bool) WiFi.getSleep());
+  #endif
+  w.endObject();
+
+  w.beginObject("fs");
+  w.add("u", fsBytesUsed / 1000);
+  w.add("t", fsBytesTotal / 1000);
+  w.add(F("pmt"), presetsModifiedTime);
+  w.add(F("pw"), presetsWasted); //bytes
+  w.add(F("ph"), presetsHoles);
+  w.endObject();
 
-  JsonObject fs_info = root.createNestedObject("fs");
-  fs_info["u"] = fsBytesUsed / 1000;
-  fs_info["t"] = fsBytesTotal / 1000;
-  fs_info[F("pmt")] = presetsModifiedTime;
+  w.add(F("ndc"), nodeListEnabled ? (int)Nodes.size() : -1);
 
-  root[F("ndc")] = nodeListEnabled ? (int)Nodes.size() : -1;
-  
   #ifdef ARDUINO_ARCH_ESP32
+  w.add(F("arch"), "esp32");
+  w.add(F("core"), ESP.getSdkVersion());
+  //w.add(F("maxalloc"), ESP.getMaxAllocHeap());
   #ifdef WLED_DEBUG
-    wifi_info[F("txPower")] = (int) WiFi.getTxPower();
-    wifi_info[F("sleep")] = (bool) WiFi.getSleep();
+    w.add(F("resetReason0"), (int)rtc_get_reset_reason(0));
+    w.add(F("resetReason1"), (int)rtc_get_reset_reason(1));
   #endif
-  root[F("arch")] = "esp32";
-  root[F("core")] = ESP.getSdkVersion();
-  //root[F("maxalloc")] = ESP.getMaxAllocHeap();
-  #ifdef WLED_DEBUG
-    root[F("resetReason0")] = (int)rtc_get_reset_reason(0);
-    root[F("resetReason1")] = (int)rtc_get_reset_reason(1);
-  #endif
-  root[F("lwip")] = 0; //deprecated
+  w.add(F("lwip"), 0); //deprecated
   #else
-  root[F("arch")] = "esp8266";
-  root[F("core")] = ESP.getCoreVersion();
-  //root[F("maxalloc")] = ESP.getMaxFreeBlockSize();
+  w.add(F("arch"), "esp8266");
+  w.add(F("core"), ESP.getCoreVersion());
+  //w.add(F("maxalloc"), ESP.getMaxFreeBlockSize());
   #ifdef WLED_DEBUG
-    root[F("resetReason")] = (int)ESP.getResetInfoPtr()->reason;
+    w.add(F("resetReason"), (int)ESP.getResetInfoPtr()->reason);
   #endif
-  root[F("lwip")] = LWIP_VERSION_MAJOR;
+  w.add(F("lwip"), LWIP_VERSION_MAJOR);
   #endif
 
-  root[F("freeheap")] = ESP.getFreeHeap();
+  w.add(F("freeheap"), ESP.getFreeHeap());
   #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_USE_PSRAM)
-  if (psramFound()) root[F("psram")] = ESP.getFreePsram();
+  if (psramFound()) w.add(F("psram"), ESP.getFreePsram());
+  #endif
+  w.add(F("uptime"), millis()/1000 + rolloverMillis*4294967);
+  w.add(F("lps"), getLoopsPerSec());
+  #ifdef WLED_ENABLE_FX_BENCHMARK
+  w.add(F("fxb"), isFxBenchmarkRunning()); //tools/fxbench.py waits for this
   #endif
-  root[F("uptime")] = millis()/1000 + rolloverMillis*4294967;
 
-  usermods.addToJsonInfo(root);
+  if (usermods.getModCount()) w.merge(usermodsInfo);
 
   byte os = 0;
   #ifdef WLED_DEBUG
@@ -634,18 +751,29 @@ void serializeInfo(JsonObject root)
   #ifndef WLED_DISABLE_OTA
   os += 0x01;
   #endif
-  root[F("opt")] = os;
+  w.add(F("opt"), os);
 
-  root[F("brand")] = "WLED";
-  root[F("product")] = F("FOSS");
-  root["mac"] = escapedMac;
+  w.add(F("brand"), "WLED");
+  w.add(F("product"), F("FOSS"));
+  w.add("mac", escapedMac);
   char s[16] = "";
   if (Network.isConnected())
   {
     IPAddress localIP = Network.localIP();
     sprintf(s, "%d.%d.%d.%d", localIP[0], localIP[1], localIP[2], localIP[3]);
   }
-  root["ip"] = s;
+  w.add("ip", s);
+}
+
+void serializeInfo(JsonObject root)
+{
+  JsonObjectWriter w(root);
+  writeInfo(w);
+}
+
+void streamInfo(JsonStreamWriter& w, bool stats)
+{
+  writeInfo(w, stats);
 }
 
 void setPaletteColors(JsonArray json, CRGBPalette16 palette)
@@ -806,6 +934,13 @@ void serializeNodes(JsonObject root)
       node["ip"]      = it->second.ip.toString();
       node[F("age")]  = it->second.age;
       node[F("vid")]  = it->second.build;
+      if (it->second.timeSync) {
+        node[F("ts")]   = it->second.timeSource;
+        node[F("toff")] = it->second.timeOffset; // us
+        node[F("tjit")] = it->second.timeJitter; // us
+        node[F("rtt")]  = it->second.timeRtt;    // us
+        node[F("tref")] = (it->first == getTimeSyncReference());
+      }
     }
   }
 }
@@ -819,6 +954,7 @@ void serveJson(AsyncWebServerRequest* request)
   else if (url.indexOf("si")    > 0) subJson = 3;
   else if (url.indexOf("nodes") > 0) subJson = 4;
   else if (url.indexOf("palx")  > 0) subJson = 5;
+  else if (url.indexOf("perf")  > 0) subJson = 6;
   #ifdef WLED_ENABLE_JSONLIVE
   else if (url.indexOf("live")  > 0) {
     serveLiveLeds(request);
@@ -841,6 +977,20 @@ void serveJson(AsyncWebServerRequest* request)
     return;
   }
 
+  if (subJson >= JSON_STREAM_STATE && subJson <= JSON_STREAM_STATE_INFO) { //written directly, without the JSON buffer
+    byte error = errorFlag;
+    size_t len = measureStreamJson(subJson, error);
+    AsyncResponseStream *response = len ? request->beginResponseStream("application/json", len + JSON_STREAM_SLACK) : nullptr;
+    if (!response || !streamJson(*response, subJson, error)) {
+      delete response;
+      request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+      return;
+    }
+    if (subJson != JSON_STREAM_INFO && errorFlag == error) errorFlag = ERR_NONE; //prevent error message to persist on screen
+    request->send(response);
+    return;
+  }
+
   #ifdef WLED_USE_DYNAMIC_JSON
   AsyncJsonResponse* response = new AsyncJsonResponse(JSON_BUFFER_SIZE);
   #else
@@ -852,24 +1002,24 @@ void serveJson(AsyncWebServerRequest* request)
 
   switch (subJson)
   {
-    case 1: //state
-      serializeState(lDoc); break;
-    case 2: //info
-      serializeInfo(lDoc); break;
     case 4: //node list
       serializeNodes(lDoc); break;
     case 5: //palettes
       serializePalettes(lDoc, request); break;
-    default: //all
+    case 6: { //main loop and render times
+      serializeLoopPerf(lDoc);
+      JsonObject perf = lDoc.createNestedObject(F("fx"));
+      serializePerf(perf);
+      } break;
+    default: //all, effect and palette names are sent from flash
+      strip.lockRender();
       JsonObject state = lDoc.createNestedObject("state");
       serializeState(state);
       JsonObject info = lDoc.createNestedObject("info");
       serializeInfo(info);
-      if (subJson != 3)
-      {
-        doc[F("effects")]  = serialized((const __FlashStringHelper*)JSON_mode_names);
-        doc[F("palettes")] = serialized((const __FlashStringHelper*)JSON_palette_names);
-      }
+      strip.unlockRender();
+      doc[F("effects")]  = serialized((const __FlashStringHelper*)JSON_mode_names);
+      doc[F("palettes")] = serialized((const __FlashStringHelper*)JSON_palette_names);
   }
 
   DEBUG_PRINT("JSON buffer size: ");
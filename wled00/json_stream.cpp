@@ -0,0 +1,88 @@
+#include "wled.h"
+#include "json_stream.h"
+
+/*
+ * Streaming JSON serializer
+ * Writes state and info JSON directly to a Print (web response, WebSocket buffer, Serial) instead of building
+ * them in the shared JSON document first, so serving them does not take the JSON buffer lock.
+ * The members are written by the same code as serializeState() / serializeInfo() (json.cpp).
+ * Usermods and the statistics in info are only available as JsonObject, those parts go through a small
+ * temporary document.
+ */
+
+//counts the output, passes it on to out if set
+class JsonCountPrint : public Print {
+  public:
+    JsonCountPrint(Print* out = nullptr) : _out(out) {}
+    size_t count = 0;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+      if (_out) len = _out->write(buf, len);
+      count += len;
+      return len;
+    }
+  private:
+    Print* _out;
+};
+
+//writes into a fixed buffer, remembers if the output did not fit
+class JsonBufferPrint : public Print {
+  public:
+    JsonBufferPrint(uint8_t* buf, size_t len) : _buf(buf), _len(len) {}
+    size_t pos = 0;
+    bool overflow = false;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+      if (pos + len > _len) { overflow = true; len = _len - pos; }
+      memcpy(_buf + pos, buf, len);
+      pos += len;
+      return len;
+    }
+  private:
+    uint8_t* _buf;
+    size_t _len;
+};
+
+//writes state (JSON_STREAM_STATE), info (JSON_STREAM_INFO) or {"state":{..},"info":{..}} (JSON_STREAM_STATE_INFO) to out
+//with JSON_STREAM_NO_STATS, info is written without the statistics objects
+//error is reported in the state instead of errorFlag, so the same output can be measured first (caller clears errorFlag)
+//returns the number of bytes written, 0 if the segments could not be locked
+size_t streamJson(Print& out, byte what, byte error)
+{
+  if (!strip.lockRender(1000)) return 0; //segments must not change meanwhile
+  bool stats = !(what & JSON_STREAM_NO_STATS);
+  JsonCountPrint counter(&out);
+  JsonStreamWriter w(counter);
+  w.beginObject();
+  switch (what & ~JSON_STREAM_NO_STATS) {
+    case JSON_STREAM_STATE:
+      streamState(w, error); break;
+    case JSON_STREAM_INFO:
+      streamInfo(w, stats); break;
+    default:
+      w.beginObject("state");
+      streamState(w, error);
+      w.endObject();
+      w.beginObject("info");
+      streamInfo(w, stats);
+      w.endObject();
+  }
+  w.endObject();
+  strip.unlockRender();
+  return counter.count;
+}
+
+size_t measureStreamJson(byte what, byte error)
+{
+  JsonCountPrint counter;
+  return streamJson(counter, what, error);
+}
+
+//writes into buf, returns the number of bytes written (at most len)
+//0 if the output did not fit, e.g. because a value grew since it was measured
+size_t streamJson(uint8_t* buf, size_t len, byte what, byte error)
+{
+  JsonBufferPrint out(buf, len);
+  if (!streamJson(out, what, error) || out.overflow) return 0;
+  return out.pos;
+}
@@ -0,0 +1,132 @@
+#ifndef WLED_JSON_STREAM_H
+#define WLED_JSON_STREAM_H
+
+/*
+ * JSON writers for the state and info serializers in json.cpp (writeState(), writeInfo())
+ * JsonObjectWriter fills a JsonObject (serializeState(), presets), JsonStreamWriter prints the same
+ * members directly to a Print (streamJson() in json_stream.cpp), so serving them does not take the JSON buffer.
+ * Both have the same interface, members are added to the object or array opened last.
+ */
+
+#define JSON_STREAM_DOC_SIZE 1024 //initial size of temporary documents, doubled until the content fits
+#define JSON_STREAM_DOC_MAX  8192
+#define JSON_WRITER_DEPTH       4 //nested objects and arrays of JsonObjectWriter
+
+typedef void (*json_object_fn)(JsonObject);
+
+class JsonObjectWriter {
+  public:
+    JsonObjectWriter(JsonObject root) { _stack[0] = root; }
+
+    void beginObject() { _stack[_depth +1] = _stack[_depth].createNestedObject(); _depth++; } //array element
+    void endObject()   { _depth--; }
+    void endArray()    { _depth--; }
+    template <typename K> void beginObject(K k) { _stack[_depth +1] = _stack[_depth].createNestedObject(k); _depth++; }
+    template <typename K> void beginArray(K k)  { _stack[_depth +1] = _stack[_depth].createNestedArray(k); _depth++; }
+
+    template <typename K, typename T> void add(K k, T v) { _stack[_depth][k] = v; }
+    template <typename T> void push(T v) { _stack[_depth].add(v); }
+    template <typename K> void addRaw(K k, char* json) { _stack[_depth][k] = serialized(json); } //copied
+
+    template <typename K> void addObject(K k, json_object_fn fn) { fn(_stack[_depth].createNestedObject(k)); }
+    void merge(json_object_fn fn) { fn(_stack[_depth].as<JsonObject>()); }
+
+  private:
+    JsonVariant _stack[JSON_WRITER_DEPTH];
+    uint8_t _depth = 0;
+};
+
+class JsonStreamWriter {
+  public:
+    JsonStreamWriter(Print& out) : _out(out) {}
+
+    void beginObject() { separator(); _out.write('{'); _first = true; }
+    void endObject()   { _out.write('}'); _first = false; }
+    void beginArray()  { separator(); _out.write('['); _first = true; }
+    void endArray()    { _out.write(']'); _first = false; }
+    template <typename K> void beginObject(K k) { key(k); _out.write('{'); _first = true; }
+    template <typename K> void beginArray(K k)  { key(k); _out.write('['); _first = true; }
+
+    //object member, keys are not escaped
+    template <typename K, typename T> void add(K k, T v) { key(k); value(v); }
+    //array element
+    template <typename T> void push(T v) { separator(); value(v); }
+    //member that is already JSON
+    template <typename K> void addRaw(K k, char* json) { key(k); _out.print(json); }
+
+    //member with the content fn adds to a JsonObject
+    template <typename K> void addObject(K k, json_object_fn fn) { key(k); fromObject(fn, false); }
+    //adds all members fn adds to a JsonObject to the current object (usermods)
+    void merge(json_object_fn fn) { fromObject(fn, true); }
+
+  private:
+    Print& _out;
+    bool _first = true;
+
+    void separator() {
+      if (!_first) _out.write(',');
+      _first = false;
+    }
+
+    template <typename K> void key(K k) {
+      separator();
+      _out.write('"');
+      _out.print(k);
+      _out.write('"');
+      _out.write(':');
+    }
+
+    void value(bool v)                       { _out.print(v ? F("true") : F("false")); }
+    void value(const char* s)                { string(s, false); }
+    void value(char* s)                      { string(s, false); }
+    void value(const __FlashStringHelper* s) { string((const char*)s, true); }
+    void value(const String& s)              { string(s.c_str(), false); }
+    template <typename T> void value(T v)    { _out.print(v); }
+
+    void string(const char* s, bool progmem) {
+      _out.write('"');
+      while (s) {
+        char c = progmem ? pgm_read_byte(s++) : *s++;
+        if (!c) break;
+        if (c == '"' || c == '\\') {
+          _out.write('\\');
+          _out.write(c);
+        } else if ((uint8_t)c < 0x20) {
+          char esc[7];
+          sprintf_P(esc, PSTR("\\u%04x"), c);
+          _out.print(esc);
+        } else {
+          _out.write(c);
+        }
+      }
+      _out.write('"');
+    }
+
+    //runs fn on a temporary document large enough for its content
+    void fromObject(json_object_fn fn, bool mergeMembers) {
+      for (size_t size = JSON_STREAM_DOC_SIZE; ; size *= 2) {
+        DynamicJsonDocument d(size);
+        JsonObject o = d.to<JsonObject>();
+        fn(o);
+        if (d.overflowed() && size < JSON_STREAM_DOC_MAX) continue;
+        if (!mergeMembers) {
+          if (o.isNull()) _out.print(F("{}")); //out of memory
+          else serializeJson(o, _out);
+          return;
+        }
+        for (JsonPair kv : o) {
+          separator();
+          string(kv.key().c_str(), false);
+          _out.write(':');
+          serializeJson(kv.value(), _out);
+        }
+        return;
+      }
+    }
+};
+
+//json.cpp, members of the state and info objects (the caller opens and closes the object)
+void streamState(JsonStreamWriter& w, byte error);
+void streamInfo(JsonStreamWriter& w, bool stats = true);
+
+#endif
@@ -97,6 +97,7 @@ void applyFinalBri() {
 void stateUpdated(byte callMode) {
   //call for notifier -> 0: init 1: direct change 2: button 3: notification 4: nightlight 5: other (No notification)
   //                     6: fx changed 7: hue 8: preset cycle 9: blynk 10: alexa 11: ws send only 12: button preset
+  strip.lockRender(); //changes brightness and transitions of the strip
   setValuesFromFirstSelectedSeg();
 
   if (bri != briOld || stateChanged) {
@@ -137,6 +138,7 @@ void stateUpdated(byte callMode) {
     if (transitionDelayTemp == 0) {
       applyFinalBri();
       strip.trigger();
+      strip.unlockRender();
       return;
     }
 
@@ -152,6 +154,7 @@ void stateUpdated(byte callMode) {
     applyFinalBri();
     strip.trigger();
   }
+  strip.unlockRender();
 }
 
 
@@ -203,25 +206,31 @@ void handleTransitions()
     float tper = (millis() - transitionStartTime)/(float)transitionDelayTemp;
     if (tper >= 1.0)
     {
+      strip.lockRender();
       strip.setTransitionMode(false);
       transitionActive = false;
       tperLast = 0;
       applyFinalBri();
+      strip.unlockRender();
       return;
     }
     if (tper - tperLast < 0.004) return;
     tperLast = tper;
     briT    = briOld   +((bri    - briOld   )*tper);
     
+    strip.lockRender();
     applyBri();
+    strip.unlockRender();
   }
 }
 
 
 //legacy method, applies values from col, effectCurrent, ... to selected segments
 void colorUpdated(byte callMode){
+  strip.lockRender();
   applyValuesToSelectedSegs();
   stateUpdated(callMode);
+  strip.unlockRender();
 }
 
 
@@ -234,6 +243,9 @@ void handleNightlight()
   if (now - lastNlUpdate < 100) return; //allow only 10 NL updates per second
   lastNlUpdate = now;
 */
+  if (!nightlightActive && !nightlightActiveOld) return;
+  bool nlDone = false;
+  strip.lockRender(); //fades brightness and colors of the segments
   if (nightlightActive)
   {
     if (!nightlightActiveOld) //init
@@ -293,8 +305,7 @@ void handleNightlight()
       #ifndef WLED_DISABLE_BLYNK
       updateBlynk();
       #endif
-      if (macroNl > 0)
-        applyPreset(macroNl);
+      nlDone = true;
       nightlightActiveOld = false;
     }
   } else if (nightlightActiveOld) //early de-init
@@ -307,6 +318,8 @@ void handleNightlight()
     }
     nightlightActiveOld = false;
   }
+  strip.unlockRender();
+  if (nlDone && macroNl > 0) applyPreset(macroNl); //not under the render lock, the preset may be read from the file
 }
 
 //utility for FastLED to use our custom timer
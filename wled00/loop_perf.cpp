@@ -0,0 +1,102 @@
+#include "wled.h"
+
+/*
+ * Main loop instrumentation
+ * Time between two loopStage() calls is accounted to the stage passed to the second one.
+ * Each stage keeps min/max and a histogram of log2 sized buckets (see LOOP_PERF_BUCKETS) from which p99 is estimated.
+ * Served at /json/perf, reset via JSON API {"rstperf":true}
+ */
+
+typedef struct LoopStageStats { // 40 bytes
+  uint32_t min;
+  uint32_t max;
+  uint16_t hist[LOOP_PERF_BUCKETS];
+} loop_stage_stats;
+
+static loop_stage_stats loopStats[LOOP_STAGE_COUNT];
+static uint32_t loopStageCycles = 0;
+static uint32_t loopCount = 0;
+static uint32_t loopCountStart = 0;
+static uint32_t loopsPerSec = 0;
+
+static const char* const loopStageNames[LOOP_STAGE_COUNT] = {
+  "sys", "time", "ir", "conn", "serial", "notif", "trans", "dmx", "user", "um", "io",
+  "alexa", "hk", "ota", "nl", "hue", "blynk", "strip", "mqtt", "bus", "ws", "led"
+};
+
+void resetLoopPerf()
+{
+  for (uint8_t i = 0; i < LOOP_STAGE_COUNT; i++) {
+    loopStats[i].min = UINT32_MAX;
+    loopStats[i].max = 0;
+    memset(loopStats[i].hist, 0, sizeof(loopStats[i].hist));
+  }
+  loopStageCycles = ESP.getCycleCount();
+}
+
+//account the time since the previous call to the given stage
+void loopStage(uint8_t stage)
+{
+  uint32_t cycles = ESP.getCycleCount();
+  uint32_t us = (cycles - loopStageCycles) / ESP.getCpuFreqMHz();
+  loopStageCycles = cycles;
+  if (stage >= LOOP_STAGE_COUNT) return;
+
+  loop_stage_stats &s = loopStats[stage];
+  if (us < s.min) s.min = us;
+  if (us > s.max) s.max = us;
+  uint8_t b = us ? 32 - __builtin_clz(us) : 0;
+  if (b >= LOOP_PERF_BUCKETS) b = LOOP_PERF_BUCKETS -1;
+  if (s.hist[b] == UINT16_MAX) { //halve all buckets to keep the distribution instead of saturating
+    for (uint8_t i = 0; i < LOOP_PERF_BUCKETS; i++) s.hist[i] >>= 1;
+  }
+  s.hist[b]++;
+}
+
+//call once per loop, also updates the loops per second counter
+void loopStart()
+{
+  loopStage(LOOP_STAGE_SYS);
+  loopCount++;
+  uint32_t elapsed = millis() - loopCountStart;
+  if (elapsed >= 1000) {
+    loopsPerSec = (loopCount * 1000) / elapsed;
+    loopCount = 0;
+    loopCountStart = millis();
+  }
+}
+
+uint32_t getLoopsPerSec()
+{
+  return loopsPerSec;
+}
+
+//upper bound (in us) of the bucket containing the 99th percentile
+static uint32_t getLoopStageP99(const loop_stage_stats &s, uint32_t count)
+{
+  uint32_t target = count - count / 100;
+  uint32_t sum = 0;
+  for (uint8_t b = 0; b < LOOP_PERF_BUCKETS; b++) {
+    sum += s.hist[b];
+    if (sum >= target) return (b < LOOP_PERF_BUCKETS -1) ? (1UL << b) -1 : s.max;
+  }
+  return s.max;
+}
+
+void serializeLoopPerf(JsonObject root)
+{
+  root[F("lps")] = loopsPerSec;
+  JsonObject stages = root.createNestedObject(F("loop"));
+  for (uint8_t i = 0; i < LOOP_STAGE_COUNT; i++) {
+    const loop_stage_stats &s = loopStats[i];
+    uint32_t count = 0;
+    for (uint8_t b = 0; b < LOOP_PERF_BUCKETS; b++) count += s.hist[b];
+    if (!count) continue; //stage not compiled in or not reached
+    JsonObject st = stages.createNestedObject(loopStageNames[i]);
+    st[F("min")] = s.min;
+    st[F("max")] = s.max;
+    st[F("p99")] = getLoopStageP99(s, count);
+    JsonArray hist = st.createNestedArray("hist");
+    for (uint8_t b = 0; b < LOOP_PERF_BUCKETS; b++) hist.add(s.hist[b]);
+  }
+}
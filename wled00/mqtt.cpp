@@ -94,7 +94,10 @@ void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties
       #ifdef WLED_USE_DYNAMIC_JSON
       DynamicJsonDocument doc(JSON_BUFFER_SIZE);
       #else
-      if (!requestJSONBufferLock(15)) return;
+      if (!requestJSONBufferLock(15)) {
+        delete[] payloadStr;
+        return;
+      }
       #endif
       deserializeJson(doc, payloadStr);
       deserializeState(doc.as<JsonObject>());
@@ -106,7 +109,9 @@ void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties
     }
   } else if (strlen(topic) != 0) {
     // non standard topic, check with usermods
+    strip.lockRender(); //called from the async MQTT client, usermods may change segments
     usermods.onMqttMessage(topic, payloadStr);
+    strip.unlockRender();
   } else {
     // topmost topic (just wled/MAC)
     parseMQTTBriPayload(payloadStr);
@@ -53,6 +53,23 @@ void unloadPlaylist() {
 }
 
 
+//repeat < 0: infinite and shuffled
+static int16_t startPlaylist(int rep, byte endPreset, bool shuffle, byte presetId) {
+  if (rep < 0) { //support negative values as infinite + shuffle
+    rep = 0; shuffle = true;
+  }
+
+  playlistRepeat = rep;
+  if (playlistRepeat > 0) playlistRepeat++; //add one extra repetition immediately since it will be deducted on first start
+  playlistEndPreset = endPreset;
+  if (shuffle) playlistOptions += PL_OPTION_SHUFFLE;
+
+  currentPlaylist = presetId;
+  DEBUG_PRINTLN(F("Playlist loaded."));
+  return currentPlaylist;
+}
+
+
 int16_t loadPlaylist(JsonObject playlistObj, byte presetId) {
   unloadPlaylist();
   
@@ -99,21 +116,27 @@ int16_t loadPlaylist(JsonObject playlistObj, byte presetId) {
   }
   for (int i = it; i < playlistLen; i++) playlistEntries[i].tr = playlistEntries[it -1].tr;
 
-  int rep = playlistObj[F("repeat")];
-  bool shuffle = false;
-  if (rep < 0) { //support negative values as infinite + shuffle
-    rep = 0; shuffle = true;
-  }
+  return startPlaylist(playlistObj[F("repeat")], playlistObj["end"] | 0, playlistObj["r"], presetId);
+}
 
-  playlistRepeat = rep;
-  if (playlistRepeat > 0) playlistRepeat++; //add one extra repetition immediately since it will be deducted on first start
-  playlistEndPreset = playlistObj["end"] | 0;
-  shuffle = shuffle || playlistObj["r"];
-  if (shuffle) playlistOptions += PL_OPTION_SHUFFLE;
 
-  currentPlaylist = presetId;
-  DEBUG_PRINTLN(F("Playlist loaded."));
-  return currentPlaylist;
+//playlist with one duration and transition per entry (binary state snapshots)
+int16_t loadPlaylist(const byte* presets, const uint16_t* durations, const uint16_t* transitions, byte len, int rep, byte endPreset, bool shuffle, byte presetId) {
+  unloadPlaylist();
+
+  playlistLen = len;
+  if (playlistLen == 0) return -1;
+  if (playlistLen > 100) playlistLen = 100;
+
+  playlistEntries = new PlaylistEntry[playlistLen];
+  if (playlistEntries == nullptr) return -1;
+
+  for (byte i = 0; i < playlistLen; i++) {
+    playlistEntries[i].preset = presets[i];
+    playlistEntries[i].dur = durations[i];
+    playlistEntries[i].tr = transitions[i];
+  }
+  return startPlaylist(rep, endPreset, shuffle, presetId);
 }
 
 
@@ -0,0 +1,164 @@
+#include "wled.h"
+
+/*
+ * Preset cache
+ * Keeps recently applied presets in RAM (PSRAM if available), so playlists, buttons and timers
+ * that recall the same presets again do not read and parse presets.json each time.
+ * Presets are stored as binary state snapshots (see snapshot.cpp) that are applied without a JSON document,
+ * or as MessagePack if they are not representable as a snapshot.
+ * Bounded by presetCacheSize bytes, the least recently used presets are dropped first.
+ * Only accessed while holding the JSON buffer lock. Invalidation may happen from any context,
+ * so it only marks presets and they are dropped on the next access.
+ */
+
+#define PRESET_CACHE_ENTRIES 16
+
+#define PC_MSGPACK  0
+#define PC_SNAPSHOT 1
+
+typedef struct PresetCacheEntry {
+  uint8_t* data;
+  uint16_t size;
+  uint8_t  id;      //0: unused
+  uint8_t  format;  //PC_*
+  uint32_t lastUse;
+} preset_cache_entry;
+
+static preset_cache_entry pcEntries[PRESET_CACHE_ENTRIES];
+static uint32_t pcBytes = 0;
+static uint32_t pcUseCount = 0;
+static uint32_t pcHits = 0, pcMisses = 0;
+static uint32_t pcStale[8] = {0};          //bit per preset id to drop
+static volatile bool pcStaleAll = false;
+
+static void freeCacheEntry(preset_cache_entry &e)
+{
+  free(e.data);
+  pcBytes -= e.size;
+  e.data = nullptr;
+  e.size = 0;
+  e.id = 0;
+}
+
+//drop invalidated presets, and all of them if the cache was disabled
+static void cleanPresetCache()
+{
+  bool all = pcStaleAll || !presetCacheSize;
+  pcStaleAll = false;
+  for (uint8_t i = 0; i < PRESET_CACHE_ENTRIES; i++) {
+    preset_cache_entry &e = pcEntries[i];
+    if (!e.id) continue;
+    if (all || (pcStale[e.id >> 5] & (1UL << (e.id & 31)))) freeCacheEntry(e);
+  }
+  memset(pcStale, 0, sizeof(pcStale));
+}
+
+//marks a preset as changed, id 0 drops all
+void invalidatePresetCache(uint8_t id)
+{
+  if (!id) pcStaleAll = true;
+  else pcStale[id >> 5] |= 1UL << (id & 31);
+}
+
+static preset_cache_entry* findCacheEntry(uint8_t id)
+{
+  cleanPresetCache();
+  if (!presetCacheSize || !id) return nullptr;
+  for (uint8_t i = 0; i < PRESET_CACHE_ENTRIES; i++) {
+    if (pcEntries[i].id == id) return &pcEntries[i];
+  }
+  return nullptr;
+}
+
+//applies the cached preset if it is stored as snapshot, false otherwise (use getCachedPreset() then)
+bool applyCachedPreset(uint8_t id, byte callMode)
+{
+  preset_cache_entry* e = findCacheEntry(id);
+  if (!e || e->format != PC_SNAPSHOT) return false;
+  if (!applyStateSnapshot(e->data, e->size, callMode, id)) return false;
+  e->lastUse = ++pcUseCount;
+  pcHits++;
+  return true;
+}
+
+//fills dest with the cached preset, false if it is not cached
+bool getCachedPreset(uint8_t id, JsonDocument* dest)
+{
+  preset_cache_entry* e = findCacheEntry(id);
+  if (e) {
+    dest->clear();
+    bool ok = e->format == PC_SNAPSHOT ? snapshotToJson(e->data, e->size, dest->to<JsonObject>())
+                                       : !deserializeMsgPack(*dest, (const uint8_t*)e->data, e->size);
+    if (!ok) { //should not happen, read from file instead
+      pcMisses++;
+      return false;
+    }
+    e->lastUse = ++pcUseCount;
+    pcHits++;
+    return true;
+  }
+  pcMisses++;
+  return false;
+}
+
+//stores a preset just read from the file, must be called before it is modified by deserializeState()
+void cachePreset(uint8_t id, JsonDocument* src)
+{
+  cleanPresetCache();
+  if (!id || !presetCacheSize || src->isNull()) return;
+  uint8_t format = PC_SNAPSHOT;
+  size_t size = src->is<JsonObject>() ? jsonToSnapshot(src->as<JsonObject>(), nullptr, 0) : 0;
+  if (!size) {
+    format = PC_MSGPACK;
+    size = measureMsgPack(*src);
+  }
+  if (size > UINT16_MAX || size > presetCacheSize) return;
+
+  //drop the least recently used presets until there is room
+  preset_cache_entry* slot = nullptr;
+  for (;;) {
+    preset_cache_entry* lru = nullptr;
+    slot = nullptr;
+    for (uint8_t i = 0; i < PRESET_CACHE_ENTRIES; i++) {
+      preset_cache_entry &e = pcEntries[i];
+      if (e.id == id) freeCacheEntry(e); //replaced
+      if (!e.id) { if (!slot) slot = &e; continue; }
+      if (!lru || (int32_t)(e.lastUse - lru->lastUse) < 0) lru = &e;
+    }
+    if (slot && pcBytes + size <= presetCacheSize) break;
+    if (!lru) return;
+    freeCacheEntry(*lru);
+  }
+
+  #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_USE_PSRAM)
+  if (psramFound())
+    slot->data = (uint8_t*) ps_malloc(size);
+  else
+  #endif
+    slot->data = (uint8_t*) malloc(size);
+  if (!slot->data) return;
+  if (format == PC_SNAPSHOT) jsonToSnapshot(src->as<JsonObject>(), slot->data, size);
+  else serializeMsgPack(*src, slot->data, size);
+  slot->size = size;
+  slot->id = id;
+  slot->format = format;
+  slot->lastUse = ++pcUseCount;
+  pcBytes += size;
+}
+
+void resetPresetCacheStats()
+{
+  pcHits = pcMisses = 0;
+}
+
+//{"n":cached presets, "bytes":used, "size":budget, "hit":hits, "miss":misses}, only reads and may be called without the lock
+void serializePresetCache(JsonObject root)
+{
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < PRESET_CACHE_ENTRIES; i++) if (pcEntries[i].id) n++;
+  root["n"] = n;
+  root[F("bytes")] = pcBytes;
+  root[F("size")] = presetCacheSize;
+  root[F("hit")] = pcHits;
+  root[F("miss")] = pcMisses;
+}
@@ -8,6 +8,12 @@ bool applyPreset(byte index, byte callMode)
 {
   if (index == 0) return false;
 
+  //quick save, binary snapshot (/tmp.json is still read if it does not exist)
+  if (index == 255 && applyStateSnapshotFile("/tmp.snap", callMode, index)) {
+    errorFlag = ERR_NONE;
+    return true;
+  }
+
   const char *filename = index < 255 ? "/presets.json" : "/tmp.json";
 
 	uint8_t core = 1;
@@ -19,13 +25,20 @@ bool applyPreset(byte index, byte callMode)
 	//only allow use of fileDoc from the core responsible for network requests
 	//do not use active network request doc from preset called by main loop (playlist, schedule, ...)
   if (fileDoc && core) {
-    errorFlag = readObjectFromFileUsingId(filename, index, fileDoc) ? ERR_NONE : ERR_FS_PLOAD;
-    JsonObject fdo = fileDoc->as<JsonObject>();
-    if (fdo["ps"] == index) fdo.remove("ps"); //remove load request for same presets to prevent recursive crash
-    #ifdef WLED_DEBUG_FS
-      serializeJson(*fileDoc, Serial);
-    #endif
-    deserializeState(fdo, callMode, index);
+    if (index < 255 && applyCachedPreset(index, callMode)) errorFlag = ERR_NONE; //binary snapshot, no JSON needed
+    else {
+      if (index < 255 && getCachedPreset(index, fileDoc)) errorFlag = ERR_NONE;
+      else {
+        errorFlag = readObjectFromFileUsingId(filename, index, fileDoc) ? ERR_NONE : ERR_FS_PLOAD;
+        if (!errorFlag && index < 255) cachePreset(index, fileDoc);
+      }
+      JsonObject fdo = fileDoc->as<JsonObject>();
+      if (fdo["ps"] == index) fdo.remove("ps"); //remove load request for same presets to prevent recursive crash
+      #ifdef WLED_DEBUG_FS
+        serializeJson(*fileDoc, Serial);
+      #endif
+      deserializeState(fdo, callMode, index);
+    }
   } else {
     DEBUGFS_PRINTLN(F("Make read buf"));
     #ifdef WLED_USE_DYNAMIC_JSON
@@ -33,13 +46,20 @@ bool applyPreset(byte index, byte callMode)
     #else
     if (!requestJSONBufferLock(9)) return false;
     #endif
-    errorFlag = readObjectFromFileUsingId(filename, index, &doc) ? ERR_NONE : ERR_FS_PLOAD;
-    JsonObject fdo = doc.as<JsonObject>();
-    if (fdo["ps"] == index) fdo.remove("ps");
-    #ifdef WLED_DEBUG_FS
-      serializeJson(doc, Serial);
-    #endif
-    deserializeState(fdo, callMode, index);
+    if (index < 255 && applyCachedPreset(index, callMode)) errorFlag = ERR_NONE;
+    else {
+      if (index < 255 && getCachedPreset(index, &doc)) errorFlag = ERR_NONE;
+      else {
+        errorFlag = readObjectFromFileUsingId(filename, index, &doc) ? ERR_NONE : ERR_FS_PLOAD;
+        if (!errorFlag && index < 255) cachePreset(index, &doc);
+      }
+      JsonObject fdo = doc.as<JsonObject>();
+      if (fdo["ps"] == index) fdo.remove("ps");
+      #ifdef WLED_DEBUG_FS
+        serializeJson(doc, Serial);
+      #endif
+      deserializeState(fdo, callMode, index);
+    }
     releaseJSONBufferLock();
   }
 
@@ -53,11 +73,13 @@ bool applyPreset(byte index, byte callMode)
 void savePreset(byte index, bool persist, const char* pname, JsonObject saveobj)
 {
   if (index == 0 || (index > 250 && persist) || (index<255 && !persist)) return;
+  if (!persist) { //quick save, written without the JSON buffer (see snapshot.cpp)
+    saveStateSnapshotFile("/tmp.snap");
+    return;
+  }
   char tmp[12];
   JsonObject sObj = saveobj;
 
-  const char *filename = persist ? "/presets.json" : "/tmp.json";
-
   if (!fileDoc) {
     DEBUGFS_PRINTLN(F("Allocating saving buffer"));
     #ifdef WLED_USE_DYNAMIC_JSON
@@ -73,10 +95,13 @@ void savePreset(byte index, bool persist, const char* pname, JsonObject saveobj)
     } else if (pname) sObj["n"] = pname;
 
     DEBUGFS_PRINTLN(F("Save current state"));
+    strip.lockRender();
     serializeState(sObj, true);
-    if (persist) currentPreset = index;
+    strip.unlockRender();
+    currentPreset = index;
 
-    writeObjectToFileUsingId(filename, index, &doc);
+    writeObjectToFileUsingId("/presets.json", index, &doc);
+    invalidatePresetCache(index);
 
     releaseJSONBufferLock();
   } else { //from JSON API (fileDoc != nullptr)
@@ -86,8 +111,10 @@ void savePreset(byte index, bool persist, const char* pname, JsonObject saveobj)
 
     if (!sObj["o"]) {
       DEBUGFS_PRINTLN(F("Save current state"));
+      strip.lockRender();
       serializeState(sObj, true, sObj["ib"], sObj["sb"]);
-      if (persist) currentPreset = index;
+      strip.unlockRender();
+      currentPreset = index;
     }
     sObj.remove("o");
     sObj.remove("ib");
@@ -95,15 +122,15 @@ void savePreset(byte index, bool persist, const char* pname, JsonObject saveobj)
     sObj.remove(F("error"));
     sObj.remove(F("time"));
 
-    writeObjectToFileUsingId(filename, index, fileDoc);
+    writeObjectToFileUsingId("/presets.json", index, fileDoc);
+    invalidatePresetCache(index);
   }
-  if (persist) presetsModifiedTime = toki.second(); //unix time
-  updateFSInfo();
+  updateFSInfo(); //presetsModifiedTime is updated by writeObjectToFile()
 }
 
 void deletePreset(byte index) {
   StaticJsonDocument<24> empty;
   writeObjectToFileUsingId("/presets.json", index, &empty);
-  presetsModifiedTime = toki.second(); //unix time
+  invalidatePresetCache(index);
   updateFSInfo();
 }
\ No newline at end of file
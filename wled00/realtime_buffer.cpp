@@ -0,0 +1,193 @@
+#include "wled.h"
+
+/*
+ * Realtime jitter buffer
+ * With realtimeBufferFrames > 0, network realtime data (E1.31, Art-Net, DDP, UDP, TPM2.NET, Hyperion)
+ * is not shown as soon as a frame is complete. Frames are queued in a small ring
+ * and shown from the main loop at the rate they are received, evening out Wi-Fi delivery jitter.
+ * Playback starts once realtimeBufferFrames frames are queued and starts over after an underrun.
+ * Adds realtimeBufferFrames frames of latency.
+ * DDP frames with a timecode also use the ring (even with realtimeBufferFrames 0), each slot keeps its
+ * show time, so a frame is held until it is due without the next frame overwriting it.
+ * So do frames assembled from several packets (multi-universe E1.31/Art-Net), the receivers write the next
+ * frame into its own slot while the completed one waits for the main loop.
+ * On ESP32 the receivers run in the AsyncUDP task, they hold the ring lock while writing into the ring,
+ * so the main loop never frees or replaces it under them.
+ */
+
+#define RT_BUFFER_SLOTS (RT_BUFFER_MAX_FRAMES +1) //one more slot for the frame being received
+
+static uint32_t* rtFrames = nullptr;     //RT_BUFFER_SLOTS frames of rtFrameLen pixels
+static uint16_t  rtFrameLen = 0;
+static uint8_t   rtDepth = 0;           //frames to queue before playback, realtimeBufferFrames at allocation
+static volatile uint8_t rtWriteSlot = 0; //slot the receivers write into, advanced by queueRealtimeFrame()
+static volatile uint8_t rtReadSlot = 0;  //next slot to show
+static bool      rtPrefill = true;      //waiting for rtDepth frames before playback
+static uint32_t  rtInterval = 0;        //average time between received frames in us
+static uint32_t  rtLastInput = 0;       //micros() of the last received frame
+static uint32_t  rtNextOutput = 0;      //micros() the next frame is due
+static unsigned long rtShowTime[RT_BUFFER_SLOTS]; //millis() a timecoded frame is due, 0 = paced or right away
+static bool      rtTimed = false;       //timecoded frames received, keep the ring until realtime ends
+static bool      rtMultiPacket = false; //frames assembled from several packets received, same
+
+static uint16_t  rtInCount = 0, rtOutCount = 0;
+static uint16_t  rtInFps = 0, rtOutFps = 0;
+static uint32_t  rtUnderruns = 0;
+static uint32_t  rtOverruns = 0;
+static unsigned long rtFpsStart = 0;
+
+#ifdef ARDUINO_ARCH_ESP32
+static SemaphoreHandle_t rtMutex = nullptr; //created by the main loop before the ring is allocated
+static inline bool lockRealtimeRing()   { return rtMutex && xSemaphoreTake(rtMutex, portMAX_DELAY) == pdTRUE; }
+static inline void unlockRealtimeRing() { xSemaphoreGive(rtMutex); }
+#else
+static inline bool lockRealtimeRing()   { return true; } //receivers run in the main loop context
+static inline void unlockRealtimeRing() {}
+#endif
+
+static inline uint8_t rtQueued()
+{
+  return (rtWriteSlot + RT_BUFFER_SLOTS - rtReadSlot) % RT_BUFFER_SLOTS;
+}
+
+//frame the receivers write into, nullptr if they should write to the strip directly
+//a frame is returned with the ring locked, call releaseRealtimeFrame() once done writing
+uint32_t* getRealtimeFrame(uint16_t &len)
+{
+  if (realtimeMode == REALTIME_MODE_GENERIC || realtimeMode == REALTIME_MODE_ADALIGHT) return nullptr;
+  if (rtFrames == nullptr) return nullptr; //no ring, do not lock for nothing (checked again under the lock)
+  if (!lockRealtimeRing()) return nullptr;
+  if (rtFrames == nullptr) {
+    unlockRealtimeRing();
+    return nullptr;
+  }
+  len = rtFrameLen;
+  return rtFrames + rtWriteSlot * rtFrameLen;
+}
+
+void releaseRealtimeFrame()
+{
+  unlockRealtimeRing();
+}
+
+//called by the receivers once a frame is complete, returns false if it should be shown right away
+//showTime is the millis() the frame is due at (DDP timecode), 0 if it has none
+//multiPacket is set if the frame was written by several packets, the ring is then used without realtimeBufferFrames
+bool queueRealtimeFrame(unsigned long showTime, bool multiPacket)
+{
+  if (showTime) rtTimed = true; //the first such frames are shown right away until the ring is allocated
+  if (multiPacket) rtMultiPacket = true;
+  uint16_t len;
+  uint32_t* frame = getRealtimeFrame(len);
+  if (frame == nullptr) return false;
+
+  uint32_t now = micros();
+  if (rtLastInput) {
+    uint32_t dt = now - rtLastInput;
+    rtInterval = rtInterval ? rtInterval - (rtInterval >> 3) + (dt >> 3) : dt;
+  }
+  rtLastInput = now;
+  rtInCount++;
+
+  uint8_t next = (rtWriteSlot +1) % RT_BUFFER_SLOTS;
+  if (next == rtReadSlot) { //ring full, the next frame overwrites this one
+    rtOverruns++;
+  } else {
+    memcpy(rtFrames + next * rtFrameLen, frame, len * sizeof(uint32_t)); //next frame starts from this one (partial updates)
+    rtShowTime[rtWriteSlot] = showTime;
+    rtWriteSlot = next;
+  }
+  releaseRealtimeFrame();
+  return true;
+}
+
+//the ring must be locked
+static void freeRealtimeBuffer()
+{
+  uint32_t* frames = rtFrames;
+  rtFrames = nullptr;
+  free(frames);
+  rtFrameLen = 0;
+}
+
+//called from the main loop, allocates the ring while realtime is active and shows the queued frames
+void handleRealtimeBuffer()
+{
+  if (millis() - rtFpsStart >= 1000) {
+    rtInFps = rtInCount; rtOutFps = rtOutCount;
+    rtInCount = rtOutCount = 0;
+    rtFpsStart = millis();
+  }
+
+  uint8_t depth = (realtimeBufferFrames > RT_BUFFER_MAX_FRAMES) ? RT_BUFFER_MAX_FRAMES : realtimeBufferFrames;
+  if (!realtimeMode) rtTimed = rtMultiPacket = false;
+  bool active = (depth || rtTimed || rtMultiPacket) && realtimeMode && realtimeMode != REALTIME_MODE_GENERIC && realtimeMode != REALTIME_MODE_ADALIGHT;
+  if (rtFrames != nullptr && (!active || depth != rtDepth || strip.getLengthTotal() != rtFrameLen)) {
+    if (!lockRealtimeRing()) return;
+    freeRealtimeBuffer();
+    unlockRealtimeRing();
+  }
+  if (!active) return;
+
+  if (rtFrames == nullptr) {
+    #ifdef ARDUINO_ARCH_ESP32
+    if (rtMutex == nullptr) rtMutex = xSemaphoreCreateMutex();
+    #endif
+    uint16_t len = strip.getLengthTotal();
+    uint32_t* frames = (uint32_t*)malloc(RT_BUFFER_SLOTS * len * sizeof(uint32_t));
+    if (frames == nullptr) return; //not enough RAM, frames are shown as they come in
+    memset(frames, 0, RT_BUFFER_SLOTS * len * sizeof(uint32_t));
+    if (!lockRealtimeRing()) { free(frames); return; }
+    rtDepth = depth;
+    rtFrameLen = len;
+    rtWriteSlot = rtReadSlot = 0;
+    rtPrefill = true;
+    rtInterval = rtLastInput = 0;
+    rtFrames = frames; //published last, receivers start writing into the ring from here on
+    unlockRealtimeRing();
+    return;
+  }
+
+  uint8_t queued = rtQueued();
+  uint32_t now = micros();
+  unsigned long showTime = queued ? rtShowTime[rtReadSlot] : 0;
+  if (showTime) {
+    //timecoded frame, shown at its time instead of the input rate, or early if the ring is full
+    if ((long)(millis() - showTime) < 0 && queued < RT_BUFFER_MAX_FRAMES) return;
+  } else if (rtDepth) {
+    if (rtPrefill) {
+      if (queued < rtDepth) return;
+      rtPrefill = false;
+      rtNextOutput = now;
+    }
+    if ((int32_t)(now - rtNextOutput) < 0) return;
+
+    if (!queued) {
+      rtUnderruns++;
+      rtPrefill = true;
+      return;
+    }
+  } else if (!queued) return; //no jitter buffer, queued frames are shown as soon as the loop gets to them
+
+  //no lock needed, the receivers never write into the read slot and only this function frees the ring
+  strip.setPixelColors(0, rtFrameLen, rtFrames + rtReadSlot * rtFrameLen);
+  strip.show();
+  rtReadSlot = (rtReadSlot +1) % RT_BUFFER_SLOTS;
+  rtOutCount++;
+  if (showTime || !rtDepth) return;
+
+  //play at the input rate, slightly faster or slower to keep the buffer at its configured depth
+  int32_t interval = rtInterval - ((int32_t)rtInterval * (queued - rtDepth)) / 16;
+  rtNextOutput += interval;
+  if ((int32_t)(now - rtNextOutput) > interval) rtNextOutput = now; //fell behind, do not catch up in a burst
+}
+
+void serializeRealtimeBuffer(JsonObject root)
+{
+  root[F("depth")] = realtimeBufferFrames;
+  root[F("queued")] = rtFrames ? rtQueued() : 0;
+  root[F("in")] = rtInFps;
+  root[F("out")] = rtOutFps;
+  root[F("under")] = rtUnderruns;
+  root[F("over")] = rtOverruns;
+}
@@ -0,0 +1,154 @@
+#include "wled.h"
+
+/*
+ * Realtime input telemetry
+ * Counts packets, payload bytes, sequence gaps (lost packets), out-of-order packets and decode time
+ * per realtime protocol and, for E1.31 and Art-Net, per universe.
+ * Served in info JSON ("rtin") and as binary WebSocket message ({"rt":true}, see writeRealtimeStats()).
+ * Reset via JSON API {"rstperf":true}
+ */
+
+typedef struct RealtimeInStats { // 24 bytes
+  uint32_t packets;
+  uint32_t bytes;         //payload (LED data) bytes
+  uint32_t gaps;          //packets missing according to the sequence numbers
+  uint32_t outOfOrder;    //packets older than the previous one
+  uint16_t decodeTime;    //us per packet, running average
+  uint16_t decodeTimeMax;
+  uint16_t lastSeq;       //0: none received yet
+} realtime_in_stats;
+
+static realtime_in_stats rtInStats[RT_PROTO_COUNT];
+static realtime_in_stats rtUniStats[E131_MAX_UNIVERSE_COUNT];
+static uint16_t rtUniNumber[E131_MAX_UNIVERSE_COUNT]; //universe the stats belong to
+static uint8_t  rtUniProto[E131_MAX_UNIVERSE_COUNT];  //RT_PROTO_E131 or RT_PROTO_ARTNET
+
+static const char* const rtProtoNames[RT_PROTO_COUNT] = {"e131", "artnet", "ddp", "tpm2", "udp", "hyperion"};
+
+void resetRealtimeStats()
+{
+  memset(rtInStats, 0, sizeof(rtInStats));
+  memset(rtUniStats, 0, sizeof(rtUniStats));
+}
+
+//seq runs from 1 to seqMax and wraps around, 0 if the packet has no sequence number
+static void countSequence(realtime_in_stats &s, uint16_t seq, uint16_t seqMax)
+{
+  if (!seq || !seqMax) return;
+  if (s.lastSeq) {
+    uint16_t expected = s.lastSeq % seqMax +1;
+    uint16_t diff = (seq + seqMax - expected) % seqMax;
+    if (diff > seqMax / 2) { //older than the previous packet
+      s.outOfOrder++;
+      return;
+    }
+    s.gaps += diff;
+  }
+  s.lastSeq = seq;
+}
+
+static void countPacket(realtime_in_stats &s, uint16_t bytes, uint32_t us)
+{
+  if (us > UINT16_MAX) us = UINT16_MAX;
+  s.packets++;
+  s.bytes += bytes;
+  s.decodeTime = s.decodeTime ? s.decodeTime - (s.decodeTime >> 3) + (us >> 3) : us;
+  if (us > s.decodeTimeMax) s.decodeTimeMax = us;
+}
+
+//call once a packet has been decoded, startCycles is ESP.getCycleCount() from before decoding
+//universe is the index relative to e131Universe, -1 if the protocol has no universes (sequence is tracked per protocol)
+//seq runs from 1 to seqMax, 0 if the packet has none
+void countRealtimePacket(uint8_t proto, int16_t universe, uint16_t bytes, uint16_t seq, uint16_t seqMax, uint32_t startCycles)
+{
+  if (proto >= RT_PROTO_COUNT) return;
+  uint32_t us = (ESP.getCycleCount() - startCycles) / ESP.getCpuFreqMHz();
+  realtime_in_stats &s = rtInStats[proto];
+  countPacket(s, bytes, us);
+  if (universe < 0 || universe >= E131_MAX_UNIVERSE_COUNT) { //universes that are not handled are only counted
+    if (universe == -1) countSequence(s, seq, seqMax);
+    return;
+  }
+
+  realtime_in_stats &u = rtUniStats[universe];
+  uint16_t uni = e131Universe + universe;
+  if (rtUniNumber[universe] != uni || rtUniProto[universe] != proto) { //universe settings or protocol changed
+    memset(&u, 0, sizeof(u));
+    rtUniNumber[universe] = uni;
+    rtUniProto[universe] = proto;
+  }
+  countPacket(u, bytes, us);
+  uint32_t gaps = u.gaps, outOfOrder = u.outOfOrder;
+  countSequence(u, seq, seqMax);
+  s.gaps += u.gaps - gaps;
+  s.outOfOrder += u.outOfOrder - outOfOrder;
+}
+
+static void serializeStats(JsonArray a, const realtime_in_stats &s)
+{
+  a.add(s.packets);
+  a.add(s.bytes);
+  a.add(s.gaps);
+  a.add(s.outOfOrder);
+  a.add(s.decodeTime);
+  a.add(s.decodeTimeMax);
+}
+
+//{"e131":[packets, bytes, gaps, out-of-order, decode us avg, decode us max], ..., "uni":[[RT_PROTO_*, universe, packets, ...], ...]}
+void serializeRealtimeStats(JsonObject root)
+{
+  for (uint8_t i = 0; i < RT_PROTO_COUNT; i++) {
+    if (!rtInStats[i].packets) continue;
+    serializeStats(root.createNestedArray(rtProtoNames[i]), rtInStats[i]);
+  }
+  JsonArray unis = root.createNestedArray(F("uni"));
+  for (uint8_t i = 0; i < E131_MAX_UNIVERSE_COUNT; i++) {
+    if (!rtUniStats[i].packets) continue;
+    JsonArray u = unis.createNestedArray();
+    u.add(rtUniProto[i]);
+    u.add(rtUniNumber[i]);
+    serializeStats(u, rtUniStats[i]);
+  }
+}
+
+static uint8_t* writeStats(uint8_t* p, uint8_t id, uint16_t universe, const realtime_in_stats &s)
+{
+  *p++ = id;
+  memcpy(p, &universe, 2);        p += 2;
+  memcpy(p, &s.packets, 4);       p += 4;
+  memcpy(p, &s.bytes, 4);         p += 4;
+  memcpy(p, &s.gaps, 4);          p += 4;
+  memcpy(p, &s.outOfOrder, 4);    p += 4;
+  memcpy(p, &s.decodeTime, 2);    p += 2;
+  memcpy(p, &s.decodeTimeMax, 2); p += 2;
+  return p;
+}
+
+//binary message: 'R', version 1, entry count, then RT_STATS_WS_ENTRY bytes per entry (little endian):
+//id (protocol RT_PROTO_*, +0x80 for a universe of it), universe, packets, bytes, gaps, out-of-order, decode us avg, decode us max
+//call with buf == nullptr to get the length. Writes as many entries as fit into len (packets may add entries
+//between both calls), zero fills the rest. Returns the number of bytes written, 0 if len is below the header.
+size_t writeRealtimeStats(uint8_t* buf, size_t len)
+{
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < RT_PROTO_COUNT; i++) if (rtInStats[i].packets) n++;
+  for (uint8_t i = 0; i < E131_MAX_UNIVERSE_COUNT; i++) if (rtUniStats[i].packets) n++;
+  if (buf == nullptr) return 3 + n * RT_STATS_WS_ENTRY;
+  if (len < 3) return 0;
+  if (n > (len - 3) / RT_STATS_WS_ENTRY) n = (len - 3) / RT_STATS_WS_ENTRY;
+
+  uint8_t* p = buf;
+  *p++ = 'R';
+  *p++ = 1; //version
+  *p++ = n;
+  uint8_t written = 0;
+  for (uint8_t i = 0; i < RT_PROTO_COUNT && written < n; i++) {
+    if (rtInStats[i].packets) { p = writeStats(p, i, 0, rtInStats[i]); written++; }
+  }
+  for (uint8_t i = 0; i < E131_MAX_UNIVERSE_COUNT && written < n; i++) {
+    if (rtUniStats[i].packets) { p = writeStats(p, 0x80 | rtUniProto[i], rtUniNumber[i], rtUniStats[i]); written++; }
+  }
+  buf[2] = written; //fewer if the stats were reset meanwhile
+  memset(p, 0, len - (p - buf));
+  return p - buf;
+}
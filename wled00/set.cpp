@@ -21,6 +21,8 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
   //0: menu 1: wifi 2: leds 3: ui 4: sync 5: time 6: sec 7: DMX 8: usermods
   if (subPage <1 || subPage >8) return;
 
+  strip.lockRender(); //settings change segments and busses, released before the config is saved
+
   //WIFI SETTINGS
   if (subPage == 1)
   {
@@ -98,6 +100,7 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
       char cv[4] = "CV"; cv[2] = 48+s; cv[3] = 0; //strip reverse
       char sl[4] = "SL"; sl[2] = 48+s; sl[3] = 0; //skip 1st LED
       char rf[4] = "RF"; rf[2] = 48+s; rf[3] = 0; //refresh required
+      char lu[4] = "LU"; lu[2] = 48+s; lu[3] = 0; //first E1.31/ArtNet universe
       if (!request->hasArg(lp)) {
         DEBUG_PRINTLN(F("No data.")); break;
       }
@@ -120,6 +123,8 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
       // actual finalization is done in WLED::loop() (removing old busses and adding new)
       if (busConfigs[s] != nullptr) delete busConfigs[s];
       busConfigs[s] = new BusConfig(type, pins, start, length, colorOrder, request->hasArg(cv), skip);
+      int universe = request->arg(lu).toInt();
+      if (busConfigs[s] && universe > 0 && universe <= 63999) busConfigs[s]->universe = universe;
       doInitBusses = true;
     }
 
@@ -178,6 +183,11 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
     turnOnAtBoot = request->hasArg(F("BO"));
     t = request->arg(F("BP")).toInt();
     if (t <= 250) bootPreset = t;
+    t = request->arg(F("PC")).toInt();
+    if (t >= 0 && t <= 1048576 && (uint32_t)t != presetCacheSize) {
+      presetCacheSize = t;
+      invalidatePresetCache(0); //refilled within the new budget
+    }
     strip.gammaCorrectBri = request->hasArg(F("GB"));
     strip.gammaCorrectCol = request->hasArg(F("GC"));
 
@@ -216,6 +226,7 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
 
     syncGroups = request->arg(F("GS")).toInt();
     receiveGroups = request->arg(F("GR")).toInt();
+    syncMulticast = request->hasArg(F("UM"));
 
     receiveNotificationBrightness = request->hasArg(F("RB"));
     receiveNotificationColor = request->hasArg(F("RC"));
@@ -230,10 +241,12 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
     notifyHue = request->hasArg(F("SH"));
     notifyMacro = request->hasArg(F("SM"));
     notifyTwice = request->hasArg(F("S2"));
+    syncDelta = request->hasArg(F("DL"));
 
     nodeListEnabled = request->hasArg(F("NL"));
     if (!nodeListEnabled) Nodes.clear();
     nodeBroadcastEnabled = request->hasArg(F("NB"));
+    nodeTimeSync = request->hasArg(F("TS"));
 
     receiveDirect = request->hasArg(F("RD"));
     e131SkipOutOfSequence = request->hasArg(F("ES"));
@@ -252,6 +265,8 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
     arlsDisableGammaCorrection = request->hasArg(F("RG"));
     t = request->arg(F("WO")).toInt();
     if (t >= -255  && t <= 255) arlsOffset = t;
+    t = request->arg(F("JB")).toInt();
+    if (t >= 0 && t <= RT_BUFFER_MAX_FRAMES) realtimeBufferFrames = t;
 
     alexaEnabled = request->hasArg(F("AL"));
     strlcpy(alexaInvocationName, request->arg(F("AI")).c_str(), 33);
@@ -445,6 +460,7 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
     }
   }
   #endif
+  strip.unlockRender();
 
   //USERMODS
   if (subPage == 8)
@@ -529,13 +545,18 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
         DEBUG_PRINTLN(value);
       }
     }
+    strip.lockRender();
     usermods.readFromConfig(um);  // force change of usermod parameters
+    strip.unlockRender();
 
     releaseJSONBufferLock();
   }
   
   if (subPage != 2 && (subPage != 6 || !doReboot)) serializeConfig(); //do not save if factory reset or LED settings (which are saved after LED re-init)
-  if (subPage == 4) alexaInit();
+  if (subPage == 4) {
+    alexaInit();
+    joinSyncGroups(); //receive groups may have changed
+  }
 }
 
 
@@ -604,6 +625,8 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   DEBUG_PRINT(F("API req: "));
   DEBUG_PRINTLN(req);
 
+  strip.lockRender(); //changes segments directly, released while presets are saved or loaded
+
   //segment select (sets main segment)
   pos = req.indexOf(F("SM="));
   if (pos > 0) {
@@ -689,7 +712,11 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   }
 
   pos = req.indexOf(F("PS=")); //saves current in preset
-  if (pos > 0) savePreset(getNumVal(&req, pos));
+  if (pos > 0) {
+    strip.unlockRender();
+    savePreset(getNumVal(&req, pos));
+    strip.lockRender();
+  }
 
   pos = req.indexOf(F("P1=")); //sets first preset for cycle
   if (pos > 0) presetCycMin = getNumVal(&req, pos);
@@ -700,7 +727,9 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   //apply preset
   if (updateVal(&req, "PL=", &presetCycCurr, presetCycMin, presetCycMax)) {
 		unloadPlaylist();
+    strip.unlockRender();
     applyPreset(presetCycCurr);
+    strip.lockRender();
   }
 
   //set brightness
@@ -849,7 +878,9 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   //apply macro (deprecated, added for compatibility with pre-0.11 automations)
   pos = req.indexOf(F("&M="));
   if (pos > 0) {
+    strip.unlockRender();
     applyPreset(getNumVal(&req, pos) + 16);
+    strip.lockRender();
   }
 
   //toggle send UDP direct notifications
@@ -968,6 +999,8 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   }
   // you can add more if you need
 
+  strip.unlockRender();
+
   // global col[], effectCurrent, ... are updated in stateChanged()
   if (!apply) return true; // when called by JSON API, do not call colorUpdated() here
 
@@ -0,0 +1,669 @@
+#include "wled.h"
+
+/*
+ * Binary state snapshots
+ * Compact, versioned encoding of what a preset holds (on, bri, transition, main segment, segments, playlist)
+ * that is written from and applied to the current state without a JSON document.
+ * Used for quick saves (/tmp.snap, see savePreset()) and by the preset cache.
+ * jsonToSnapshot() and snapshotToJson() convert from and to the JSON representation of serializeState(root, true).
+ * Presets with other keys or relative values ("~", "r", hex colors, ...) are not representable and stay JSON.
+ *
+ * Layout (little endian):
+ *  0: 'W','S', version, flags (SNAP_*), flags2 (SNAP2_*), on, bri, 2 byte transition, mainseg, segment count
+ * 11: preset name (SNAP_NAME) and quick load label (SNAP2_QL), each 1 byte length and the characters
+ *     segment records: id, type (0: disabled i.e. {"stop":0}, 1: active), for active segments:
+ *     [2 byte start, 2 byte stop (SNAP_BOUNDS)], grp, spc, 2 byte of, options (SNAP_SEG_*), bri, 2 byte cct,
+ *     3 colors of 4 bytes (RGBW), fx, sx, ix, pal, [name (SNAP_SEG_NAME)]
+ *     playlist (SNAP_PLAYLIST): entry count, per entry preset id, 2 byte duration, 2 byte transition,
+ *     2 byte repeat, end preset, shuffle
+ */
+
+#define SNAP_VERSION 1
+#define SNAP_HEADER  11
+
+#define SNAP_ON       0x01
+#define SNAP_BRI      0x02
+#define SNAP_TR       0x04
+#define SNAP_MAINSEG  0x08
+#define SNAP_SEG      0x10 // "seg" array present
+#define SNAP_BOUNDS   0x20 // segments include start and stop
+#define SNAP_PLAYLIST 0x40
+#define SNAP_NAME     0x80
+#define SNAP2_QL      0x01
+
+#define SNAP_SEG_ON    0x01
+#define SNAP_SEG_FRZ   0x02
+#define SNAP_SEG_SEL   0x04
+#define SNAP_SEG_REV   0x08
+#define SNAP_SEG_MI    0x10
+#define SNAP_SEG_WHITE 0x20 // colors have a white channel in JSON
+#define SNAP_SEG_NAME  0x40
+
+#define SNAP_MAX_PLAYLIST 100
+#define SNAP_NAME_LEN     32 //preset and segment names, longer ones stay JSON
+
+typedef struct SnapshotWriter {
+  uint8_t* buf;     //nullptr to only measure
+  size_t   len;
+  size_t   pos;
+} snap_writer;
+
+typedef struct SnapshotReader {
+  const uint8_t* buf;
+  size_t len;
+  size_t pos;
+  bool   error;
+} snap_reader;
+
+typedef struct SnapshotSegment {
+  uint8_t  id;
+  uint8_t  type;
+  uint16_t start, stop;
+  uint8_t  grp, spc;
+  uint16_t offset;
+  uint8_t  options;
+  uint8_t  bri;
+  uint16_t cct;
+  uint32_t colors[3];
+  uint8_t  fx, sx, ix, pal;
+  char     name[SNAP_NAME_LEN+1];
+} snap_segment;
+
+static void put8(snap_writer &w, uint8_t v)
+{
+  if (w.buf && w.pos < w.len) w.buf[w.pos] = v;
+  w.pos++;
+}
+
+static void put16(snap_writer &w, uint16_t v)
+{
+  put8(w, v & 0xFF);
+  put8(w, v >> 8);
+}
+
+static void putString(snap_writer &w, const char* s, size_t maxLen)
+{
+  uint8_t len = s ? strnlen(s, maxLen) : 0;
+  put8(w, len);
+  for (uint8_t i = 0; i < len; i++) put8(w, s[i]);
+}
+
+static uint8_t get8(snap_reader &r)
+{
+  if (r.pos >= r.len) { r.error = true; return 0; }
+  return r.buf[r.pos++];
+}
+
+static uint16_t get16(snap_reader &r)
+{
+  uint16_t v = get8(r);
+  return v | (get8(r) << 8);
+}
+
+//copies a string of at most destSize -1 characters, dest may be nullptr to skip it
+static void getString(snap_reader &r, char* dest, size_t destSize)
+{
+  uint8_t len = get8(r);
+  if (len >= destSize || r.pos + len > r.len) { r.error = true; return; }
+  if (dest) {
+    memcpy(dest, r.buf + r.pos, len);
+    dest[len] = '\0';
+  }
+  r.pos += len;
+}
+
+static void putSegment(snap_writer &w, const snap_segment &s, bool bounds)
+{
+  put8(w, s.id);
+  put8(w, s.type);
+  if (!s.type) return;
+  if (bounds) {
+    put16(w, s.start);
+    put16(w, s.stop);
+  }
+  put8(w, s.grp);
+  put8(w, s.spc);
+  put16(w, s.offset);
+  put8(w, s.options);
+  put8(w, s.bri);
+  put16(w, s.cct);
+  for (uint8_t i = 0; i < 3; i++) {
+    put8(w, R(s.colors[i])); put8(w, G(s.colors[i])); put8(w, B(s.colors[i])); put8(w, W(s.colors[i]));
+  }
+  put8(w, s.fx);
+  put8(w, s.sx);
+  put8(w, s.ix);
+  put8(w, s.pal);
+  if (s.options & SNAP_SEG_NAME) putString(w, s.name, SNAP_NAME_LEN);
+}
+
+static void getSegment(snap_reader &r, snap_segment &s, bool bounds)
+{
+  memset(&s, 0, sizeof(s));
+  s.id = get8(r);
+  s.type = get8(r);
+  if (s.type > 1) r.error = true;
+  if (!s.type || r.error) return;
+  if (bounds) {
+    s.start = get16(r);
+    s.stop = get16(r);
+  }
+  s.grp = get8(r);
+  s.spc = get8(r);
+  s.offset = get16(r);
+  s.options = get8(r);
+  s.bri = get8(r);
+  s.cct = get16(r);
+  for (uint8_t i = 0; i < 3; i++) {
+    uint8_t c[4];
+    for (uint8_t j = 0; j < 4; j++) c[j] = get8(r);
+    s.colors[i] = RGBW32(c[0], c[1], c[2], c[3]);
+  }
+  s.fx = get8(r);
+  s.sx = get8(r);
+  s.ix = get8(r);
+  s.pal = get8(r);
+  if (s.options & SNAP_SEG_NAME) getString(r, s.name, sizeof(s.name));
+}
+
+static void segmentFromStrip(snap_segment &s, WS2812FX::Segment &seg, uint8_t id)
+{
+  memset(&s, 0, sizeof(s));
+  s.id = id;
+  s.type = 1;
+  s.start = seg.start;
+  s.stop = seg.stop;
+  s.grp = seg.grouping;
+  s.spc = seg.spacing;
+  s.offset = seg.offset;
+  if (seg.getOption(SEG_OPTION_ON))       s.options |= SNAP_SEG_ON;
+  if (seg.getOption(SEG_OPTION_FREEZE))   s.options |= SNAP_SEG_FRZ;
+  if (seg.isSelected())                   s.options |= SNAP_SEG_SEL;
+  if (seg.getOption(SEG_OPTION_REVERSED)) s.options |= SNAP_SEG_REV;
+  if (seg.getOption(SEG_OPTION_MIRROR))   s.options |= SNAP_SEG_MI;
+  if (strip.hasWhiteChannel())            s.options |= SNAP_SEG_WHITE;
+  if (seg.name != nullptr && seg.name[0]) {
+    s.options |= SNAP_SEG_NAME;
+    strlcpy(s.name, seg.name, sizeof(s.name));
+  }
+  s.bri = seg.opacity ? seg.opacity : 255;
+  s.cct = seg.cct;
+  for (uint8_t i = 0; i < 3; i++) { //serializeSegment() leaves out white without a white channel
+    s.colors[i] = (s.options & SNAP_SEG_WHITE) ? seg.colors[i] : seg.colors[i] & 0x00FFFFFF;
+  }
+  s.fx = seg.mode;
+  s.sx = seg.speed;
+  s.ix = seg.intensity;
+  s.pal = seg.palette;
+}
+
+//same as deserializeSegment() with all keys of serializeSegment(seg, id, true) present
+static void applySegment(const snap_segment &s, uint8_t it, byte presetId, bool bounds)
+{
+  uint8_t id = s.type ? s.id : it;
+  if (id >= strip.getMaxSegments()) return;
+
+  WS2812FX::Segment& seg = strip.getSegment(id);
+  WS2812FX::Segment prev = seg; //make a backup so we can tell if something changed
+
+  uint16_t start = seg.start;
+  uint16_t stop = seg.stop;
+  if (!s.type) stop = 0;
+  else if (bounds) {
+    start = s.start;
+    stop = s.stop;
+  }
+
+  if (s.options & SNAP_SEG_NAME) {
+    if (seg.name) delete[] seg.name;
+    size_t len = strlen(s.name);
+    seg.name = new char[len+1];
+    if (seg.name) strlcpy(seg.name, s.name, len+1);
+  } else if (start != seg.start || stop != seg.stop) {
+    if (seg.name) delete[] seg.name;
+    seg.name = nullptr;
+  }
+
+  uint8_t grp = s.type ? s.grp : seg.grouping;
+  uint8_t spc = s.type ? s.spc : seg.spacing;
+  uint16_t of = seg.offset;
+  uint16_t len = 1;
+  if (stop > start) len = stop - start;
+  if (s.type) of = (s.offset > len - 1) ? s.offset % len : s.offset;
+  if (stop > start && of > len -1) of = len -1;
+  strip.setSegment(id, start, stop, grp, spc, of);
+
+  if (s.type) {
+    if (s.bri > 0) seg.setOpacity(s.bri, id);
+    seg.setOption(SEG_OPTION_ON, s.bri, id);
+    seg.setOption(SEG_OPTION_ON, s.options & SNAP_SEG_ON, id);
+    seg.setOption(SEG_OPTION_FREEZE, s.options & SNAP_SEG_FRZ, id);
+    seg.setCCT(s.cct, id);
+    for (uint8_t i = 0; i < 3; i++) {
+      seg.setColor(i, s.colors[i], id);
+      if (seg.mode == FX_MODE_STATIC) strip.trigger(); //instant refresh
+    }
+    seg.setOption(SEG_OPTION_SELECTED, s.options & SNAP_SEG_SEL);
+    seg.setOption(SEG_OPTION_REVERSED, s.options & SNAP_SEG_REV);
+    seg.setOption(SEG_OPTION_MIRROR  , s.options & SNAP_SEG_MI);
+    if (!presetId && currentPlaylist>=0) unloadPlaylist();
+    strip.setMode(id, s.fx);
+    seg.speed = s.sx;
+    seg.intensity = s.ix;
+    seg.palette = s.pal;
+  } else {
+    seg.setOption(SEG_OPTION_FREEZE, false); //return to regular effect
+  }
+
+  if (seg.differs(prev) & 0x7F) stateChanged = true;
+}
+
+static void segmentToJson(const snap_segment &s, JsonObject elem, bool bounds)
+{
+  if (!s.type) {
+    elem["stop"] = 0;
+    return;
+  }
+  elem["id"] = s.id;
+  if (bounds) {
+    elem["start"] = s.start;
+    elem["stop"] = s.stop;
+  }
+  elem["grp"] = s.grp;
+  elem[F("spc")] = s.spc;
+  elem[F("of")] = s.offset;
+  elem["on"] = (bool)(s.options & SNAP_SEG_ON);
+  elem["frz"] = (bool)(s.options & SNAP_SEG_FRZ);
+  elem["bri"] = s.bri;
+  elem["cct"] = s.cct;
+  if (s.options & SNAP_SEG_NAME) elem["n"] = (char*)s.name; //copied, a const char* would only be referenced
+  JsonArray col = elem.createNestedArray("col");
+  for (uint8_t i = 0; i < 3; i++) {
+    JsonArray c = col.createNestedArray();
+    c.add(R(s.colors[i])); c.add(G(s.colors[i])); c.add(B(s.colors[i]));
+    if (s.options & SNAP_SEG_WHITE) c.add(W(s.colors[i]));
+  }
+  elem["fx"] = s.fx;
+  elem[F("sx")] = s.sx;
+  elem[F("ix")] = s.ix;
+  elem["pal"] = s.pal;
+  elem[F("sel")] = (bool)(s.options & SNAP_SEG_SEL);
+  elem["rev"] = (bool)(s.options & SNAP_SEG_REV);
+  elem[F("mi")] = (bool)(s.options & SNAP_SEG_MI);
+}
+
+#define SNAP_VALIDATE 0
+#define SNAP_APPLY    1
+#define SNAP_JSON     2
+
+//walks all records of a snapshot and validates, applies (see deserializeState()) or converts it
+static bool processSnapshot(const uint8_t* buf, size_t len, uint8_t mode, JsonObject root, byte callMode = CALL_MODE_DIRECT_CHANGE, byte presetId = 0)
+{
+  snap_reader r = {buf, len, 0, false};
+  if (len < SNAP_HEADER || buf[0] != 'W' || buf[1] != 'S' || buf[2] != SNAP_VERSION) return false;
+  r.pos = 3;
+  uint8_t flags = get8(r);
+  uint8_t flags2 = get8(r);
+  bool on = get8(r);
+  uint8_t newBri = get8(r);
+  uint16_t tr = get16(r);
+  uint8_t mainseg = get8(r);
+  uint8_t segCount = get8(r);
+  bool bounds = flags & SNAP_BOUNDS;
+
+  char name[SNAP_NAME_LEN+1];
+  if (flags & SNAP_NAME) {
+    getString(r, name, sizeof(name));
+    if (mode == SNAP_JSON) root["n"] = name; //copied
+  }
+  if (flags2 & SNAP2_QL) {
+    getString(r, name, 3);
+    if (mode == SNAP_JSON) root[F("ql")] = name;
+  }
+  if (r.error) return false;
+
+  if (mode == SNAP_APPLY) {
+    if (flags & SNAP_BRI) bri = newBri;
+    if (!(flags & SNAP_ON)) on = bri > 0;
+    if (!on != !bri) toggleOnOff();
+    if ((flags & SNAP_TR) && (!presetId || currentPlaylist < 0)) { //do not apply transition time from preset if playlist active
+      transitionDelay = tr;
+      transitionDelay *= 100;
+      transitionDelayTemp = transitionDelay;
+    }
+    strip.setTransition(transitionDelayTemp);
+    if (flags & SNAP_MAINSEG) strip.setMainSegmentId(mainseg);
+  } else if (mode == SNAP_JSON) {
+    if (flags & SNAP_ON) root["on"] = on;
+    if (flags & SNAP_BRI) root["bri"] = newBri;
+    if (flags & SNAP_TR) root[F("transition")] = tr;
+    if (flags & SNAP_MAINSEG) root[F("mainseg")] = mainseg;
+  }
+
+  JsonArray segs;
+  if (mode == SNAP_JSON && (flags & SNAP_SEG)) segs = root.createNestedArray("seg");
+  snap_segment s;
+  for (uint8_t i = 0; i < segCount; i++) {
+    getSegment(r, s, bounds);
+    if (r.error) return false;
+    if (mode == SNAP_APPLY) applySegment(s, i, presetId, bounds);
+    else if (mode == SNAP_JSON) segmentToJson(s, segs.createNestedObject(), bounds);
+  }
+
+  if (flags & SNAP_PLAYLIST) {
+    uint8_t n = get8(r);
+    if (n == 0 || n > SNAP_MAX_PLAYLIST || r.pos + n * 5 + 4 > len) return false;
+    const uint8_t* entries = buf + r.pos;
+    r.pos += n * 5;
+    int16_t repeat = get16(r);
+    uint8_t endPreset = get8(r);
+    bool shuffle = get8(r);
+    if (mode == SNAP_APPLY) {
+      byte ps[SNAP_MAX_PLAYLIST];
+      uint16_t dur[SNAP_MAX_PLAYLIST], trs[SNAP_MAX_PLAYLIST];
+      for (uint8_t i = 0; i < n; i++) {
+        ps[i] = entries[i*5];
+        dur[i] = entries[i*5 +1] | (entries[i*5 +2] << 8);
+        trs[i] = entries[i*5 +3] | (entries[i*5 +4] << 8);
+      }
+      if (loadPlaylist(ps, dur, trs, n, repeat, endPreset, shuffle, presetId)) {
+        //do not notify here, because the first playlist entry will do
+        callMode = (flags & SNAP_ON) ? CALL_MODE_DIRECT_CHANGE : CALL_MODE_NO_NOTIFY;
+      } else interfaceUpdateCallMode = CALL_MODE_WS_SEND;
+    } else if (mode == SNAP_JSON) {
+      JsonObject playlist = root.createNestedObject(F("playlist"));
+      JsonArray ps = playlist.createNestedArray("ps");
+      JsonArray dur = playlist.createNestedArray("dur");
+      JsonArray trs = playlist.createNestedArray(F("transition"));
+      for (uint8_t i = 0; i < n; i++) {
+        ps.add(entries[i*5]);
+        dur.add(entries[i*5 +1] | (entries[i*5 +2] << 8));
+        trs.add(entries[i*5 +3] | (entries[i*5 +4] << 8));
+      }
+      playlist[F("repeat")] = repeat;
+      playlist["end"] = endPreset;
+      playlist["r"] = shuffle;
+    }
+  } else if (mode == SNAP_APPLY) interfaceUpdateCallMode = CALL_MODE_WS_SEND;
+
+  if (r.error) return false;
+  if (mode == SNAP_APPLY) stateUpdated(callMode);
+  return true;
+}
+
+static void putHeader(snap_writer &w, uint8_t flags, uint8_t flags2, bool on, uint8_t b, uint16_t tr, uint8_t mainseg, uint8_t segCount)
+{
+  put8(w, 'W');
+  put8(w, 'S');
+  put8(w, SNAP_VERSION);
+  put8(w, flags);
+  put8(w, flags2);
+  put8(w, on);
+  put8(w, b);
+  put16(w, tr);
+  put8(w, mainseg);
+  put8(w, segCount);
+}
+
+//current state as serializeState(root, true, includeBri, segmentBounds) would save it
+//returns the snapshot length, 0 if buf is too small (call with buf == nullptr to get the length)
+//reads the segments, so the caller holds the render lock
+size_t writeStateSnapshot(uint8_t* buf, size_t len, bool includeBri, bool segmentBounds)
+{
+  snap_writer w = {buf, len, 0};
+  uint8_t flags = SNAP_MAINSEG | SNAP_SEG;
+  if (includeBri) flags |= SNAP_ON | SNAP_BRI | SNAP_TR;
+  if (segmentBounds) flags |= SNAP_BOUNDS;
+
+  uint8_t segCount = 0;
+  for (byte s = 0; s < strip.getMaxSegments(); s++) {
+    if (strip.getSegment(s).isActive() || segmentBounds) segCount++;
+  }
+  putHeader(w, flags, 0, bri > 0, briLast, transitionDelay/100, strip.getMainSegmentId(), segCount);
+
+  snap_segment seg;
+  for (byte s = 0; s < strip.getMaxSegments(); s++) {
+    WS2812FX::Segment &sg = strip.getSegment(s);
+    if (sg.isActive()) {
+      segmentFromStrip(seg, sg, s);
+      putSegment(w, seg, segmentBounds);
+    } else if (segmentBounds) { //disable segments not part of preset
+      put8(w, s);
+      put8(w, 0);
+    }
+  }
+  if (buf && w.pos > len) return 0;
+  return w.pos;
+}
+
+static bool isUint(JsonVariant v, uint32_t max)
+{
+  return v.is<int>() && v.as<int>() >= 0 && v.as<unsigned>() <= max;
+}
+
+//converts one element of the "seg" array, false if it uses anything not representable
+static bool segmentFromJson(snap_segment &s, JsonObject elem, bool &bounds, bool first)
+{
+  memset(&s, 0, sizeof(s));
+  if (elem.size() == 1 && elem["stop"] == 0) return true; //disabled segment
+
+  static const char* const keys[] = {"id","grp","spc","of","on","frz","bri","cct","col","fx","sx","ix","pal","sel","rev","mi"};
+  size_t count = 0;
+  for (const char* key : keys) {
+    if (!elem.containsKey(key)) return false;
+    count++;
+  }
+  bool hasBounds = elem.containsKey("start") && elem.containsKey("stop");
+  if (first) bounds = hasBounds;
+  if (hasBounds != bounds) return false;
+  if (bounds) count += 2;
+  if (elem.containsKey("n")) count++;
+  if (elem.size() != count) return false; //other keys
+
+  if (!isUint(elem["id"], 255) || !isUint(elem["grp"], 255) || !isUint(elem["spc"], 255) || !isUint(elem["of"], UINT16_MAX)
+   || !isUint(elem["bri"], 255) || !isUint(elem["cct"], UINT16_MAX) || !isUint(elem["fx"], 255) || !isUint(elem["sx"], 255)
+   || !isUint(elem["ix"], 255) || !isUint(elem["pal"], 255)) return false;
+  if (bounds && (!isUint(elem["start"], UINT16_MAX) || !isUint(elem["stop"], UINT16_MAX))) return false;
+  const char* boolKeys[] = {"on","frz","sel","rev","mi"};
+  const uint8_t boolOptions[] = {SNAP_SEG_ON, SNAP_SEG_FRZ, SNAP_SEG_SEL, SNAP_SEG_REV, SNAP_SEG_MI};
+  for (uint8_t i = 0; i < 5; i++) {
+    if (!elem[boolKeys[i]].is<bool>()) return false;
+    if (elem[boolKeys[i]].as<bool>()) s.options |= boolOptions[i];
+  }
+
+  JsonArray col = elem["col"];
+  if (col.isNull() || col.size() != 3) return false;
+  size_t channels = 0;
+  for (uint8_t i = 0; i < 3; i++) {
+    JsonArray c = col[i];
+    if (c.isNull() || (c.size() != 3 && c.size() != 4) || (channels && c.size() != channels)) return false;
+    channels = c.size();
+    uint8_t rgbw[4] = {0};
+    for (uint8_t j = 0; j < channels; j++) {
+      if (!isUint(c[j], 255)) return false;
+      rgbw[j] = c[j];
+    }
+    s.colors[i] = RGBW32(rgbw[0], rgbw[1], rgbw[2], rgbw[3]);
+  }
+  if (channels == 4) s.options |= SNAP_SEG_WHITE;
+
+  if (elem.containsKey("n")) {
+    const char* name = elem["n"];
+    if (name == nullptr || !name[0] || strlen(name) > SNAP_NAME_LEN) return false;
+    strlcpy(s.name, name, sizeof(s.name));
+    s.options |= SNAP_SEG_NAME;
+  }
+
+  s.type = 1;
+  s.id = elem["id"];
+  s.start = elem["start"];
+  s.stop = elem["stop"];
+  s.grp = elem["grp"];
+  s.spc = elem["spc"];
+  s.offset = elem["of"];
+  s.bri = elem["bri"];
+  s.cct = elem["cct"];
+  s.fx = elem["fx"];
+  s.sx = elem["sx"];
+  s.ix = elem["ix"];
+  s.pal = elem["pal"];
+  return true;
+}
+
+//playlist entries expanded the same way as loadPlaylist() does, false if not representable
+static bool playlistFromJson(snap_writer &w, JsonObject playlist)
+{
+  size_t keys = 0;
+  JsonArray ps = playlist["ps"];
+  JsonVariant dur = playlist["dur"];
+  JsonVariant tr = playlist[F("transition")];
+  if (ps.isNull() || ps.size() == 0 || ps.size() > SNAP_MAX_PLAYLIST || tr.isNull()) return false; //default transition depends on the current one
+  keys = 2;
+  if (!dur.isNull()) keys++;
+  if (playlist.containsKey("repeat")) {
+    int repeat = playlist["repeat"] | INT32_MAX;
+    if (!playlist["repeat"].is<int>() || repeat < INT16_MIN || repeat > INT16_MAX) return false;
+    keys++;
+  }
+  if (playlist.containsKey("end")) { if (!isUint(playlist["end"], 255)) return false; keys++; }
+  if (playlist.containsKey("r")) { if (!playlist["r"].is<bool>()) return false; keys++; }
+  if (playlist.size() != keys) return false;
+
+  uint8_t n = ps.size();
+  JsonArray durs = dur.as<JsonArray>(), trs = tr.as<JsonArray>();
+  if ((!durs.isNull() && durs.size() == 0) || (!trs.isNull() && trs.size() == 0)) return false;
+  if ((durs.isNull() && !dur.isNull() && !isUint(dur, UINT16_MAX)) || (trs.isNull() && !isUint(tr, UINT16_MAX))) return false;
+
+  put8(w, n);
+  uint16_t d = 100, t = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    if (!isUint(ps[i], 255)) return false;
+    if (durs.isNull()) {
+      if (i == 0) d = dur | 100; //10 seconds as fallback
+    } else if (i < durs.size()) {
+      if (!isUint(durs[i], UINT16_MAX)) return false;
+      d = durs[i];
+      if (d <= 1) d = 100;
+    }
+    if (trs.isNull()) {
+      if (i == 0) t = tr;
+    } else if (i < trs.size()) {
+      if (!isUint(trs[i], UINT16_MAX)) return false;
+      t = trs[i];
+    }
+    put8(w, ps[i].as<uint8_t>());
+    put16(w, d);
+    put16(w, t);
+  }
+  put16(w, (int16_t)(playlist["repeat"] | 0));
+  put8(w, playlist["end"] | 0);
+  put8(w, playlist["r"] | false);
+  return true;
+}
+
+//encodes a preset, returns the snapshot length or 0 if it is not representable or buf is too small
+//(call with buf == nullptr to get the length)
+size_t jsonToSnapshot(JsonObject root, uint8_t* buf, size_t len)
+{
+  snap_writer w = {buf, len, 0};
+  uint8_t flags = 0, flags2 = 0;
+  size_t keys = 0;
+
+  if (root.containsKey("on"))  { if (!root["on"].is<bool>()) return 0; flags |= SNAP_ON; keys++; }
+  if (root.containsKey("bri")) { if (!isUint(root["bri"], 255)) return 0; flags |= SNAP_BRI; keys++; }
+  if (root.containsKey("transition")) { if (!isUint(root["transition"], UINT16_MAX)) return 0; flags |= SNAP_TR; keys++; }
+  if (root.containsKey("mainseg")) { if (!isUint(root["mainseg"], 255)) return 0; flags |= SNAP_MAINSEG; keys++; }
+  const char* name = nullptr;
+  if (root.containsKey("n")) {
+    name = root["n"];
+    if (name == nullptr || strlen(name) > SNAP_NAME_LEN) return 0;
+    flags |= SNAP_NAME; keys++;
+  }
+  const char* ql = nullptr;
+  if (root.containsKey("ql")) {
+    ql = root["ql"];
+    if (ql == nullptr || strlen(ql) > 2) return 0;
+    flags2 |= SNAP2_QL; keys++;
+  }
+  JsonArray segs = root["seg"];
+  if (root.containsKey("seg")) { if (segs.isNull() || segs.size() > 255) return 0; flags |= SNAP_SEG; keys++; }
+  JsonObject playlist = root[F("playlist")];
+  if (root.containsKey("playlist")) { if (playlist.isNull()) return 0; flags |= SNAP_PLAYLIST; keys++; }
+  if (root.size() != keys) return 0; //other keys (HTTP API, "ps", usermods, ...)
+
+  //segments decide whether bounds are included, so they are converted before the header is written
+  bool bounds = false;
+  snap_segment s;
+  bool first = true;
+  for (JsonObject elem : segs) {
+    if (!segmentFromJson(s, elem, bounds, first)) return 0;
+    if (s.type) first = false;
+  }
+  if (bounds) flags |= SNAP_BOUNDS;
+
+  putHeader(w, flags, flags2, root["on"] | false, root["bri"] | 0, root[F("transition")] | 0, root[F("mainseg")] | 0, segs.size());
+  if (name) putString(w, name, SNAP_NAME_LEN);
+  if (ql) putString(w, ql, 2);
+  first = true;
+  uint8_t it = 0;
+  for (JsonObject elem : segs) {
+    segmentFromJson(s, elem, bounds, first);
+    if (s.type) first = false;
+    else s.id = it; //disabled segments are applied by position, written like writeStateSnapshot() does
+    putSegment(w, s, bounds);
+    it++;
+  }
+  if (!playlist.isNull() && !playlistFromJson(w, playlist)) return 0;
+
+  if (buf && w.pos > len) return 0;
+  return w.pos;
+}
+
+//adds the JSON representation of a snapshot to root
+bool snapshotToJson(const uint8_t* buf, size_t len, JsonObject root)
+{
+  if (!processSnapshot(buf, len, SNAP_VALIDATE, root)) return false;
+  return processSnapshot(buf, len, SNAP_JSON, root);
+}
+
+//applies a snapshot like deserializeState() applies the equivalent JSON
+bool applyStateSnapshot(const uint8_t* buf, size_t len, byte callMode, byte presetId)
+{
+  if (!processSnapshot(buf, len, SNAP_VALIDATE, JsonObject())) return false;
+  if (!strip.lockRender(1000)) return false;
+  processSnapshot(buf, len, SNAP_APPLY, JsonObject(), callMode, presetId);
+  strip.unlockRender();
+  return true;
+}
+
+//quick save of the current state
+bool saveStateSnapshotFile(const char* file)
+{
+  //segment names and bounds must not change between measuring and writing, the file is written after unlocking
+  if (!strip.lockRender(1000)) return false;
+  size_t len = writeStateSnapshot(nullptr, 0);
+  uint8_t* buf = (uint8_t*) malloc(len);
+  if (buf) writeStateSnapshot(buf, len);
+  strip.unlockRender();
+  if (!buf) return false;
+  if (doCloseFile) closeFile();
+  File sf = WLED_FS.open(file, "w");
+  bool success = sf && sf.write(buf, len) == len;
+  sf.close();
+  free(buf);
+  return success;
+}
+
+bool applyStateSnapshotFile(const char* file, byte callMode, byte presetId)
+{
+  if (doCloseFile) closeFile();
+  File sf = WLED_FS.open(file, "r");
+  if (!sf) return false;
+  size_t len = sf.size();
+  uint8_t* buf = (uint8_t*) malloc(len);
+  bool success = buf && sf.read(buf, len) == len;
+  sf.close();
+  if (success) success = applyStateSnapshot(buf, len, callMode, presetId);
+  free(buf);
+  return success;
+}
@@ -54,10 +54,13 @@ typedef struct ip_addr ip4_addr_t;
 #define DDP_TIMECODE_FLAG 0x10
 
 #define ARTNET_OPCODE_OPDMX 0x5000
+#define ARTNET_OPCODE_OPSYNC 0x5200
 
 #define P_E131   0
 #define P_ARTNET 1
 #define P_DDP    2
+#define P_E131_SYNC   3 // E1.31 universe synchronization packet
+#define P_ARTNET_SYNC 4 // Art-Net ArtSync packet
 
 // E1.31 Packet Offsets
 #define E131_ROOT_PREAMBLE_SIZE 0
@@ -84,6 +87,10 @@ typedef struct ip_addr ip4_addr_t;
 #define E131_DMP_COUNT 123
 #define E131_DMP_DATA 125
 
+// E1.31 Synchronization Packet Framing Layer
+#define E131_SYNC_SEQ 44
+#define E131_SYNC_ADDR 45
+
 // E1.31 Packet Structure
 typedef union {
     struct { //E1.31 packet
@@ -162,6 +169,8 @@ class ESPAsyncE131 {
     static const uint32_t VECTOR_ROOT = 4;
     static const uint32_t VECTOR_FRAME = 2;
     static const uint8_t VECTOR_DMP = 2;
+    static const uint32_t VECTOR_ROOT_EXTENDED = 8;
+    static const uint32_t VECTOR_EXTENDED_SYNC = 1;
 
     AsyncUDP        udp;        // AsyncUDP
 
@@ -0,0 +1,222 @@
+#include "wled.h"
+
+/*
+ * Node time sync
+ * NTP style exchange between WLED nodes on the node list port (udpPort2) to keep the effect phase
+ * (strip.timebase) and system time (toki) of all nodes aligned, instead of presuming a network delay.
+ * All nodes follow the reference node: the one with the best toki time source, the lowest unit id among equals.
+ * A request carries the send time t1, the reply the receive time t2 and send time t3 of the other node
+ * together with its effect time and toki time at t3. With t4 as the time the reply is received:
+ *   clock offset = ((t2 - t1) + (t3 - t4)) / 2,  round trip = (t4 - t1) - (t3 - t2)
+ * Samples that were held up on the way (round trip well above the recent minimum) are discarded.
+ * The other nodes are measured in turn for the offset and jitter reported in /json/nodes.
+ * Timestamps are in us, the timebase itself has 1 ms resolution.
+ */
+
+#define TIMESYNC_REQUEST      2 // udpIn[1], node info is 1
+#define TIMESYNC_REPLY        3
+#define TIMESYNC_REQUEST_LEN  8
+#define TIMESYNC_REPLY_LEN   28
+#define TIMESYNC_MAX_FAILED   3 // unanswered requests after which a node is no longer used as reference
+#define TIMESYNC_RTT_MARGIN 500 // us a sample may be slower than the fastest recent one
+
+static uint8_t tsRefUnit = 0;           // unit of the reference node, 0 if we are the reference
+static uint8_t tsPollUnit = 0;          // node measured last for statistics
+static unsigned long tsLastRequest = 0;
+static unsigned long tsLastSync = 0;    // millis() of the last accepted sample from the reference
+
+// 64 bit us timer, the lower 32 bits are micros()
+static inline uint64_t timeSyncNow()
+{
+  #ifdef ESP8266
+  return micros64();
+  #else
+  return esp_timer_get_time();
+  #endif
+}
+
+static void sendTimeSyncRequest(NodeStruct &node)
+{
+  uint8_t data[TIMESYNC_REQUEST_LEN] = {0};
+  data[0] = 255;
+  data[1] = TIMESYNC_REQUEST;
+  if (node.timeRequest && node.timeFailed < 255) node.timeFailed++; // previous request was not answered
+  uint32_t t1 = micros();
+  if (!t1) t1 = 1;
+  memcpy(data + 4, &t1, 4);
+  node.timeRequest = t1;
+  notifier2Udp.beginPacket(node.ip, udpPort2);
+  notifier2Udp.write(data, sizeof(data));
+  notifier2Udp.endPacket();
+}
+
+static void sendTimeSyncReply(const uint8_t* udpIn, IPAddress ip, uint32_t rxTime)
+{
+  //  0: 1 byte 'binary token 255'
+  //  1: 1 byte id '3'
+  //  2: 1 byte reserved
+  //  3: 1 byte toki time source
+  //  4: 4 byte t1 of the request
+  //  8: 4 byte t2, micros() the request was received
+  // 12: 4 byte t3, micros() the reply was sent
+  // 16: 4 byte effect time (millis() + strip.timebase) at t3
+  // 20: 4 byte toki seconds at t3
+  // 24: 2 byte toki milliseconds at t3
+  // 26: 2 byte us since the effect time last changed, 0-999
+  // little endian
+  uint8_t data[TIMESYNC_REPLY_LEN] = {0};
+  data[0] = 255;
+  data[1] = TIMESYNC_REPLY;
+  data[3] = toki.getTimeSource();
+  memcpy(data + 4, udpIn + 4, 4);
+  memcpy(data + 8, &rxTime, 4);
+  Toki::Time tm = toki.getTime();
+  uint64_t now = timeSyncNow();
+  uint32_t t3 = now;
+  uint32_t effectTime = now / 1000 + strip.timebase;
+  uint16_t effectFraction = now % 1000;
+  memcpy(data + 12, &t3, 4);
+  memcpy(data + 16, &effectTime, 4);
+  memcpy(data + 20, &tm.sec, 4);
+  memcpy(data + 24, &tm.ms, 2);
+  memcpy(data + 26, &effectFraction, 2);
+  notifier2Udp.beginPacket(ip, udpPort2);
+  notifier2Udp.write(data, sizeof(data));
+  notifier2Udp.endPacket();
+}
+
+// adopt toki time of the reference if it is more accurate or our time came from another node anyway
+static void syncToki(uint8_t source, Toki::Time tm, int32_t elapsed)
+{
+  uint8_t own = toki.getTimeSource();
+  if (source <= TOKI_TS_BAD) return;
+  if (source <= own && own != TOKI_TS_UDP && own != TOKI_TS_UDP_SEC && own != TOKI_TS_UDP_NTP) return;
+  toki.adjust(tm, elapsed);
+  uint8_t ts = TOKI_TS_UDP;
+  if (source > 99) ts = TOKI_TS_UDP_NTP;
+  else if (source >= TOKI_TS_SEC) ts = TOKI_TS_UDP_SEC;
+  toki.setTime(tm, ts);
+}
+
+static void handleTimeSyncReply(const uint8_t* udpIn, IPAddress ip, uint32_t rxTime)
+{
+  NodesMap::iterator it = Nodes.find(ip[3]);
+  if (it == Nodes.end() || it->second.ip != ip) return;
+  NodeStruct &node = it->second;
+
+  uint32_t t1, t2, t3, t4 = rxTime, effectTime;
+  uint16_t effectFraction;
+  Toki::Time tm;
+  memcpy(&t1, udpIn + 4, 4);
+  if (!node.timeRequest || t1 != node.timeRequest) return; // not the pending request
+  memcpy(&t2, udpIn + 8, 4);
+  memcpy(&t3, udpIn + 12, 4);
+  memcpy(&effectTime, udpIn + 16, 4);
+  memcpy(&tm.sec, udpIn + 20, 4);
+  memcpy(&tm.ms, udpIn + 24, 2);
+  memcpy(&effectFraction, udpIn + 26, 2);
+  node.timeRequest = 0;
+  node.timeFailed = 0;
+  node.timeSync = true;
+  node.timeSource = udpIn[3];
+
+  int32_t rtt = (int32_t)(t4 - t1) - (int32_t)(t3 - t2);
+  if (rtt < 0 || rtt > 1000000) return;
+  // fastest recent round trip, slowly forgotten so a slower route is accepted eventually
+  if (!node.timeRttMin || (uint32_t)rtt < node.timeRttMin) node.timeRttMin = rtt;
+  else node.timeRttMin += (node.timeRttMin >> 5) +1;
+  if ((uint32_t)rtt > node.timeRttMin + (node.timeRttMin >> 1) + TIMESYNC_RTT_MARGIN) return; // held up on the way
+
+  int32_t clock = ((int32_t)(t2 - t1) + (int32_t)(t3 - t4)) / 2; // micros() of the node minus ours
+  if (node.timeRtt) { // jitter needs a previous sample
+    int32_t change = (int32_t)((uint32_t)clock - (uint32_t)node.timeClock);
+    if (change < 0) change = -change;
+    node.timeJitter = node.timeJitter ? node.timeJitter - (node.timeJitter >> 3) + (change >> 3) : change;
+  }
+  node.timeClock = clock;
+  node.timeRtt = rtt;
+
+  // effect time of the node at t4 minus ours, in us
+  uint64_t now = timeSyncNow();
+  uint64_t rx = now - (uint32_t)((uint32_t)now - t4);
+  int32_t sinceReply = (int32_t)(t4 + clock - t3); // us passed on the node since t3
+  int64_t offset = (int64_t)(int32_t)(effectTime - (uint32_t)(rx / 1000 + strip.timebase)) * 1000
+                 + effectFraction - (int64_t)(rx % 1000) + sinceReply;
+  if (offset > INT32_MAX) node.timeOffset = INT32_MAX;
+  else if (offset < INT32_MIN) node.timeOffset = INT32_MIN;
+  else node.timeOffset = offset;
+
+  if (node.ip[3] != tsRefUnit) return;
+  tsLastSync = millis();
+
+  // the timebase has 1 ms resolution: small offsets are rounded and corrected gradually, large ones at once
+  int32_t correction = (offset + (offset < 0 ? -500 : 500)) / 1000;
+  if (correction > 1 && correction <= TIMESYNC_STEP) correction /= 2;
+  else if (correction < -1 && correction >= -TIMESYNC_STEP) correction /= 2;
+  strip.timebase += correction;
+  node.timeOffset -= correction * 1000;
+
+  syncToki(node.timeSource, tm, (sinceReply + (int32_t)(now - rx)) / 1000);
+}
+
+// returns true if the packet was a time sync packet, rxTime is micros() when it was received
+bool handleTimeSyncPacket(const uint8_t* udpIn, uint16_t len, IPAddress ip, uint32_t rxTime)
+{
+  if (udpIn[1] == TIMESYNC_REQUEST) {
+    if (nodeTimeSync && len >= TIMESYNC_REQUEST_LEN) sendTimeSyncReply(udpIn, ip, rxTime);
+    return true;
+  }
+  if (udpIn[1] == TIMESYNC_REPLY) {
+    if (nodeTimeSync && len >= TIMESYNC_REPLY_LEN) handleTimeSyncReply(udpIn, ip, rxTime);
+    return true;
+  }
+  return false;
+}
+
+// node with the best time source, lowest unit among equals, 0 if that is us
+static uint8_t findTimeSyncReference()
+{
+  uint8_t unit = 0;
+  uint16_t best = (toki.getTimeSource() << 8) | (255 - Network.localIP()[3]);
+  for (NodesMap::iterator it = Nodes.begin(); it != Nodes.end(); ++it) {
+    const NodeStruct &node = it->second;
+    if (!node.timeSync || node.ip[0] == 0 || node.timeFailed >= TIMESYNC_MAX_FAILED) continue;
+    uint16_t score = (node.timeSource << 8) | (255 - it->first);
+    if (score > best) { best = score; unit = it->first; }
+  }
+  return unit;
+}
+
+void handleTimeSync()
+{
+  if (!nodeTimeSync || !nodeListEnabled || !udp2Connected) {
+    tsRefUnit = 0;
+    return;
+  }
+  if (millis() - tsLastRequest < TIMESYNC_INTERVAL) return;
+  tsLastRequest = millis();
+
+  tsRefUnit = findTimeSyncReference();
+  if (tsRefUnit) sendTimeSyncRequest(Nodes[tsRefUnit]);
+
+  // measure one other node per interval
+  NodesMap::iterator it = Nodes.upper_bound(tsPollUnit);
+  for (size_t i = 0; i < Nodes.size(); i++, ++it) {
+    if (it == Nodes.end()) it = Nodes.begin();
+    if (it->first == tsRefUnit || it->second.ip[0] == 0) continue;
+    tsPollUnit = it->first;
+    sendTimeSyncRequest(it->second);
+    break;
+  }
+}
+
+// true while the timebase follows the reference node
+bool isTimeSynced()
+{
+  return tsRefUnit && millis() - tsLastSync < TIMESYNC_TIMEOUT;
+}
+
+uint8_t getTimeSyncReference()
+{
+  return tsRefUnit;
+}
@@ -10,6 +10,67 @@
 #define UDP_IN_MAXSIZE 1472
 #define PRESUMED_NETWORK_DELAY 3 //how many ms could it take on avg to reach the receiver? This will be added to transmitted times
 
+//multicast sync: sync group n (1-8) is sent to 239.192.87.n, node info to 239.192.87.0
+#define SYNC_MULTICAST_IP(n) IPAddress(239, 192, 87, (n))
+#define SYNC_MULTICAST_NODES 0x100 //bit of the node info group in syncJoinedGroups
+
+static uint16_t syncJoinedGroups = 0; //multicast groups joined (bit mapped like receiveGroups + SYNC_MULTICAST_NODES)
+
+//join the multicast groups of the sync groups we receive (IGMP) and leave the others
+//rejoin: after (re)connecting, previous memberships are gone
+void joinSyncGroups(bool rejoin)
+{
+  if (rejoin) syncJoinedGroups = 0;
+  uint16_t groups = 0;
+  if (syncMulticast && udpConnected) groups = receiveGroups;
+  if (syncMulticast && udp2Connected && nodeListEnabled) groups |= SYNC_MULTICAST_NODES;
+  if (groups == syncJoinedGroups) return;
+
+  ip4_addr_t ifaddr;
+  ip4_addr_t multicast_addr;
+  ifaddr.addr = static_cast<uint32_t>(Network.localIP());
+  for (uint8_t i = 0; i < 9; i++) {
+    uint16_t bit = (i < 8) ? (1 << i) : SYNC_MULTICAST_NODES;
+    if ((groups & bit) == (syncJoinedGroups & bit)) continue;
+    multicast_addr.addr = static_cast<uint32_t>(SYNC_MULTICAST_IP((i < 8) ? i +1 : 0));
+    if (groups & bit) igmp_joingroup(&ifaddr, &multicast_addr);
+    else              igmp_leavegroup(&ifaddr, &multicast_addr);
+  }
+  syncJoinedGroups = groups;
+}
+
+//send a notification to the multicast group of each sync group, or broadcast it
+static void sendSyncPacket(const byte* buf, size_t len)
+{
+  if (!syncMulticast) {
+    IPAddress broadcastIp;
+    broadcastIp = ~uint32_t(Network.subnetMask()) | uint32_t(Network.gatewayIP());
+    notifierUdp.beginPacket(broadcastIp, udpPort);
+    notifierUdp.write(buf, len);
+    notifierUdp.endPacket();
+    return;
+  }
+  //nodes in several of these groups receive the packet more than once
+  for (uint8_t i = 0; i < 8; i++) {
+    if (!(syncGroups & (1 << i))) continue;
+    notifierUdp.beginPacket(SYNC_MULTICAST_IP(i +1), udpPort);
+    notifierUdp.write(buf, len);
+    notifierUdp.endPacket();
+  }
+}
+
+//delta sync packet: only segment fields that changed since the last notification (see sendDeltaNotification())
+#define UDP_DELTA_PACKET   6   //first byte, ignored by receivers without delta support
+#define UDP_DELTA_VERSION  1
+#define UDP_DELTA_HEADER   27
+#define UDP_DELTA_SEG_MAX  (2+4+4+1+1+4+NUM_COLORS*4+1) //id, mask, all fields
+#define UDP_DELTA_KEYFRAME 8   //every n-th notification carries all segments so receivers that missed packets catch up
+#define UDP_DELTA_IDLE_KEYFRAME 5000 //ms without notifications after a delta, then all segments are sent once more
+#define UDP_DELTA_FOLLOWUP 0x01
+#define UDP_DELTA_FULL     0x02
+
+void sendDeltaNotification(byte callMode, bool followUp, bool keyframe = false);
+
 void notify(byte callMode, bool followUp)
 {
   if (!udpConnected) return;
@@ -28,6 +89,13 @@ void notify(byte callMode, bool followUp)
     case CALL_MODE_HOMEKIT:       if (!notifyHomeKit)     return; break;
     default: return;
   }
+  if (syncDelta) {
+    sendDeltaNotification(callMode, followUp);
+    notificationSentCallMode = callMode;
+    notificationSentTime = millis();
+    notificationTwoRequired = (followUp)? false:notifyTwice;
+    return;
+  }
   byte udpOut[WLEDPACKETSIZE];
   WS2812FX::Segment& mainseg = strip.getMainSegment();
   udpOut[0] = 0; //0: wled notifier protocol 1: WARLS protocol
@@ -128,19 +196,227 @@ void notify(byte callMode, bool followUp)
   //uint16_t offs = SEG_OFFSET;
   //next value to be added has index: udpOut[offs + 0]
 
-  IPAddress broadcastIp;
-  broadcastIp = ~uint32_t(Network.subnetMask()) | uint32_t(Network.gatewayIP());
-
-  notifierUdp.beginPacket(broadcastIp, udpPort);
-  notifierUdp.write(udpOut, WLEDPACKETSIZE);
-  notifierUdp.endPacket();
+  sendSyncPacket(udpOut, WLEDPACKETSIZE);
   notificationSentCallMode = callMode;
   notificationSentTime = millis();
   notificationTwoRequired = (followUp)? false:notifyTwice;
 }
 
+static uint32_t deltaGeneration = 0;                     //incremented with every notification, repeated by the follow-up
+static WS2812FX::Segment deltaSentSegs[MAX_NUM_SEGMENTS]; //segment state of the last notification
+static IPAddress deltaSenderIP;                           //receiver: sender of the last applied delta packet
+static uint32_t deltaLastGeneration = 0;
+static bool deltaKeyframeDue = false;                     //the last notification was a delta, see handleNotifications()
+
+static inline void writeUint32BE(byte* p, uint32_t v)
+{
+  p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static inline uint32_t readUint32BE(const byte* p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+//header: type, call mode, version, generation (4), sync groups, flags, bri, transition (2), effect time (4),
+//time source, unix time (4), ms (2), nightlight, nightlight minutes, main segment, segment count
+//each segment: id, SEG_DIFFERS_* mask and the fields of the set bits in the order bounds, grouping/spacing/offset,
+//opacity, options, effect/speed/intensity/palette, colors/CCT
+void sendDeltaNotification(byte callMode, bool followUp, bool keyframe)
+{
+  if (!followUp) deltaGeneration++;
+  bool full = keyframe || followUp || deltaGeneration % UDP_DELTA_KEYFRAME == 1; //the follow-up is for receivers that missed the first packet
+  deltaKeyframeDue = !full;
+
+  byte udpOut[UDP_DELTA_HEADER + MAX_NUM_SEGMENTS * UDP_DELTA_SEG_MAX];
+  udpOut[0] = UDP_DELTA_PACKET;
+  udpOut[1] = callMode;
+  udpOut[2] = UDP_DELTA_VERSION;
+  writeUint32BE(udpOut + 3, deltaGeneration);
+  udpOut[7] = syncGroups;
+  udpOut[8] = (followUp ? UDP_DELTA_FOLLOWUP : 0) | (full ? UDP_DELTA_FULL : 0);
+  udpOut[9] = bri;
+  udpOut[10] = transitionDelay >> 8;
+  udpOut[11] = transitionDelay & 0xFF;
+  writeUint32BE(udpOut + 12, millis() + strip.timebase);
+  Toki::Time tm = toki.getTime();
+  udpOut[16] = toki.getTimeSource();
+  writeUint32BE(udpOut + 17, tm.sec);
+  udpOut[21] = tm.ms >> 8;
+  udpOut[22] = tm.ms & 0xFF;
+  udpOut[23] = nightlightActive;
+  udpOut[24] = nightlightDelayMins;
+  udpOut[25] = strip.getMainSegmentId();
+
+  uint16_t ofs = UDP_DELTA_HEADER;
+  uint8_t numSegs = 0;
+  for (uint8_t i = 0; i < strip.getMaxSegments(); i++) {
+    WS2812FX::Segment &seg = strip.getSegment(i);
+    uint8_t d = full ? 0xFF : seg.differs(deltaSentSegs[i]);
+    if (!d) continue;
+    deltaSentSegs[i] = seg;
+    numSegs++;
+    udpOut[ofs++] = i;
+    udpOut[ofs++] = d;
+    if (d & SEG_DIFFERS_BOUNDS) {
+      udpOut[ofs++] = seg.start >> 8; udpOut[ofs++] = seg.start & 0xFF;
+      udpOut[ofs++] = seg.stop >> 8;  udpOut[ofs++] = seg.stop & 0xFF;
+    }
+    if (d & SEG_DIFFERS_GSO) {
+      udpOut[ofs++] = seg.grouping;
+      udpOut[ofs++] = seg.spacing;
+      udpOut[ofs++] = seg.offset >> 8; udpOut[ofs++] = seg.offset & 0xFF;
+    }
+    if (d & SEG_DIFFERS_BRI) udpOut[ofs++] = seg.opacity;
+    if (d & (SEG_DIFFERS_OPT | SEG_DIFFERS_SEL)) udpOut[ofs++] = seg.options & 0x0F; //only take into account mirrored, selected, on, reversed
+    if (d & SEG_DIFFERS_FX) {
+      udpOut[ofs++] = seg.mode;
+      udpOut[ofs++] = seg.speed;
+      udpOut[ofs++] = seg.intensity;
+      udpOut[ofs++] = seg.palette;
+    }
+    if (d & SEG_DIFFERS_COL) {
+      for (uint8_t c = 0; c < NUM_COLORS; c++) writeUint32BE(udpOut + ofs + c*4, seg.colors[c]);
+      ofs += NUM_COLORS * 4;
+      udpOut[ofs++] = seg.cct;
+    }
+  }
+  udpOut[26] = numSegs;
+
+  sendSyncPacket(udpOut, ofs);
+}
+
+//apply a delta sync packet, only fields that differ from the local state are changed
+static void handleDeltaNotification(const byte* udpIn, uint16_t len, IPAddress sender)
+{
+  if (len < UDP_DELTA_HEADER || udpIn[2] != UDP_DELTA_VERSION) return;
+  if (!(receiveGroups & udpIn[7])) return;
+
+  uint32_t generation = readUint32BE(udpIn + 3);
+  if (sender == deltaSenderIP) {
+    if (generation == deltaLastGeneration) return; //duplicate, e.g. the follow-up
+    //older packets are stale, unless they carry the full state (sender restarted its counter)
+    if ((int32_t)(generation - deltaLastGeneration) < 0 && !(udpIn[8] & UDP_DELTA_FULL)) return;
+  }
+  deltaSenderIP = sender;
+  deltaLastGeneration = generation;
+
+  bool someSel = (receiveNotificationBrightness || receiveNotificationColor || receiveNotificationEffects);
+  bool applyEffects = (receiveNotificationEffects || !someSel);
+  bool applyColors = (receiveNotificationColor || !someSel);
+  bool changed = false;
+
+  uint16_t ofs = UDP_DELTA_HEADER;
+  for (uint8_t n = 0; n < udpIn[26]; n++) {
+    if (ofs + 2 > len) break;
+    uint8_t id = udpIn[ofs++];
+    uint8_t d = udpIn[ofs++];
+    const byte* bounds = nullptr, *gso = nullptr, *opacity = nullptr, *options = nullptr, *fx = nullptr, *col = nullptr;
+    if (d & SEG_DIFFERS_BOUNDS)                  { bounds  = udpIn + ofs; ofs += 4; }
+    if (d & SEG_DIFFERS_GSO)                     { gso     = udpIn + ofs; ofs += 4; }
+    if (d & SEG_DIFFERS_BRI)                     { opacity = udpIn + ofs; ofs++; }
+    if (d & (SEG_DIFFERS_OPT | SEG_DIFFERS_SEL)) { options = udpIn + ofs; ofs++; }
+    if (d & SEG_DIFFERS_FX)                      { fx      = udpIn + ofs; ofs += 4; }
+    if (d & SEG_DIFFERS_COL)                     { col     = udpIn + ofs; ofs += NUM_COLORS * 4 +1; }
+    if (ofs > len) break; //truncated
+    if (id >= strip.getMaxSegments()) continue;
+
+    if (!receiveSegmentOptions && !receiveSegmentBounds) {
+      //simple sync: effect and colors of the sender's main segment apply to all selected segments
+      if (id != udpIn[25]) continue;
+      for (uint8_t i = 0; i < strip.getMaxSegments(); i++) {
+        WS2812FX::Segment& seg = strip.getSegment(i);
+        if (!seg.isActive() || !seg.isSelected()) continue;
+        if (fx && applyEffects && (seg.mode != fx[0] || seg.speed != fx[1] || seg.intensity != fx[2] || seg.palette != fx[3])) {
+          if (currentPlaylist >= 0) unloadPlaylist();
+          if (fx[0] < strip.getModeCount()) strip.setMode(i, fx[0]);
+          seg.speed = fx[1];
+          seg.intensity = fx[2];
+          if (fx[3] < strip.getPaletteCount()) seg.palette = fx[3];
+          changed = true;
+        }
+        if (col && applyColors) {
+          for (uint8_t c = 0; c < NUM_COLORS; c++) changed |= seg.setColor(c, readUint32BE(col + c*4), i);
+          if (seg.cct != col[NUM_COLORS * 4]) { seg.setCCT(col[NUM_COLORS * 4], i); changed = true; }
+        }
+      }
+      continue;
+    }
+
+    WS2812FX::Segment& seg = strip.getSegment(id);
+    uint16_t start = seg.start, stop = seg.stop, offset = seg.offset;
+    uint8_t grouping = seg.grouping, spacing = seg.spacing;
+    if (bounds && receiveSegmentBounds) {
+      start = (bounds[0] << 8) | bounds[1];
+      stop  = (bounds[2] << 8) | bounds[3];
+    }
+    if (gso) {
+      if (receiveSegmentOptions) { grouping = gso[0]; spacing = gso[1]; }
+      if (receiveSegmentBounds) offset = (gso[2] << 8) | gso[3];
+    }
+    //setSegment() also properly resets segments
+    if (start != seg.start || stop != seg.stop || grouping != seg.grouping || spacing != seg.spacing || offset != seg.offset) {
+      strip.setSegment(id, start, stop, grouping, spacing, offset);
+      changed = true;
+    }
+    if (!receiveSegmentOptions) continue;
+
+    if (opacity && seg.opacity != opacity[0]) {
+      seg.setOpacity(opacity[0], id);
+      changed = true;
+    }
+    if (options && (seg.options & 0x0F) != options[0]) {
+      for (uint8_t j = 0; j < 4; j++) seg.setOption(j, (options[0] >> j) & 0x01, id); //only take into account mirrored, selected, on, reversed
+      changed = true;
+    }
+    if (fx && applyEffects && (seg.mode != fx[0] || seg.speed != fx[1] || seg.intensity != fx[2] || seg.palette != fx[3])) {
+      if (currentPlaylist >= 0) unloadPlaylist();
+      strip.setMode(id, fx[0]);
+      seg.speed     = fx[1];
+      seg.intensity = fx[2];
+      if (fx[3] < strip.getPaletteCount()) seg.palette = fx[3];
+      changed = true;
+    }
+    if (col && applyColors) {
+      for (uint8_t c = 0; c < NUM_COLORS; c++) changed |= seg.setColor(c, readUint32BE(col + c*4), id);
+      if (seg.cct != col[NUM_COLORS * 4]) { seg.setCCT(col[NUM_COLORS * 4], id); changed = true; }
+    }
+  }
+
+  if (applyEffects && !isTimeSynced()) { //node time sync keeps the timebase aligned already
+    strip.timebase = readUint32BE(udpIn + 12) + PRESUMED_NETWORK_DELAY - millis();
+  }
+
+  //adjust system time, but only if sender is more accurate than self
+  if (udpIn[16] > toki.getTimeSource()) {
+    Toki::Time tm;
+    tm.sec = readUint32BE(udpIn + 17);
+    tm.ms = (udpIn[21] << 8) | udpIn[22];
+    toki.adjust(tm, PRESUMED_NETWORK_DELAY); //adjust trivially for network delay
+    uint8_t ts = TOKI_TS_UDP;
+    if (udpIn[16] > 99) ts = TOKI_TS_UDP_NTP;
+    else if (udpIn[16] >= TOKI_TS_SEC) ts = TOKI_TS_UDP_SEC;
+    toki.setTime(tm, ts);
+  }
+
+  transitionDelayTemp = (udpIn[10] << 8) | udpIn[11];
+  if (nightlightActive != udpIn[23] || (udpIn[23] && nightlightDelayMins != udpIn[24])) {
+    nightlightActive = udpIn[23];
+    if (nightlightActive) nightlightDelayMins = udpIn[24];
+    changed = true;
+  }
+  if ((receiveNotificationBrightness || !someSel) && bri != udpIn[9]) {
+    bri = udpIn[9];
+    changed = true;
+  }
+  if (!changed) return; //nothing to apply, avoid transitions and notifications
+  stateChanged = true;
+  stateUpdated(CALL_MODE_NOTIFICATION);
+}
+
 void realtimeLock(uint32_t timeoutMs, byte md)
 {
+  strip.lockRender(); //the render task must not draw over the realtime pixels
   if (!realtimeMode && !realtimeOverride){
     uint16_t totalLen = strip.getLengthTotal();
     for (uint16_t i = 0; i < totalLen; i++)
@@ -159,6 +435,7 @@ void realtimeLock(uint32_t timeoutMs, byte md)
 
   if (arlsForceMaxBri && !realtimeOverride) strip.setBrightness(scaledBri(255));
   if (md == REALTIME_MODE_GENERIC) strip.show();
+  strip.unlockRender();
 }
 
 
@@ -180,29 +457,46 @@ void handleNotifications()
   if(udpConnected && notificationTwoRequired && millis()-notificationSentTime > 250){
     notify(notificationSentCallMode,true);
   }
+  //the last change went out as delta only, send the full state once no further changes follow
+  //so receivers that missed a delta do not stay out of sync until the next change
+  if (udpConnected && syncDelta && deltaKeyframeDue && millis()-notificationSentTime > UDP_DELTA_IDLE_KEYFRAME) {
+    strip.lockRender();
+    sendDeltaNotification(notificationSentCallMode, false, true);
+    strip.unlockRender();
+    notificationSentTime = millis();
+  }
   
+  handleE131Frame();
+  handleRealtimeBuffer();
   if (e131NewData && millis() - strip.getLastShow() > 15)
   {
     e131NewData = false;
     strip.show();
   }
+  handleDDPQuery();
 
   //unlock strip when realtime UDP times out
   if (realtimeMode && millis() > realtimeTimeout)
   {
     if (realtimeOverride == REALTIME_OVERRIDE_ONCE) realtimeOverride = REALTIME_OVERRIDE_NONE;
+    strip.lockRender();
     strip.setBrightness(scaledBri(bri));
     realtimeMode = REALTIME_MODE_INACTIVE;
+    strip.unlockRender();
     realtimeIP[0] = 0;
   }
 
   //receive UDP notifications
   if (!udpConnected) return;
     
+  handleTimeSync();
+
   bool isSupp = false;
+  uint32_t rxTime = 0;
   uint16_t packetSize = notifierUdp.parsePacket();
   if (!packetSize && udp2Connected) {
     packetSize = notifier2Udp.parsePacket();
+    rxTime = micros();
     isSupp = true;
   }
 
@@ -216,16 +510,12 @@ void handleNotifications()
       DEBUG_PRINTLN(rgbUdp.remoteIP());
       uint8_t lbuf[packetSize];
       rgbUdp.read(lbuf, packetSize);
+      uint32_t cycles = ESP.getCycleCount();
       realtimeLock(realtimeTimeoutMs, REALTIME_MODE_HYPERION);
       if (realtimeOverride) return;
-      uint16_t id = 0;
-      uint16_t totalLen = strip.getLengthTotal();
-      for (uint16_t i = 0; i < packetSize -2; i += 3)
-      {
-        setRealtimePixel(id, lbuf[i], lbuf[i+1], lbuf[i+2], 0);
-        id++; if (id >= totalLen) break;
-      }
-      strip.show();
+      setRealtimePixels(0, packetSize / 3, lbuf, RT_LAYOUT_RGB);
+      countRealtimePacket(RT_PROTO_HYPERION, -1, packetSize, 0, 0, cycles);
+      if (!queueRealtimeFrame()) strip.show();
       return;
     } 
   }
@@ -269,10 +559,30 @@ void handleNotifications()
         for (byte i=0; i<sizeof(uint32_t); i++)
           build |= udpIn[40+i]<<(8*i);
       it->second.build = build;
+      if (len >= 46) {
+        it->second.timeSource = udpIn[44];
+        it->second.timeSync = udpIn[45];
+      }
     }
     return;
   }
 
+  // node time sync
+  if (isSupp && udpIn[0] == 255 && len >= 4 && notifier2Udp.remoteIP() != localIP) {
+    if (handleTimeSyncPacket(udpIn, len, notifier2Udp.remoteIP(), rxTime)) return;
+  }
+
+  //delta sync, ignore if realtime packets active
+  if (udpIn[0] == UDP_DELTA_PACKET && !realtimeMode && receiveNotifications)
+  {
+    //ignore notification if received within a second after sending a notification ourselves
+    if (millis() - notificationSentTime < 1000) return;
+    strip.lockRender();
+    handleDeltaNotification(udpIn, len, isSupp ? notifier2Udp.remoteIP() : notifierUdp.remoteIP());
+    strip.unlockRender();
+    return;
+  }
+
   //wled notifier, ignore if realtime packets active
   if (udpIn[0] == 0 && !realtimeMode && receiveNotifications)
   {
@@ -290,6 +600,7 @@ void handleNotifications()
     } else if (!(receiveGroups & udpIn[36])) return;
     
     bool someSel = (receiveNotificationBrightness || receiveNotificationColor || receiveNotificationEffects);
+    strip.lockRender(); //changes segments directly
 
     //apply colors from notification to main segment, only if not syncing full segments
     if ((receiveNotificationColor || !someSel) && (version < 11 || !receiveSegmentOptions)) {
@@ -367,7 +678,7 @@ void handleNotifications()
         stateChanged = true;
       }
 
-      if (applyEffects && version > 5) {
+      if (applyEffects && version > 5 && !isTimeSynced()) { //node time sync keeps the timebase aligned already
         uint32_t t = (udpIn[25] << 24) | (udpIn[26] << 16) | (udpIn[27] << 8) | (udpIn[28]);
         t += PRESUMED_NETWORK_DELAY; //adjust trivially for network delay
         t -= millis();
@@ -410,6 +721,7 @@ void handleNotifications()
     
     if (receiveNotificationBrightness || !someSel) bri = udpIn[2];
     stateUpdated(CALL_MODE_NOTIFICATION);
+    strip.unlockRender();
     return;
   }
 
@@ -426,6 +738,7 @@ void handleNotifications()
     }
     if (tpmType != 0xda) return; //return if notTPM2.NET data
 
+    uint32_t cycles = ESP.getCycleCount();
     realtimeIP = (isSupp) ? notifier2Udp.remoteIP() : notifierUdp.remoteIP();
     realtimeLock(realtimeTimeoutMs, REALTIME_MODE_TPM2NET);
     if (realtimeOverride) return;
@@ -436,20 +749,12 @@ void handleNotifications()
     byte numPackets = udpIn[5];
 
     uint16_t id = (tpmPayloadFrameSize/3)*(packetNum-1); //start LED
-    uint16_t totalLen = strip.getLengthTotal();
-    for (uint16_t i = 6; i < tpmPayloadFrameSize + 4; i += 3)
-    {
-      if (id < totalLen)
-      {
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], 0);
-        id++;
-      }
-      else break;
-    }
+    setRealtimePixels(id, tpmPayloadFrameSize / 3, udpIn + 6, RT_LAYOUT_RGB);
+    countRealtimePacket(RT_PROTO_TPM2NET, -1, (packetSize > 7) ? packetSize - 7 : 0, packetNum, numPackets, cycles); //6 byte header, end byte
     if (tpmPacketCount == numPackets) //reset packet count and show if all packets were received
     {
       tpmPacketCount = 0;
-      strip.show();
+      if (!queueRealtimeFrame()) strip.show();
     }
     return;
   }
@@ -457,6 +762,7 @@ void handleNotifications()
   //UDP realtime: 1 warls 2 drgb 3 drgbw
   if (udpIn[0] > 0 && udpIn[0] < 5)
   {
+    uint32_t cycles = ESP.getCycleCount();
     realtimeIP = (isSupp) ? notifier2Udp.remoteIP() : notifierUdp.remoteIP();
     DEBUG_PRINTLN(realtimeIP);
     if (packetSize < 2) return;
@@ -470,51 +776,32 @@ void handleNotifications()
     }
     if (realtimeOverride) return;
 
-    uint16_t totalLen = strip.getLengthTotal();
     if (udpIn[0] == 1) //warls
     {
+      uint16_t frameLen;
+      uint32_t* frame = getRealtimeFrame(frameLen); //jitter buffer, locked once for the packet
       for (uint16_t i = 2; i < packetSize -3; i += 4)
       {
-        setRealtimePixel(udpIn[i], udpIn[i+1], udpIn[i+2], udpIn[i+3], 0);
+        setRealtimePixel(frame, frameLen, udpIn[i], udpIn[i+1], udpIn[i+2], udpIn[i+3], 0);
       }
+      if (frame) releaseRealtimeFrame();
     } else if (udpIn[0] == 2) //drgb
     {
-      uint16_t id = 0;
-      for (uint16_t i = 2; i < packetSize -2; i += 3)
-      {
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], 0);
-
-        id++; if (id >= totalLen) break;
-      }
+      setRealtimePixels(0, (packetSize - 2) / 3, udpIn + 2, RT_LAYOUT_RGB);
     } else if (udpIn[0] == 3) //drgbw
     {
-      uint16_t id = 0;
-      for (uint16_t i = 2; i < packetSize -3; i += 4)
-      {
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], udpIn[i+3]);
-        
-        id++; if (id >= totalLen) break;
-      }
+      setRealtimePixels(0, (packetSize - 2) / 4, udpIn + 2, RT_LAYOUT_RGBW);
     } else if (udpIn[0] == 4) //dnrgb
     {
       uint16_t id = ((udpIn[3] << 0) & 0xFF) + ((udpIn[2] << 8) & 0xFF00);
-      for (uint16_t i = 4; i < packetSize -2; i += 3)
-      {
-        if (id >= totalLen) break;
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], 0);
-        id++;
-      }
+      if (packetSize > 4) setRealtimePixels(id, (packetSize - 4) / 3, udpIn + 4, RT_LAYOUT_RGB);
     } else if (udpIn[0] == 5) //dnrgbw
     {
       uint16_t id = ((udpIn[3] << 0) & 0xFF) + ((udpIn[2] << 8) & 0xFF00);
-      for (uint16_t i = 4; i < packetSize -2; i += 4)
-      {
-        if (id >= totalLen) break;
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], udpIn[i+3]);
-        id++;
-      }
+      if (packetSize > 4) setRealtimePixels(id, (packetSize - 4) / 4, udpIn + 4, RT_LAYOUT_RGBW);
     }
-    strip.show();
+    countRealtimePacket(RT_PROTO_UDP, -1, packetSize - 2, 0, 0, cycles);
+    if (!queueRealtimeFrame()) strip.show();
     return;
   }
 
@@ -535,19 +822,68 @@ void handleNotifications()
 
 
 void setRealtimePixel(uint16_t i, byte r, byte g, byte b, byte w)
+{
+  uint16_t frameLen;
+  uint32_t* frame = getRealtimeFrame(frameLen); //jitter buffer
+  setRealtimePixel(frame, frameLen, i, r, g, b, w);
+  if (frame) releaseRealtimeFrame();
+}
+
+//for packets setting many pixels, frame is taken once per packet with getRealtimeFrame() (nullptr: write to the strip)
+void setRealtimePixel(uint32_t* frame, uint16_t frameLen, uint16_t i, byte r, byte g, byte b, byte w)
 {
   uint16_t pix = i + arlsOffset;
   if (pix < strip.getLengthTotal())
   {
     if (!arlsDisableGammaCorrection && strip.gammaCorrectCol)
     {
-      strip.setPixelColor(pix, strip.gamma8(r), strip.gamma8(g), strip.gamma8(b), strip.gamma8(w));
+      r = strip.gamma8(r); g = strip.gamma8(g); b = strip.gamma8(b); w = strip.gamma8(w);
+    }
+    if (frame) {
+      if (pix < frameLen) frame[pix] = RGBW32(r, g, b, w);
     } else {
       strip.setPixelColor(pix, r, g, b, w);
     }
   }
 }
 
+//same as setRealtimePixel() for count consecutive pixels, data holds 3 (RT_LAYOUT_RGB) or 4 (RT_LAYOUT_RGBW) bytes per pixel
+//range and gamma checks are done once, pixels are written to the busses in runs
+void setRealtimePixels(uint16_t start, uint16_t count, const uint8_t* data, byte layout)
+{
+  int32_t pix = start + arlsOffset;
+  int32_t totalLen = strip.getLengthTotal();
+  if (pix < 0) { //pixels before the start of the strip
+    if (-pix >= count) return;
+    count += pix;
+    data -= pix * ((layout == RT_LAYOUT_RGBW) ? 4 : 3);
+    pix = 0;
+  }
+  if (pix >= totalLen) return;
+  if (pix + count > totalLen) count = totalLen - pix;
+
+  const uint8_t channels = (layout == RT_LAYOUT_RGBW) ? 4 : 3;
+  const bool gamma = !arlsDisableGammaCorrection && strip.gammaCorrectCol;
+  uint16_t frameLen;
+  uint32_t* frame = getRealtimeFrame(frameLen); //jitter buffer, the frame is shown later
+  if (frame && pix + count > frameLen) count = (pix < frameLen) ? frameLen - pix : 0;
+  uint32_t span[32];
+  while (count) {
+    uint8_t n = (count > 32) ? 32 : count;
+    uint32_t* out = frame ? frame + pix : span;
+    for (uint8_t i = 0; i < n; i++) {
+      byte w = (channels == 4) ? data[3] : 0;
+      if (gamma) out[i] = RGBW32(strip.gamma8(data[0]), strip.gamma8(data[1]), strip.gamma8(data[2]), strip.gamma8(w));
+      else       out[i] = RGBW32(data[0], data[1], data[2], w);
+      data += channels;
+    }
+    if (!frame) strip.setPixelColors(pix, n, span);
+    pix += n;
+    count -= n;
+  }
+  if (frame) releaseRealtimeFrame();
+}
+
 /*********************************************************************************************\
    Refresh aging for remote units, drop if too old...
 \*********************************************************************************************/
@@ -588,10 +924,12 @@ void sendSysInfoUDP()
   // 38: 1 byte node type id
   // 39: 1 byte node id
   // 40: 4 byte version ID
-  // 44 bytes total
+  // 44: 1 byte toki time source
+  // 45: 1 byte node time sync enabled
+  // 46 bytes total
 
   // send my info to the world...
-  uint8_t data[44] = {0};
+  uint8_t data[46] = {0};
   data[0] = 255;
   data[1] = 1;
   
@@ -611,35 +949,153 @@ void sendSysInfoUDP()
   uint32_t build = VERSION;
   for (byte i=0; i<sizeof(uint32_t); i++)
     data[40+i] = (build>>(8*i)) & 0xFF;
+  data[44] = toki.getTimeSource();
+  data[45] = nodeTimeSync;
 
   IPAddress broadcastIP(255, 255, 255, 255);
-  notifier2Udp.beginPacket(broadcastIP, udpPort2);
+  notifier2Udp.beginPacket(syncMulticast ? SYNC_MULTICAST_IP(0) : broadcastIP, udpPort2);
   notifier2Udp.write(data, sizeof(data));
   notifier2Udp.endPacket();
 }
 
 
 /*********************************************************************************************\
- * Art-Net, DDP, E131 output - work in progress
+ * Art-Net, DDP, E131 output
 \*********************************************************************************************/
 
-#define DDP_HEADER_LEN 10
-#define DDP_SYNCPACKET_LEN 10
+#define E131_OUT_HEADER_LEN    126
+#define E131_OUT_SYNC_LEN       49
+#define ARTNET_OUT_HEADER_LEN   18
+#define ARTNET_SYNC_LEN         14
+#define DMX_OUT_CHANNELS       512
 
-#define DDP_FLAGS1_VER 0xc0  // version mask
-#define DDP_FLAGS1_VER1 0x40 // version=1
-#define DDP_FLAGS1_PUSH 0x01
-#define DDP_FLAGS1_QUERY 0x02
-#define DDP_FLAGS1_REPLY 0x04
-#define DDP_FLAGS1_STORAGE 0x08
-#define DDP_FLAGS1_TIME 0x10
+// E1.31 and Art-Net packets are built once, per universe only the universe, sequence, length and DMX data are rewritten
+static uint8_t* e131OutPacket = nullptr;
+static uint8_t* artnetOutPacket = nullptr;
+static uint8_t e131OutSyncSequence = 0;
 
-#define DDP_ID_DISPLAY 1
-#define DDP_ID_CONFIG 250
-#define DDP_ID_STATUS 251
+static inline void writeUint16BE(uint8_t* p, uint16_t v) {
+  p[0] = v >> 8;
+  p[1] = v & 0xFF;
+}
 
-// 1440 channels per packet
-#define DDP_CHANNELS_PER_PACKET 1440 // 480 leds
+static bool buildE131OutPacket() {
+  if (e131OutPacket) return true;
+  e131OutPacket = (uint8_t*) malloc(E131_OUT_HEADER_LEN + DMX_OUT_CHANNELS);
+  if (e131OutPacket == nullptr) return false;
+  uint8_t* p = e131OutPacket;
+  memset(p, 0, E131_OUT_HEADER_LEN);
+  // root layer
+  p[1] = 0x10;                            // preamble size
+  memcpy_P(p + 4, PSTR("ASC-E1.17"), 9);  // ACN packet identifier, zero padded to 12 bytes
+  p[21] = 0x04;                           // VECTOR_ROOT_E131_DATA
+  memcpy_P(p + 22, PSTR("WLED-sACN-"), 10); // CID, unique per device: prefix + MAC
+  WiFi.macAddress(p + 32);
+  // framing layer
+  p[43] = 0x02;                           // VECTOR_E131_DATA_PACKET
+  // DMP layer
+  p[117] = 0x02;                          // VECTOR_DMP_SET_PROPERTY
+  p[118] = 0xA1;                          // address & data type
+  p[122] = 0x01;                          // address increment
+  return true;
+}
+
+static void setE131OutHeader(uint16_t universe, uint16_t channels, uint8_t seq) {
+  uint8_t* p = e131OutPacket;
+  uint16_t len = E131_OUT_HEADER_LEN + channels;
+  writeUint16BE(p +  16, 0x7000 | (len -  16)); // root layer flags & length
+  writeUint16BE(p +  38, 0x7000 | (len -  38)); // framing layer flags & length
+  strncpy((char*)p + 44, serverDescription, 64); // source name
+  p[108] = e131OutPriority;
+  writeUint16BE(p + 109, e131OutSyncUniverse);  // synchronization address, receivers wait for a sync packet if set
+  p[111] = seq;
+  writeUint16BE(p + 113, universe);
+  writeUint16BE(p + 115, 0x7000 | (len - 115)); // DMP layer flags & length
+  writeUint16BE(p + 123, channels + 1);         // property value count, including start code
+}
+
+static bool buildArtnetOutPacket() {
+  if (artnetOutPacket) return true;
+  artnetOutPacket = (uint8_t*) malloc(ARTNET_OUT_HEADER_LEN + DMX_OUT_CHANNELS);
+  if (artnetOutPacket == nullptr) return false;
+  uint8_t* p = artnetOutPacket;
+  memset(p, 0, ARTNET_OUT_HEADER_LEN);
+  memcpy_P(p, PSTR("Art-Net"), 8);        // ID, including terminating zero
+  p[9] = 0x50;                            // OpDmx (0x5000), little endian
+  p[11] = 14;                             // protocol version
+  return true;
+}
+
+static void setArtnetOutHeader(uint16_t universe, uint16_t channels, uint8_t seq) {
+  uint8_t* p = artnetOutPacket;
+  p[12] = seq;
+  p[14] = universe & 0xFF;                // SubUni
+  p[15] = (universe >> 8) & 0x7F;         // Net
+  writeUint16BE(p + 16, channels);
+}
+
+// sent after all universes of a frame so the receiver outputs them at the same time
+static bool sendRealtimeSync(WiFiUDP &udp, uint8_t type, IPAddress client) {
+  uint8_t sync[E131_OUT_SYNC_LEN] = {0};
+  size_t len;
+  if (type == 1) { // E1.31 universe synchronization packet
+    memcpy(sync, e131OutPacket, 38);      // preamble, ACN packet identifier and CID
+    writeUint16BE(sync + 16, 0x7000 | (E131_OUT_SYNC_LEN - 16));
+    sync[21] = 0x08;                      // VECTOR_ROOT_E131_EXTENDED
+    writeUint16BE(sync + 38, 0x7000 | (E131_OUT_SYNC_LEN - 38));
+    sync[43] = 0x01;                      // VECTOR_E131_EXTENDED_SYNCHRONIZATION
+    sync[44] = e131OutSyncSequence++;
+    writeUint16BE(sync + 45, e131OutSyncUniverse);
+    len = E131_OUT_SYNC_LEN;
+  } else {         // ArtSync
+    memcpy_P(sync, PSTR("Art-Net"), 8);
+    sync[9] = 0x52;                       // OpSync (0x5200), little endian
+    sync[11] = 14;
+    len = ARTNET_SYNC_LEN;
+  }
+  if (!udp.beginPacket(client, (type == 1) ? E131_DEFAULT_PORT : ARTNET_DEFAULT_PORT)) return false;
+  udp.write(sync, len);
+  return udp.endPacket();
+}
+
+// DDP header template, only flags, sequence, data offset and length are rewritten per packet
+static const uint8_t ddpHeader[DDP_HEADER_LEN] PROGMEM = {DDP_FLAGS1_VER1, 0, 0, DDP_ID_DISPLAY, 0, 0, 0, 0, 0, 0};
+static uint8_t* ddpOutPacket = nullptr;
+
+static bool buildDdpOutPacket() {
+  if (ddpOutPacket) return true;
+  ddpOutPacket = (uint8_t*) malloc(DDP_HEADER_LEN + DDP_CHANNELS_PER_PACKET);
+  if (ddpOutPacket == nullptr) return false;
+  memcpy_P(ddpOutPacket, ddpHeader, DDP_HEADER_LEN);
+  return true;
+}
+
+// copies one packet worth of pixel channels with brightness applied, RGBW input is sent as RGB
+static void scaleRealtimeData(uint8_t* dest, const uint8_t* src, uint16_t channels, uint8_t bri, bool skipW) {
+  if (!skipW) {
+    if (bri == 255) memcpy(dest, src, channels);
+    else for (uint16_t c = 0; c < channels; c++) dest[c] = scale8(src[c], bri);
+    return;
+  }
+  for (uint16_t c = 0; c < channels; c += 3, src += 4) {
+    dest[c]   = scale8(src[0], bri);
+    dest[c+1] = scale8(src[1], bri);
+    dest[c+2] = scale8(src[2], bri);
+  }
+}
+
+static bool sendRealtimePacket(WiFiUDP &udp, IPAddress client, uint16_t port, const uint8_t* packet, size_t len) {
+  if (!udp.beginPacket(client, port)) {
+    DEBUG_PRINTLN(F("WiFiUDP.beginPacket returned an error"));
+    return false;
+  }
+  udp.write(packet, len);
+  if (!udp.endPacket()) {
+    DEBUG_PRINTLN(F("WiFiUDP.endPacket returned an error"));
+    return false;
+  }
+  return true;
+}
 
 //
 // Send real time UDP updates to the specified client
@@ -649,40 +1105,42 @@ void sendSysInfoUDP()
 // length - the number of pixels
 // buffer - a buffer of at least length*4 bytes long
 // isRGBW - true if the buffer contains 4 components per pixel
+// udp    - socket to send with, kept by the caller so it is not reopened every frame (optional)
+// stats  - packet counters and time spent building packets (optional)
+// universe - first E1.31/ArtNet universe, the following pixels continue in the next universes
+// sequence - E1.31/ArtNet sequence number of the output, counted once per frame for all its universes (optional)
 
 uint8_t sequenceNumber = 0; // this needs to be shared across all outputs
 
-uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, uint8_t *buffer, uint8_t bri, bool isRGBW)  {
+uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, uint8_t *buffer, uint8_t bri, bool isRGBW, WiFiUDP* udp, RealtimeOutStats* stats, uint16_t universe, uint8_t* sequence)  {
   if (!interfacesInited) return 1;  // network not initialised
 
-  WiFiUDP ddpUdp;
+  static WiFiUDP sharedUdp;
+  if (udp == nullptr) udp = &sharedUdp;
+  uint32_t buildTime = 0; // us spent on headers and brightness scaling
+  uint16_t packets = 0;
+  uint8_t result = 0;
 
   switch (type) {
     case 0: // DDP
     {
+      if (!buildDdpOutPacket()) return 1; // out of memory
+
       // calclate the number of UDP packets we need to send
-      uint16_t channelCount = length * 3; // 1 channel for every R,G,B value
-      uint16_t packetCount = channelCount / DDP_CHANNELS_PER_PACKET;
-      if (channelCount % DDP_CHANNELS_PER_PACKET) {
-        packetCount++;
-      }
+      uint32_t channelCount = length * 3; // 1 channel for every R,G,B value
+      uint16_t packetCount = (channelCount + DDP_CHANNELS_PER_PACKET -1) / DDP_CHANNELS_PER_PACKET;
 
       // there are 3 channels per RGB pixel
       uint32_t channel = 0; // TODO: allow specifying the start channel
-      // the current position in the buffer 
-      uint16_t bufferOffset = 0;
+      // the current position in the buffer
+      const uint8_t* src = buffer;
 
       for (uint16_t currentPacket = 0; currentPacket < packetCount; currentPacket++) {
+        uint32_t start = micros();
         if (sequenceNumber > 15) sequenceNumber = 0;
 
-        if (!ddpUdp.beginPacket(client, DDP_DEFAULT_PORT)) {  // port defined in ESPAsyncE131.h
-          DEBUG_PRINTLN(F("WiFiUDP.beginPacket returned an error"));
-          return 1; // problem
-        }
-
         // the amount of data is AFTER the header in the current packet
         uint16_t packetSize = DDP_CHANNELS_PER_PACKET;
-
         uint8_t flags = DDP_FLAGS1_VER1;
         if (currentPacket == (packetCount - 1)) {
           // last packet, set the push flag
@@ -693,45 +1151,80 @@ uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, uint8
           }
         }
 
-        // write the header
-        /*0*/ddpUdp.write(flags);
-        /*1*/ddpUdp.write(sequenceNumber++ & 0x0F); // sequence may be unnecessary unless we are sending twice (as requested in Sync settings)
-        /*2*/ddpUdp.write(0);
-        /*3*/ddpUdp.write(DDP_ID_DISPLAY);
+        ddpOutPacket[0] = flags;
+        ddpOutPacket[1] = sequenceNumber++ & 0x0F; // sequence may be unnecessary unless we are sending twice (as requested in Sync settings)
         // data offset in bytes, 32-bit number, MSB first
-        /*4*/ddpUdp.write(0xFF & (channel >> 24));
-        /*5*/ddpUdp.write(0xFF & (channel >> 16));
-        /*6*/ddpUdp.write(0xFF & (channel >>  8));
-        /*7*/ddpUdp.write(0xFF & (channel      ));
+        writeUint16BE(ddpOutPacket + 4, channel >> 16);
+        writeUint16BE(ddpOutPacket + 6, channel & 0xFFFF);
         // data length in bytes, 16-bit number, MSB first
-        /*8*/ddpUdp.write(0xFF & (packetSize >> 8));
-        /*9*/ddpUdp.write(0xFF & (packetSize     ));
-
-        // write the colors, the write write(const uint8_t *buffer, size_t size) 
-        // function is just a loop internally too
-        for (uint16_t i = 0; i < packetSize; i += 3) {
-          ddpUdp.write(scale8(buffer[bufferOffset++], bri)); // R
-          ddpUdp.write(scale8(buffer[bufferOffset++], bri)); // G
-          ddpUdp.write(scale8(buffer[bufferOffset++], bri)); // B
-          if (isRGBW) bufferOffset++;
-        }
+        writeUint16BE(ddpOutPacket + 8, packetSize);
 
-        if (!ddpUdp.endPacket()) {            
-          DEBUG_PRINTLN(F("WiFiUDP.endPacket returned an error"));
-          return 1; // problem
-        }
+        scaleRealtimeData(ddpOutPacket + DDP_HEADER_LEN, src, packetSize, bri, isRGBW);
+        src += isRGBW ? (packetSize / 3) * 4 : packetSize;
+        buildTime += micros() - start;
 
+        if (!sendRealtimePacket(*udp, client, DDP_DEFAULT_PORT, ddpOutPacket, DDP_HEADER_LEN + packetSize)) { // port defined in ESPAsyncE131.h
+          result = 1; // problem
+          break;
+        }
+        packets++;
         channel += packetSize;
       }
     } break;
 
     case 1: //E1.31
-    {
-    } break;
-
     case 2: //ArtNet
     {
+      bool isE131 = (type == 1);
+      if (!(isE131 ? buildE131OutPacket() : buildArtnetOutPacket())) return 1; // out of memory
+      uint8_t* packet = isE131 ? e131OutPacket : artnetOutPacket;
+      uint8_t headerLen = isE131 ? E131_OUT_HEADER_LEN : ARTNET_OUT_HEADER_LEN;
+      uint8_t* dmxData = packet + headerLen;
+      uint16_t port = isE131 ? E131_DEFAULT_PORT : ARTNET_DEFAULT_PORT;
+
+      // pixels are not split across universes, 170 RGB or 128 RGBW pixels per universe
+      uint8_t channelsPerPixel = isRGBW ? 4 : 3;
+      uint16_t pixelsPerUniverse = DMX_OUT_CHANNELS / channelsPerPixel;
+      if (isE131 && universe == 0) universe = 1; // sACN universes start at 1
+      static uint8_t sharedSequence = 0;
+      if (sequence == nullptr) sequence = &sharedSequence;
+      uint8_t seq = ++*sequence;
+      if (!isE131 && seq == 0) seq = *sequence = 1; // 0 disables sequence checking on ArtNet receivers
+      const uint8_t* src = buffer;
+
+      for (uint16_t pixel = 0; pixel < length; pixel += pixelsPerUniverse, universe++) {
+        uint32_t start = micros();
+        uint16_t channels = ((length - pixel < pixelsPerUniverse) ? length - pixel : pixelsPerUniverse) * channelsPerPixel;
+        scaleRealtimeData(dmxData, src, channels, bri, false);
+        src += channels;
+        if (isE131) {
+          setE131OutHeader(universe, channels, seq);
+        } else {
+          if (channels & 1) dmxData[channels++] = 0; // Art-Net length must be even
+          setArtnetOutHeader(universe, channels, seq);
+        }
+        buildTime += micros() - start;
+
+        if (!sendRealtimePacket(*udp, client, port, packet, headerLen + channels)) {
+          result = 1; // problem
+          break;
+        }
+        packets++;
+      }
+
+      if (!result && e131OutSyncUniverse) {
+        if (sendRealtimeSync(*udp, type, client)) packets++;
+        else result = 1;
+      }
     } break;
   }
-  return 0;
+
+  if (stats) {
+    stats->frames++;
+    stats->packets += packets;
+    if (result) stats->errors++;
+    stats->buildTime = buildTime;
+    if (buildTime > stats->buildTimeMax) stats->buildTimeMax = buildTime;
+  }
+  return result;
 }
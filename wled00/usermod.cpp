@@ -23,6 +23,7 @@ void userConnected()
 }
 
 //loop. You can use "if (WLED_CONNECTED)" to check for successful connection
+//segment changes need strip.lockRender()/unlockRender() around them, don't access files while holding the lock
 void userLoop()
 {
   
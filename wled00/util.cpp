@@ -2,19 +2,44 @@
 #include "fcn_declare.h"
 #include "const.h"
 
+//JSON buffer lock statistics, wait times in us
+static uint32_t jsonLockCount = 0, jsonLockContended = 0, jsonLockFailed = 0;
+static uint64_t jsonLockWait = 0; //us, 32 bit would wrap after 71 minutes of waiting in total
+static uint32_t jsonLockWaitMax = 0;
+static uint8_t  jsonLockLastBlocker = 0; //module that held the lock when it was last contended
+
+static void countJSONBufferLock(uint32_t startUs, bool contended, uint8_t holder, bool failed)
+{
+  uint32_t wait = micros() - startUs;
+  jsonLockCount++;
+  if (contended) {
+    jsonLockContended++;
+    jsonLockLastBlocker = holder;
+  }
+  if (failed) jsonLockFailed++;
+  jsonLockWait += wait;
+  if (wait > jsonLockWaitMax) jsonLockWaitMax = wait;
+}
+
 //threading/network callback details: https://github.com/Aircoookie/WLED/pull/2336#discussion_r762276994
 bool requestJSONBufferLock(uint8_t module)
 {
   unsigned long now = millis();
+  uint32_t startUs = micros();
+  uint8_t holder = jsonBufferLock;
 
+  // the render lock is only taken where JSON is applied (deserializeState()), not while the buffer is held for file access
+  // do not wait here with the render lock held, the holder of the buffer may be waiting for it
   while (jsonBufferLock && millis()-now < 1000) delay(1); // wait for a second for buffer lock
 
   if (millis()-now >= 1000) {
     DEBUG_PRINT(F("ERROR: Locking JSON buffer failed! ("));
     DEBUG_PRINT(jsonBufferLock);
     DEBUG_PRINTLN(")");
+    countJSONBufferLock(startUs, true, holder, true);
     return false; // waiting time-outed
   }
+  countJSONBufferLock(startUs, holder, holder, false);
 
   jsonBufferLock = module ? module : 255;
   fileDoc = &doc;  // used for applying presets (presets.cpp)
@@ -33,6 +58,25 @@ void releaseJSONBufferLock()
 }
 
 
+void resetJSONBufferLockStats()
+{
+  jsonLockCount = jsonLockContended = jsonLockFailed = 0;
+  jsonLockWait = jsonLockWaitMax = 0;
+  jsonLockLastBlocker = 0;
+}
+
+//{"n":locks taken, "cont":had to wait, "fail":timed out, "wait":average us, "max":max us, "by":module that held it last}
+void serializeJSONBufferLockStats(JsonObject root)
+{
+  root["n"] = jsonLockCount;
+  root[F("cont")] = jsonLockContended;
+  root[F("fail")] = jsonLockFailed;
+  root[F("wait")] = jsonLockCount ? (uint32_t)(jsonLockWait / jsonLockCount) : 0;
+  root[F("max")] = jsonLockWaitMax;
+  root[F("by")] = jsonLockLastBlocker;
+}
+
+
 // extracts effect mode (or palette) name from names serialized string
 // caller must provide large enough buffer for name (incluing SR extensions)!
 uint8_t extractModeName(uint8_t mode, const char *src, char *dest, uint8_t maxLen)
@@ -118,42 +118,63 @@ void WiFiEvent(WiFiEvent_t event)
   }
 }
 
+#ifdef WLED_ENABLE_RENDER_TASK
+//renders effects instead of loop(), on the core loop() does not run on
+//code changing segments or busses takes the render lock, so a frame is never rendered from half applied state
+static void renderTask(void* parameter)
+{
+  for (;;) {
+    strip.lockRender();
+    bool render = (!realtimeMode || realtimeOverride) && (!offMode || strip.isOffRefreshRequired());
+    #ifdef WLED_ENABLE_FX_BENCHMARK
+    if (isFxBenchmarkRunning()) render = false;
+    #endif
+    if (render) strip.service(); //returns right away if no frame is due
+    strip.unlockRender();
+    vTaskDelay(1);
+  }
+}
+#endif
+
 void WLED::loop()
 {
   #ifdef WLED_DEBUG
   static unsigned long maxUsermodMillis = 0;
   #endif
-
-  handleTime();
-  handleIR();        // 2nd call to function needed for ESP32 to return valid results -- should be good for ESP8266, too
-  handleConnection();
-  handleSerial();
-  handleNotifications();
-  handleTransitions();
+  loopStart();
+
+  handleTime();          loopStage(LOOP_STAGE_TIME);
+  handleIR();            loopStage(LOOP_STAGE_IR); // 2nd call to function needed for ESP32 to return valid results -- should be good for ESP8266, too
+  handleConnection();    loopStage(LOOP_STAGE_CONNECTION);
+  handleSerial();        loopStage(LOOP_STAGE_SERIAL);
+  handleNotifications(); loopStage(LOOP_STAGE_NOTIFICATIONS);
+  handleTransitions();   loopStage(LOOP_STAGE_TRANSITIONS);
 #ifdef WLED_ENABLE_DMX
-  handleDMX();
+  handleDMX();           loopStage(LOOP_STAGE_DMX);
 #endif
-  userLoop();
+  //usermods run without the render lock, they take strip.lockRender() around their own segment changes
+  userLoop();            loopStage(LOOP_STAGE_USERLOOP);
 
   #ifdef WLED_DEBUG
   unsigned long usermodMillis = millis();
   #endif
   usermods.loop();
+  loopStage(LOOP_STAGE_USERMODS);
   #ifdef WLED_DEBUG
   usermodMillis = millis() - usermodMillis;
   if (usermodMillis > maxUsermodMillis) maxUsermodMillis = usermodMillis;
   #endif
 
-  yield();
-  handleIO();
-  handleIR();
-  handleAlexa();
+  yield();               loopStage(LOOP_STAGE_SYS);
+  handleIO();            loopStage(LOOP_STAGE_IO);
+  handleIR();            loopStage(LOOP_STAGE_IR);
+  handleAlexa();         loopStage(LOOP_STAGE_ALEXA);
 
   #if !defined(WLED_DISABLE_HOMEKIT) && defined(ARDUINO_ARCH_ESP32)
-  handleHomeKit();
+  handleHomeKit();       loopStage(LOOP_STAGE_HOMEKIT);
   #endif
 
-  yield();
+  yield();               loopStage(LOOP_STAGE_SYS);
 
   if (doReboot)
     reset();
@@ -161,6 +182,8 @@ void WLED::loop()
     closeFile();
     yield();
   }
+  handlePresetsCompaction();
+  loopStage(LOOP_STAGE_SYS);
 
   if (!realtimeMode || realtimeOverride)  // block stuff if WARLS/Adalight is enabled
   {
@@ -170,35 +193,53 @@ void WLED::loop()
     if (WLED_CONNECTED && aOtaEnabled)
       ArduinoOTA.handle();
 #endif
+    loopStage(LOOP_STAGE_OTA);
     handleNightlight();
-    handlePlaylist();
-    yield();
+    handlePlaylist();    loopStage(LOOP_STAGE_NIGHTLIGHT);
+    yield();             loopStage(LOOP_STAGE_SYS);
 
-    handleHue();
+    handleHue();         loopStage(LOOP_STAGE_HUE);
 #ifndef WLED_DISABLE_BLYNK
-    handleBlynk();
+    handleBlynk();       loopStage(LOOP_STAGE_BLYNK);
 #endif
 
-    yield();
+    yield();             loopStage(LOOP_STAGE_SYS);
 
+#ifdef WLED_ENABLE_RENDER_TASK
+  #ifdef WLED_ENABLE_FX_BENCHMARK
+    strip.lockRender();
+    handleFxBenchmark(); //the render task pauses while a benchmark is running
+    strip.unlockRender();
+  #endif
+#else
+    strip.lockRender();
+  #ifdef WLED_ENABLE_FX_BENCHMARK
+    if (!handleFxBenchmark()) //a running benchmark calls strip.service() itself
+  #endif
     if (!offMode || strip.isOffRefreshRequired())
       strip.service();
-#ifdef ESP8266
+  #ifdef ESP8266
     else if (!noWifiSleep)
       delay(1); //required to make sure ESP enters modem sleep (see #1184)
+  #endif
+    strip.unlockRender();
 #endif
+    loopStage(LOOP_STAGE_STRIP);
   }
   yield();
 #ifdef ESP8266
   MDNS.update();
 #endif
+  loopStage(LOOP_STAGE_SYS);
 
   //millis() rolls over every 50 days
   if (lastMqttReconnectAttempt > millis()) {
     rolloverMillis++;
     lastMqttReconnectAttempt = 0;
     ntpLastSyncTime = 0;
+    strip.lockRender();
     strip.restartRuntime();
+    strip.unlockRender();
   }
   if (millis() - lastMqttReconnectAttempt > 30000) {
     lastMqttReconnectAttempt = millis();
@@ -209,10 +250,12 @@ void WLED::loop()
     if (nodeBroadcastEnabled) sendSysInfoUDP();
     yield();
   }
+  loopStage(LOOP_STAGE_MQTT);
 
   //LED settings have been saved, re-init busses
   //This code block causes severe FPS drop on ESP32 with the original "if (busConfigs[0] != nullptr)" conditional. Investigate! 
   if (doInitBusses) {
+    strip.lockRender(); //busses and segments are replaced
     doInitBusses = false;
     DEBUG_PRINTLN(F("Re-init busses."));
     bool aligned = strip.checkSegmentAlignment(); //see if old segments match old bus(ses)
@@ -230,17 +273,19 @@ void WLED::loop()
     loadLedmap = 0;
     if (aligned) strip.makeAutoSegments();
     else strip.fixInvalidSegments();
+    strip.unlockRender();
     yield();
     serializeConfig();
   }
   if (loadLedmap >= 0) {
-    strip.deserializeMap(loadLedmap);
+    strip.deserializeMap(loadLedmap); //takes the render lock only to swap the map
     loadLedmap = -1;
   }
+  loopStage(LOOP_STAGE_BUSSES);
 
-  yield();
-  handleWs();
-  handleStatusLED();
+  yield();               loopStage(LOOP_STAGE_SYS);
+  handleWs();            loopStage(LOOP_STAGE_WS);
+  handleStatusLED();     loopStage(LOOP_STAGE_STATUSLED);
 
 // DEBUG serial logging (every 30s)
 #ifdef WLED_DEBUG
@@ -278,6 +323,9 @@ void WLED::loop()
 
 void WLED::setup()
 {
+  #ifdef ARDUINO_ARCH_ESP32
+  strip.initRenderLock(); //before the network tasks start, they change segments too
+  #endif
   #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_DISABLE_BROWNOUT_DET)
   WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 0); //disable brownout detection
   #endif
@@ -333,7 +381,10 @@ void WLED::setup()
   if (!fsinit) {
     DEBUGFS_PRINTLN(F("FS failed!"));
     errorFlag = ERR_FS_BEGIN;
-  } else deEEP();
+  } else {
+    recoverPresetsFile();
+    deEEP();
+  }
   updateFSInfo();
 
   DEBUG_PRINTLN(F("Reading config"));
@@ -410,6 +461,16 @@ void WLED::setup()
   if (Serial.available() > 0 && Serial.peek() == 'I') handleImprovPacket();
   // HTTP server page init
   initServer();
+  resetLoopPerf();
+
+  #ifdef WLED_ENABLE_RENDER_TASK
+  #ifdef WLED_RENDER_TASK_CORE
+  BaseType_t renderCore = WLED_RENDER_TASK_CORE;
+  #else
+  BaseType_t renderCore = (portNUM_PROCESSORS > 1 && xPortGetCoreID() == 0) ? 1 : 0; //the core loop() does not run on
+  #endif
+  xTaskCreatePinnedToCore(renderTask, "render", WLED_RENDER_TASK_STACK, nullptr, WLED_RENDER_TASK_PRIORITY, nullptr, renderCore);
+  #endif
 
   #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_DISABLE_BROWNOUT_DET)
   WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 1); //enable brownout detector
@@ -664,6 +725,7 @@ void WLED::initInterfaces()
       udpRgbConnected = rgbUdp.begin(udpRgbPort);
     if (udpConnected && udpPort2 != udpPort && udpPort2 != udpRgbPort)
       udp2Connected = notifier2Udp.begin(udpPort2);
+    joinSyncGroups(true);
   }
   if (ntpEnabled)
     ntpConnected = ntpUdp.begin(ntpLocalPort);
@@ -35,6 +35,9 @@
 #define WLED_ENABLE_ADALIGHT     // saves 500b only (uses GPIO3 (RX) for serial)
 //#define WLED_ENABLE_DMX          // uses 3.5kb (use LEDPIN other than 2)
 //#define WLED_ENABLE_JSONLIVE     // peek LED output via /json/live (WS binary peek is always enabled)
+//#define WLED_ENABLE_FX_BENCHMARK // render every effect into RAM at several lengths and write ns/pixel and heap usage to /fxbench.json, or record/verify golden frame hashes (JSON API "fxbench")
+//#define WLED_USE_SEGMENT_BUFFER  // effects render into a per-segment RGBW buffer that is written to the busses once per frame, uses 4 bytes RAM per LED
+//#define WLED_ENABLE_RENDER_TASK  // ESP32 only: render effects in a FreeRTOS task on the core loop() does not use (or WLED_RENDER_TASK_CORE) instead of in loop()
 #ifndef WLED_DISABLE_LOXONE
   #define WLED_ENABLE_LOXONE       // uses 1.2kb
 #endif
@@ -42,6 +45,10 @@
   #define WLED_ENABLE_WEBSOCKETS
 #endif
 
+#if defined(WLED_ENABLE_RENDER_TASK) && !defined(ARDUINO_ARCH_ESP32)
+  #undef WLED_ENABLE_RENDER_TASK   // needs FreeRTOS and a second core
+#endif
+
 #define WLED_ENABLE_FS_EDITOR      // enable /edit page for editing FS content. Will also be disabled with OTA lock
 
 // to toggle usb serial debug (un)comment the following line
@@ -277,6 +284,7 @@ WLED_GLOBAL bool noWifiSleep _INIT(false);
 // LED CONFIG
 WLED_GLOBAL bool turnOnAtBoot _INIT(true);                // turn on LEDs at power-up
 WLED_GLOBAL byte bootPreset   _INIT(0);                   // save preset to load after power-up
+WLED_GLOBAL uint32_t presetCacheSize _INIT(PRESET_CACHE_SIZE); // bytes of RAM to keep recently applied presets in, 0 to disable (see preset_cache.cpp)
 
 //if true, a segment per bus will be created on boot and LED settings save
 //if false, only one segment spanning the total LEDs is created,
@@ -305,6 +313,7 @@ WLED_GLOBAL bool syncToggleReceive     _INIT(false);   // UIs which only have a
 WLED_GLOBAL NodesMap Nodes;
 WLED_GLOBAL bool nodeListEnabled _INIT(true);
 WLED_GLOBAL bool nodeBroadcastEnabled _INIT(true);
+WLED_GLOBAL bool nodeTimeSync _INIT(false);     // align effect time and system time with other nodes (see timesync.cpp)
 
 WLED_GLOBAL byte buttonType[WLED_MAX_BUTTONS]  _INIT({BTN_TYPE_PUSH});
 #if defined(IRTYPE) && defined(IRPIN)
@@ -320,6 +329,7 @@ WLED_GLOBAL uint16_t udpRgbPort _INIT(19446); // Hyperion port
 
 WLED_GLOBAL uint8_t syncGroups    _INIT(0x01);                    // sync groups this instance syncs (bit mapped)
 WLED_GLOBAL uint8_t receiveGroups _INIT(0x01);                    // sync receive groups this instance belongs to (bit mapped)
+WLED_GLOBAL bool syncMulticast    _INIT(false);                    // send notifications to a multicast group per sync group (239.192.87.1-8) and join the groups received, instead of broadcast
 WLED_GLOBAL bool receiveNotificationBrightness _INIT(true);       // apply brightness from incoming notifications
 WLED_GLOBAL bool receiveNotificationColor      _INIT(true);       // apply color
 WLED_GLOBAL bool receiveNotificationEffects    _INIT(true);       // apply effects setup
@@ -331,6 +341,7 @@ WLED_GLOBAL bool notifyAlexa    _INIT(false);                       // send noti
 WLED_GLOBAL bool notifyMacro    _INIT(false);                       // send notification for macro
 WLED_GLOBAL bool notifyHue      _INIT(true);                        // send notification if Hue light changes
 WLED_GLOBAL bool notifyTwice    _INIT(false);                       // notifications use UDP: enable if devices don't sync reliably
+WLED_GLOBAL bool syncDelta      _INIT(false);                       // send compact delta sync packets with only changed segment fields (not understood by older WLED versions)
 WLED_GLOBAL bool notifyHomeKit  _INIT(false);                       // send notification if updated via homekit
 
 WLED_GLOBAL bool alexaEnabled _INIT(false);                       // enable device discovery by Amazon Echo
@@ -344,6 +355,7 @@ WLED_GLOBAL uint16_t blynkPort _INIT(80);                         // Default Bly
 
 WLED_GLOBAL uint16_t realtimeTimeoutMs _INIT(2500);               // ms timeout of realtime mode before returning to normal mode
 WLED_GLOBAL int arlsOffset _INIT(0);                              // realtime LED offset
+WLED_GLOBAL byte realtimeBufferFrames _INIT(0);                   // realtime jitter buffer: frames queued before playback (0 = off, up to RT_BUFFER_MAX_FRAMES)
 WLED_GLOBAL bool receiveDirect _INIT(true);                       // receive UDP realtime
 WLED_GLOBAL bool arlsDisableGammaCorrection _INIT(true);          // activate if gamma correction is handled by the source
 WLED_GLOBAL bool arlsForceMaxBri _INIT(false);                    // enable to force max brightness if source has very dark colors that would be black
@@ -358,8 +370,13 @@ WLED_GLOBAL byte DMXMode _INIT(DMX_MODE_MULTIPLE_RGB);            // DMX mode (s
 WLED_GLOBAL uint16_t DMXAddress _INIT(1);                         // DMX start address of fixture, a.k.a. first Channel [for E1.31 (sACN) protocol]
 WLED_GLOBAL byte DMXOldDimmer _INIT(0);                           // only update brightness on change
 WLED_GLOBAL byte e131LastSequenceNumber[E131_MAX_UNIVERSE_COUNT]; // to detect packet loss
+WLED_GLOBAL uint32_t e131FramesTorn _INIT(0);                     // multi-universe frames shown incomplete (timeout or sync)
+WLED_GLOBAL uint32_t e131FramesLate _INIT(0);                     // universe packets older than the last one received
+WLED_GLOBAL uint32_t e131FramesDropped _INIT(0);                  // multi-universe frames never shown, the next one was complete before loop() showed it
 WLED_GLOBAL bool e131Multicast _INIT(false);                      // multicast or unicast
 WLED_GLOBAL bool e131SkipOutOfSequence _INIT(false);              // freeze instead of flickering
+WLED_GLOBAL byte e131OutPriority _INIT(100);                      // sACN priority of packets sent by E1.31 network busses (0-200)
+WLED_GLOBAL uint16_t e131OutSyncUniverse _INIT(0);                // E1.31/Art-Net network busses: send sACN sync on this universe / ArtSync after each frame (0 = disabled)
 
 WLED_GLOBAL bool mqttEnabled _INIT(false);
 WLED_GLOBAL char mqttDeviceTopic[33] _INIT("");            // main MQTT topic (individual per device, default is wled/mac)
@@ -595,6 +612,8 @@ WLED_GLOBAL uint16_t olen _INIT(0);
 // General filesystem
 WLED_GLOBAL size_t fsBytesUsed _INIT(0);
 WLED_GLOBAL size_t fsBytesTotal _INIT(0);
+WLED_GLOBAL uint32_t presetsWasted _INIT(0);  // whitespace bytes in presets.json (see handlePresetsCompaction())
+WLED_GLOBAL uint16_t presetsHoles _INIT(0);   // runs of whitespace in presets.json
 WLED_GLOBAL unsigned long presetsModifiedTime _INIT(0L);
 WLED_GLOBAL JsonDocument* fileDoc;
 WLED_GLOBAL bool doCloseFile _INIT(false);
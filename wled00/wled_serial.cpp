@@ -110,18 +110,19 @@ void handleSerial()
             return;
           }
           verboseResponse = deserializeState(doc.as<JsonObject>());
+          releaseJSONBufferLock();
           //only send response if TX pin is unused for other purposes
           if (verboseResponse && (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut)) {
-            doc.clear();
-            JsonObject state = doc.createNestedObject("state");
-            serializeState(state);
-            JsonObject info  = doc.createNestedObject("info");
-            serializeInfo(info);
-
-            serializeJson(doc, Serial);
+            byte error = errorFlag;
+            //written into a buffer first, so the segments are not locked while Serial sends it
+            size_t len = measureStreamJson(JSON_STREAM_STATE_INFO, error) + JSON_STREAM_SLACK;
+            uint8_t* buf = (uint8_t*)malloc(len);
+            len = buf ? streamJson(buf, len, JSON_STREAM_STATE_INFO, error) : 0;
+            bool sent = len ? Serial.write(buf, len) == len : streamJson(Serial, JSON_STREAM_STATE_INFO, error); //no memory or state grew: stream directly
+            free(buf);
+            if (sent && errorFlag == error) errorFlag = ERR_NONE;
             Serial.println();
           }
-          releaseJSONBufferLock();
         }
         break;
       case AdaState::Header_d:
@@ -24,7 +24,11 @@ void handleUpload(AsyncWebServerRequest *request, const String& filename, size_t
     request->_tempFile = WLED_FS.open(filename, "w");
     DEBUG_PRINT("Uploading ");
     DEBUG_PRINTLN(filename);
-    if (filename == "/presets.json") presetsModifiedTime = toki.second();
+    if (filename == "/presets.json") {
+      presetsModifiedTime = toki.second();
+      invalidatePresetIndex();
+      invalidatePresetCache(0);
+    }
   }
   if (len) {
     request->_tempFile.write(data,len);
@@ -129,7 +133,10 @@ void initServer()
         #endif
         verboseResponse = deserializeState(root);
       } else {
+        strip.lockRender();
         verboseResponse = deserializeConfig(root); //use verboseResponse to determine whether cfg change should be saved immediately
+        strip.unlockRender();
+        joinSyncGroups(); //multicast and receive groups may have changed
       }
       releaseJSONBufferLock();
     }
@@ -7,9 +7,14 @@
 
 uint16_t wsLiveClientId = 0;
 unsigned long wsLastLiveTime = 0;
+uint16_t wsPerfClientId = 0;
+unsigned long wsLastPerfTime = 0;
+uint16_t wsRtStatsClientId = 0;
+unsigned long wsLastRtStatsTime = 0;
 //uint8_t* wsFrameBuffer = nullptr;
 
 #define WS_LIVE_INTERVAL 40
+#define WS_PERF_INTERVAL 1000
 
 void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventType type, void * arg, uint8_t *data, size_t len)
 {
@@ -19,6 +24,8 @@ void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventTyp
   } else if(type == WS_EVT_DISCONNECT){
     //client disconnected
     if (client->id() == wsLiveClientId) wsLiveClientId = 0;
+    if (client->id() == wsPerfClientId) wsPerfClientId = 0;
+    if (client->id() == wsRtStatsClientId) wsRtStatsClientId = 0;
   } else if(type == WS_EVT_DATA){
     //data packet
     AwsFrameInfo * info = (AwsFrameInfo*)arg;
@@ -52,6 +59,14 @@ void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventTyp
           } else if (root.containsKey("lv"))
           {
             wsLiveClientId = root["lv"] ? client->id() : 0;
+          } else if (root.containsKey("pf"))
+          {
+            //"{"pf":true}" streams render times ("perf" object of info) to this client
+            wsPerfClientId = root["pf"] ? client->id() : 0;
+          } else if (root.containsKey("rt"))
+          {
+            //"{"rt":true}" streams realtime input telemetry as binary message to this client
+            wsRtStatsClientId = root["rt"] ? client->id() : 0;
           } else {
             verboseResponse = deserializeState(root);
             if (!interfaceUpdateCallMode) {
@@ -97,34 +112,72 @@ void sendDataWs(AsyncWebSocketClient * client)
   if (!ws.count()) return;
   AsyncWebSocketMessageBuffer * buffer;
 
+  //written directly into the message, without the JSON buffer (json_stream.cpp)
+  byte error = errorFlag;
+  size_t len = measureStreamJson(JSON_STREAM_STATE_INFO | JSON_STREAM_NO_STATS, error);
+  if (!len) return;
+  len += JSON_STREAM_SLACK; //padded with spaces
+  size_t heap1 = ESP.getFreeHeap();
+  buffer = ws.makeBuffer(len); // will not allocate correct memory sometimes
+  size_t heap2 = ESP.getFreeHeap();
+  if (!buffer || heap1-heap2<len) {
+    ws.closeAll(1013); //code 1013 = temporary overload, try again later
+    ws.cleanupClients(0); //disconnect all clients to release memory
+    return; //out of memory
+  }
+  size_t written = streamJson(buffer->get(), len, JSON_STREAM_STATE_INFO | JSON_STREAM_NO_STATS, error);
+  if (!written) {
+    //state grew since it was measured, the unused buffer is freed by the library (_cleanBuffers())
+    if (!interfaceUpdateCallMode) interfaceUpdateCallMode = CALL_MODE_WS_SEND; //try again shortly
+    return;
+  }
+  memset(buffer->get() + written, ' ', len - written); //the message has the buffer length, trailing whitespace is valid JSON
+  if (errorFlag == error) errorFlag = ERR_NONE; //prevent error message to persist on screen
+  if (client) {
+    client->text(buffer);
+  } else {
+    ws.textAll(buffer);
+  }
+}
+
+bool sendPerfWs(uint32_t wsClient)
+{
+  AsyncWebSocketClient * wsc = ws.client(wsClient);
+  if (!wsc || wsc->queueLength() > 0) return false; //only send if queue free
+  AsyncWebSocketMessageBuffer * buffer;
+
   { //scope JsonDocument so it releases its buffer
     #ifdef WLED_USE_DYNAMIC_JSON
     DynamicJsonDocument doc(JSON_BUFFER_SIZE);
     #else
-    if (!requestJSONBufferLock(12)) return;
+    if (!requestJSONBufferLock(23)) return false;
     #endif
-    JsonObject state = doc.createNestedObject("state");
-    serializeState(state);
-    JsonObject info  = doc.createNestedObject("info");
-    serializeInfo(info);
+    JsonObject perf = doc.createNestedObject("perf");
+    serializePerf(perf);
     size_t len = measureJson(doc);
-    size_t heap1 = ESP.getFreeHeap();
-    buffer = ws.makeBuffer(len); // will not allocate correct memory sometimes
-    size_t heap2 = ESP.getFreeHeap();
-    if (!buffer || heap1-heap2<len) {
+    buffer = ws.makeBuffer(len);
+    if (!buffer) {
       releaseJSONBufferLock();
-      ws.closeAll(1013); //code 1013 = temporary overload, try again later
-      ws.cleanupClients(0); //disconnect all clients to release memory
-      return; //out of memory
+      return false; //out of memory
     }
     serializeJson(doc, (char *)buffer->get(), len +1);
     releaseJSONBufferLock();
-  } 
-  if (client) {
-    client->text(buffer);
-  } else {
-    ws.textAll(buffer);
   }
+  wsc->text(buffer);
+  return true;
+}
+
+bool sendRealtimeStatsWs(uint32_t wsClient)
+{
+  AsyncWebSocketClient * wsc = ws.client(wsClient);
+  if (!wsc || wsc->queueLength() > 0) return false; //only send if queue free
+
+  size_t len = writeRealtimeStats(nullptr, 0);
+  AsyncWebSocketMessageBuffer * wsBuf = ws.makeBuffer(len);
+  if (!wsBuf) return false; //out of memory
+  writeRealtimeStats(wsBuf->get(), len); //entries added since measuring are left out
+  wsc->binary(wsBuf);
+  return true;
 }
 
 #define MAX_LIVE_LEDS_WS 256
@@ -170,6 +223,14 @@ void handleWs()
     wsLastLiveTime = millis();
     if (!success) wsLastLiveTime -= 20; //try again in 20ms if failed due to non-empty WS queue
   }
+  if (wsPerfClientId && millis() - wsLastPerfTime > WS_PERF_INTERVAL)
+  {
+    if (sendPerfWs(wsPerfClientId)) wsLastPerfTime = millis();
+  }
+  if (wsRtStatsClientId && millis() - wsLastRtStatsTime > WS_PERF_INTERVAL)
+  {
+    if (sendRealtimeStatsWs(wsRtStatsClientId)) wsLastRtStatsTime = millis();
+  }
 }
 
 #else
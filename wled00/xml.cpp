@@ -397,6 +397,7 @@ void getSettingsJS(byte subPage, char* dest)
       char cv[4] = "CV"; cv[2] = 48+s; cv[3] = 0; //strip reverse
       char sl[4] = "SL"; sl[2] = 48+s; sl[3] = 0; //skip 1st LED
       char rf[4] = "RF"; rf[2] = 48+s; rf[3] = 0; //off refresh
+      char lu[4] = "LU"; lu[2] = 48+s; lu[3] = 0; //first E1.31/ArtNet universe
       oappend(SET_F("addLEDs(1);"));
       uint8_t pins[5];
       uint8_t nPins = bus->getPins(pins);
@@ -411,6 +412,10 @@ void getSettingsJS(byte subPage, char* dest)
       sappend('c',cv,bus->reversed);
       sappend('c',sl,bus->skippedLeds());
       sappend('c',rf,bus->isOffRefreshRequired());
+      if (bus->getType() == TYPE_NET_E131_RGB || bus->getType() == TYPE_NET_ARTNET_RGB) {
+        oappend(SET_F("if(d.Sf.")); oappend(lu); oappend(")"); //pages built before LU<n> have no such field
+        sappend('v',lu,bus->getUniverse());
+      }
     }
     sappend('v',SET_F("MA"),strip.ablMilliampsMax);
     sappend('v',SET_F("LA"),strip.milliampsPerLed);
@@ -439,6 +444,7 @@ void getSettingsJS(byte subPage, char* dest)
 
     sappend('c',SET_F("BO"),turnOnAtBoot);
     sappend('v',SET_F("BP"),bootPreset);
+    sappend('v',SET_F("PC"),presetCacheSize);
 
     sappend('c',SET_F("GB"),strip.gammaCorrectBri);
     sappend('c',SET_F("GC"),strip.gammaCorrectCol);
@@ -477,6 +483,7 @@ void getSettingsJS(byte subPage, char* dest)
     sappend('v',SET_F("U2"),udpPort2);
     sappend('v',SET_F("GS"),syncGroups);
     sappend('v',SET_F("GR"),receiveGroups);
+    sappend('c',SET_F("UM"),syncMulticast);
 
     sappend('c',SET_F("RB"),receiveNotificationBrightness);
     sappend('c',SET_F("RC"),receiveNotificationColor);
@@ -488,9 +495,11 @@ void getSettingsJS(byte subPage, char* dest)
     sappend('c',SET_F("SH"),notifyHue);
     sappend('c',SET_F("SM"),notifyMacro);
     sappend('c',SET_F("S2"),notifyTwice);
+    sappend('c',SET_F("DL"),syncDelta);
 
     sappend('c',SET_F("NL"),nodeListEnabled);
     sappend('c',SET_F("NB"),nodeBroadcastEnabled);
+    sappend('c',SET_F("TS"),nodeTimeSync);
 
     sappend('c',SET_F("RD"),receiveDirect);
     sappend('v',SET_F("EP"),e131Port);
@@ -503,6 +512,7 @@ void getSettingsJS(byte subPage, char* dest)
     sappend('c',SET_F("FB"),arlsForceMaxBri);
     sappend('c',SET_F("RG"),arlsDisableGammaCorrection);
     sappend('v',SET_F("WO"),arlsOffset);
+    sappend('v',SET_F("JB"),realtimeBufferFrames);
     sappend('c',SET_F("AL"),alexaEnabled);
     sappends('s',SET_F("AI"),alexaInvocationName);
     sappend('c',SET_F("SA"),notifyAlexa);